@@ -0,0 +1,26 @@
+#!/bin/sh
+# ------------------------------------------------------------------------------------------------------------------
+#  Nightly benchmark for machines without a display. Runs GLBase.exe under Wine (inside a virtual X server if there
+#  is no display) with /benchmark once per scene and writes one JSON file per scene into the results directory
+#  (default Results). Put Mesa's opengl32.dll next to GLBase.exe to measure its llvmpipe software renderer.
+#
+#  Usage: Benchmark.sh [results directory] [path to GLBase.exe]
+#  Note:  any other options, e.g. FRAMES=5000 SIZE=1920x1080, are taken from the environment
+# ------------------------------------------------------------------------------------------------------------------
+
+RESULTS=${1:-Results}
+PROGRAM=${2:-$(dirname "$0")/../Binary/x64/Release/GLBase.exe}
+FRAMES=${FRAMES:-1000}
+WARMUP=${WARMUP:-60}
+SIZE=${SIZE:-1280x720}
+
+mkdir -p "$RESULTS" || exit 1
+
+# wine waits for a windows subsystem program to finish, so the runs never overlap
+RUN="wine"
+if [ -z "$DISPLAY" ]; then RUN="xvfb-run -a wine"; fi
+
+for SCENE in triforce field scatter; do
+    echo "Benchmarking the $SCENE scene..."
+    $RUN "$PROGRAM" /benchmark="$RESULTS/$SCENE.json" /frames=$FRAMES /warmup=$WARMUP /size=$SIZE /scene=$SCENE /instances=10000 || exit 1
+done
@@ -0,0 +1,25 @@
+@echo off
+rem ------------------------------------------------------------------------------------------------------------------
+rem  Headless context scaling benchmark. Renders the field of triforces offscreen on 1 up to 16 render threads at once,
+rem  each with its own context, and appends one line per run to a CSV file (default Contexts.csv), so the combined
+rem  frame rates can be compared side by side.
+rem
+rem  Usage: Contexts.cmd [results file] [path to GLBase.exe]
+rem  Note:  the results path must not contain spaces, it's passed on the command line as /results=<path>
+rem ------------------------------------------------------------------------------------------------------------------
+
+setlocal
+
+set RESULTS=%~1
+set PROGRAM=%~2
+
+if "%RESULTS%"=="" set RESULTS=Contexts.csv
+if "%PROGRAM%"=="" set PROGRAM=%~dp0..\Binary\x64\Release\GLBase.exe
+
+rem the app is a windows subsystem program, so wait for each run to finish before starting the next
+for %%n in (1 2 4 8 16) do (
+    echo Rendering on %%n threads...
+    start "" /wait "%PROGRAM%" /offscreen=1280x720 /frames=500 /scene=field /instances=10000 /threads=%%n /results=%RESULTS%
+)
+
+endlocal
@@ -0,0 +1,24 @@
+@echo off
+rem ------------------------------------------------------------------------------------------------------------------
+rem  Headless instancing benchmark. Renders the field of triforces offscreen with 3 up to 1,000,000 instances and
+rem  appends one line per run to a CSV file (default Instancing.csv), so the frame rates can be compared side by side.
+rem
+rem  Usage: Instancing.cmd [results file] [path to GLBase.exe]
+rem  Note:  the results path must not contain spaces, it's passed on the command line as /results=<path>
+rem ------------------------------------------------------------------------------------------------------------------
+
+setlocal
+
+set RESULTS=%~1
+set PROGRAM=%~2
+
+if "%RESULTS%"=="" set RESULTS=Instancing.csv
+if "%PROGRAM%"=="" set PROGRAM=%~dp0..\Binary\x64\Release\GLBase.exe
+
+rem the app is a windows subsystem program, so wait for each run to finish before starting the next
+for %%n in (3 10 100 1000 10000 100000 1000000) do (
+    echo Rendering %%n instances...
+    start "" /wait "%PROGRAM%" /offscreen=1280x720 /frames=500 /scene=field /instances=%%n /results=%RESULTS%
+)
+
+endlocal
@@ -0,0 +1,25 @@
+@echo off
+rem ------------------------------------------------------------------------------------------------------------------
+rem  Vector math microbenchmark. Times the batch matrix and vector transforms with the scalar, SSE and AVX kernels
+rem  (whichever the CPU supports) on 10,000 up to 1,000,000 matrices and appends the results to a CSV file (default
+rem  VecMath.csv). No window is created, each run closes by itself when it's done.
+rem
+rem  Usage: VecMath.cmd [results file] [path to GLBase.exe]
+rem  Note:  the results path must not contain spaces, it's passed on the command line as /results=<path>
+rem ------------------------------------------------------------------------------------------------------------------
+
+setlocal
+
+set RESULTS=%~1
+set PROGRAM=%~2
+
+if "%RESULTS%"=="" set RESULTS=VecMath.csv
+if "%PROGRAM%"=="" set PROGRAM=%~dp0..\Binary\x64\Release\GLBase.exe
+
+rem the app is a windows subsystem program, so wait for each run to finish before starting the next
+for %%n in (10000 100000 1000000) do (
+    echo Transforming %%n matrices...
+    start "" /wait "%PROGRAM%" /mathbench=%%n /results=%RESULTS%
+)
+
+endlocal
@@ -1,6 +1,9 @@
 #include "Main\Application.h"    // standard application include
+#include "Main\Benchmark.h"      // microbenchmark routines
 #include "Main\Render.h"         // main rendering routines
+#include "Main\Capture.h"        // frame capture and replay routines
 #include "Utility\General.h"     // general utility routines
+#include "Utility\Mesh.h"        // binary mesh routines
 #include <VersionHelpers.h>      // used to determine OS version
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,14 +52,19 @@
 
 // local variables
 static bool _bGoFullscreen = false;
-static unsigned int _nRenderThreadID = 0;
-static HANDLE _hRenderThread = NULL;
+static bool _bGoOffscreen = false;
+static bool _bBenchmark = false;
+static HANDLE _ahRenderThreads[CONFIG_MAX_CONTEXTS];
+static UINT _nRenderThreads = 0;
+static SCENE _nScene = SCENE_TRIFORCE;
+static bool _bVSync = true;
 
 // local prototypes
 static LRESULT CALLBACK __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 static bool __goFullscreen        (HWND hWnd, unsigned int nWidth, unsigned int nHeight, BYTE nBits, BYTE nRefresh);
 static void __goWindowed          (void);
 static bool __procStartOptions    (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex);
+static void __postCommand         (RENDERCMD nCommand, UINT nParam1, UINT nParam2);
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -79,7 +87,9 @@ WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmd
     RECT        rcWndPos = {0};     // position to use when creating the main app window
     HANDLE      hMutex = NULL;      // handle to the single instance mutex
     MSG         msg = {0};          // message structure for the queue
-    RENDERARGS  args = {0};         // arguments to be passed to the render thread
+    RENDERARGS  args = {0};         // arguments to be passed to the (first) render thread
+    PRENDERARGS pExtra = NULL;      // arguments of the render threads after the first (if there are any)
+    HWND        ahContexts[CONFIG_MAX_CONTEXTS] = {0};  // hidden windows the render threads after the first draw with
 
     // process independent startup options, if returns false then exit the app
     if(__procStartOptions(&args, &rcWndPos, &hMutex))
@@ -136,6 +146,7 @@ WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmd
         else
         {
             PIXELFORMATDESCRIPTOR pfd = {0};    // pixel descriptor structure
+            UINT i = 0;                         // index of the render thread being started
             int nFormat = 0;                    // index of the closest matching pixel format provided by the system
             HICON hIcon = NULL;                 // handle to the main window's large icon
             HICON hIconSmall = NULL;            // handle to the main window's small icon
@@ -206,9 +217,60 @@ WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmd
                 args.hWnd = hWnd;
                 args.hDC = hDC;
 
-                // initialize the rendering context in a separate thread (do not use CreateThread()
-                // to avoid leaks caused by the CRT when trying to use standard CRT libs)
-                _hRenderThread = (HANDLE)_beginthreadex(NULL, 0, RenderMain, &args, 0, &_nRenderThreadID);
+                // keep track of what can be switched while running, so we know what to switch to
+                _nScene = args.nScene;
+                _bVSync = (args.bVSync != no);
+
+                // a headless run may draw on several render threads at once, every one after the first creates its
+                // context on a hidden window of its own with the same pixel format, so no two threads share a DC
+                if(args.nContexts > 1)
+                {
+                    WNDCLASS wcContext = {0};
+
+                    wcContext.style         = CS_OWNDC;
+                    wcContext.lpfnWndProc   = DefWindowProc;
+                    wcContext.hInstance     = hInstance;
+                    wcContext.lpszClassName = CONTEXT_CLASS;
+
+                    RegisterClass(&wcContext);
+                    pExtra = (PRENDERARGS)calloc(args.nContexts - 1, sizeof(RENDERARGS));
+                }
+
+                // initialize the rendering contexts in separate threads (do not use CreateThread()
+                // to avoid leaks caused by the CRT when trying to use standard CRT libs), they start
+                // out suspended so they can all be told how many of them actually got started
+                for(i = 0; i < args.nContexts; i++)
+                {
+                    PRENDERARGS pArgs = &args;
+
+                    if(i > 0)
+                    {
+                        if(pExtra == NULL) break;
+
+                        pArgs = &pExtra[i - 1];
+                        *pArgs = args;
+
+                        ahContexts[i] = CreateWindow(CONTEXT_CLASS, APP_NAME, WS_POPUP, 0, 0, 1, 1, NULL, NULL, hInstance, NULL);
+                        if(ahContexts[i] == NULL) break;
+
+                        pArgs->hDC = GetDC(ahContexts[i]);
+                        if(!SetPixelFormat(pArgs->hDC, nFormat, &pfd)) break;
+                    }
+
+                    pArgs->nContext = i;
+                    _ahRenderThreads[i] = (HANDLE)_beginthreadex(NULL, 0, RenderMain, pArgs, CREATE_SUSPENDED, NULL);
+                    if(_ahRenderThreads[i] == NULL) break;
+
+                    _nRenderThreads++;
+                }
+
+                for(i = 0; i < _nRenderThreads; i++)
+                {
+                    if(i == 0) args.nContexts = _nRenderThreads;
+                    else pExtra[i - 1].nContexts = _nRenderThreads;
+
+                    ResumeThread(_ahRenderThreads[i]);
+                }
 
                 /*/
                 / / WARNING: If you do not use a separate thread for rendering, it is imperative that
@@ -228,11 +290,20 @@ WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmd
                     }
                 }
 
-                // we're done, destroy the render thread
-                if(_hRenderThread != NULL) CloseHandle(_hRenderThread);
+                // we're done, destroy the render threads
+                for(i = 0; i < _nRenderThreads; i++) CloseHandle(_ahRenderThreads[i]);
             }
 
             // clean-up (windows specific items)
+            for(i = 1; i < CONFIG_MAX_CONTEXTS; i++)
+            {
+                if(ahContexts[i] == NULL) continue;
+
+                ReleaseDC(ahContexts[i], pExtra[i - 1].hDC);
+                DestroyWindow(ahContexts[i]);
+            }
+
+            if(pExtra != NULL) free(pExtra);
             ReleaseDC(hWnd, hDC);
 
             if(_bGoFullscreen) __goWindowed();
@@ -296,7 +367,8 @@ __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
             // before the main window is destroyed, save it's position (and width/height) if in windowed mode
             // WARNING: do not perform this operation if the main window is closed in a maxed or mined state
-            if(!_bGoFullscreen)
+            // the window is never shown when rendering offscreen, so there is nothing worth saving then
+            if(!_bGoFullscreen && !_bGoOffscreen)
             {
                 if(!IsIconic(hWnd))
                 {
@@ -338,12 +410,12 @@ __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 }
             }
 
-            // we need to shutdown the render thread, so we signal it to stop
-            // to play nice, let it finish before proceeding (up to 5 seconds)
-            if((_hRenderThread) != NULL && (_nRenderThreadID > 0))
+            // we need to shutdown the render threads, so we signal them to stop
+            // to play nice, let them finish before proceeding (up to 5 seconds)
+            if(_nRenderThreads > 0)
             {
-                PostThreadMessage(_nRenderThreadID, UWM_STOP, 0, 0);
-                WaitForSingleObject(_hRenderThread, 5000);
+                __postCommand(RENDER_STOP, 0, 0);
+                WaitForMultipleObjects(_nRenderThreads, _ahRenderThreads, TRUE, 5000);
             }
 
             // destroy this window and thus the app as requested
@@ -360,14 +432,14 @@ __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
             // NOTE: always leave this whether or not the app has a menu! (remember the system menu)
             // to suspend the render thread if the user is navigating menus (if not minimized)
-            if(!IsIconic(hWnd)) PostThreadMessage(_nRenderThreadID, UWM_PAUSE, true, 0);
+            if(!IsIconic(hWnd)) __postCommand(RENDER_PAUSE, true, 0);
             break;
 
         case WM_EXITMENULOOP:
 
             // NOTE: always leave this whether or not the app has a menu! (remember the system menu)
             // to start the render thread back up if the user leaves the menu (if not minimized)
-            if(!IsIconic(hWnd)) PostThreadMessage(_nRenderThreadID, UWM_PAUSE, false, 0);
+            if(!IsIconic(hWnd)) __postCommand(RENDER_PAUSE, false, 0);
             break;
 
         case WM_GETMINMAXINFO:
@@ -388,6 +460,22 @@ __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
             switch(wParam)
             {
+                case VK_TAB:
+
+                    // switch the render thread over to the next scene
+                    _nScene = (SCENE)((_nScene + 1) % SCENE_COUNT);
+                    __postCommand(RENDER_SCENE, _nScene, 0);
+                    break;
+
+                #if CONFIG_ALLOW_VSYNC
+                case 'V':
+
+                    // turn vsync on or off
+                    _bVSync = !_bVSync;
+                    __postCommand(RENDER_VSYNC, _bVSync, 0);
+                    break;
+                #endif
+
                 case VK_ESCAPE:
 
                     // if we are in fullscreen mode only
@@ -445,19 +533,20 @@ __wndProc (HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
                     // play nice and don't hog the computer if the main window is minimized
                     #if CONFIG_PAUSE_MINIMIZED
-                        PostThreadMessage(_nRenderThreadID, UWM_PAUSE, true, 0);
+                        __postCommand(RENDER_PAUSE, true, 0);
                     #endif
                     break;
 
+                case SIZE_MAXIMIZED:
                 case SIZE_RESTORED:
 
                     // we need to resize the view port for OGL, but it must be done in the context of
-                    // the render thread, so set the signal to be picked up by the render thread
-                    PostThreadMessage(_nRenderThreadID, UWM_RESIZE, 0, 0);
+                    // the render thread, so send it the new size of the client area to pick up
+                    __postCommand(RENDER_RESIZE, LOWORD(lParam), HIWORD(lParam));
 
                     // we're back in action, so let the threads continue
                     #if (CONFIG_PAUSE_MINIMIZED == TRUE)
-                        PostThreadMessage(_nRenderThreadID, UWM_PAUSE, false, 0);
+                        __postCommand(RENDER_PAUSE, false, 0);
                     #endif
                     break;
             }
@@ -543,6 +632,9 @@ static bool
 __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
 {
     bool bReturn = true;
+    TCHAR szBench[MAX_LOADSTRING] = {0};
+    TCHAR szConvert[MAX_PATH] = {0};
+    TCHAR szBenchmark[MAX_PATH] = {0};
 
     // first and foremost, make sure the host OS meets our requirements
     // and, let's hope and pray you don't support anything below XP
@@ -551,9 +643,47 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
         ResourceMessage(NULL, IDS_ERR_WINVER, 0, MB_OK|MB_ICONERROR);
         bReturn = false;
     }
+    else if(GetCmdLineValue(_T("mathbench"), szBench, STRING_SIZE(szBench)))
+    {
+        TCHAR szResults[MAX_PATH] = {0};
+        unsigned int nCount = _tcstoul(szBench, NULL, 10);
+
+        // time the vector math kernels on that many matrices (default a million), e.g. /mathbench=100000
+        // the results are appended to the file given by /results, or VecMath.csv if there isn't one
+        if(!GetCmdLineValue(_T("results"), szResults, STRING_SIZE(szResults)))
+            _tcscpy_s(szResults, STRING_SIZE(szResults), _T("VecMath.csv"));
+
+        RunMathBenchmark((nCount == 0) ? 1000000 : nCount, szResults);
+
+        // there is nothing to show, so the app closes as soon as the benchmark is done
+        bReturn = false;
+    }
+    else if(GetCmdLineValue(_T("convert"), szConvert, STRING_SIZE(szConvert)))
+    {
+        TCHAR szMesh[MAX_PATH] = {0};
+
+        // turn a Wavefront OBJ file into a binary mesh the model scene can map, e.g. /convert=Ship.obj
+        // it's written to the file given by /mesh, or next to the source with a .mesh extension if there isn't one
+        if(!GetCmdLineValue(_T("mesh"), szMesh, STRING_SIZE(szMesh)))
+        {
+            LPCTSTR szExtension = _tcsrchr(szConvert, _T('.'));
+
+            if((szExtension == NULL) || (_tcsrchr(szConvert, _T('\\')) > szExtension)) szExtension = szConvert + _tcslen(szConvert);
+            _sntprintf_s(szMesh, STRING_SIZE(szMesh), _TRUNCATE, _T("%.*s.mesh"), (int)(szExtension - szConvert), szConvert);
+        }
+
+        if(!ConvertMesh(szConvert, szMesh)) ResourceMessage(NULL, IDS_ERR_CONVERT, 0, MB_OK|MB_ICONERROR);
+
+        // like the benchmark, there is nothing to show once the file is written
+        bReturn = false;
+    }
     else
     {
-        if(CONFIG_SINGLE_INSTANCE && (pMutex != NULL))
+        // a benchmark, e.g. /benchmark=Results.json, runs unattended and leaves the registry alone, so it may
+        // run next to an instance somebody is using
+        _bBenchmark = GetCmdLineValue(_T("benchmark"), szBenchmark, STRING_SIZE(szBenchmark));
+
+        if(CONFIG_SINGLE_INSTANCE && (pMutex != NULL) && !_bBenchmark)
         {
             *pMutex = CreateMutex(NULL, true, CLASS_NAME);
 
@@ -578,6 +708,165 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
         {
             DWORD dwTemp = 0; // used to pull DWORD values from the registry
 
+            /*/
+            / / Here, we check if we are to render headless. If so, the main window is created but never shown
+            / / and the render thread draws into an offscreen target of the size given, e.g. /offscreen=640x480
+            / / with an optional /frames=1000 to have the app close by itself after rendering that many frames,
+            / / or /seconds=10 after rendering for that long, and /warmup=60 to draw that many frames first
+            / / without measuring them. A benchmark is always headless, its size may be given as /size=640x480.
+            /*/
+            {
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+                bool bHeadless = GetCmdLineValue(_T("offscreen"), szBuff, STRING_SIZE(szBuff));
+
+                if(_bBenchmark && !bHeadless)
+                {
+                    GetCmdLineValue(_T("size"), szBuff, STRING_SIZE(szBuff));
+                    bHeadless = true;
+                }
+
+                if(bHeadless)
+                {
+                    LPTSTR szHeight = NULL;
+
+                    // the size is given as WIDTHxHEIGHT, anything missing or bogus reverts to the defaults
+                    pArgs->nWidth = _tcstoul(szBuff, &szHeight, 10);
+                    pArgs->nHeight = ((szHeight != NULL) && ((*szHeight == _T('x')) || (*szHeight == _T('X')))) ?
+                        _tcstoul(_tcsinc(szHeight), NULL, 10) : 0;
+
+                    if(pArgs->nWidth == 0) pArgs->nWidth = CONFIG_DEF_WIDTH;
+                    if(pArgs->nHeight == 0) pArgs->nHeight = CONFIG_DEF_HEIGHT;
+
+                    pArgs->bOffscreen = _bGoOffscreen = true;
+                }
+
+                szBuff[0] = _T('\0');
+                if(GetCmdLineValue(_T("frames"), szBuff, STRING_SIZE(szBuff)))
+                    pArgs->nFrames = _tcstoul(szBuff, NULL, 10);
+
+                szBuff[0] = _T('\0');
+                if(GetCmdLineValue(_T("seconds"), szBuff, STRING_SIZE(szBuff)))
+                    pArgs->nSeconds = _tcstoul(szBuff, NULL, 10);
+
+                szBuff[0] = _T('\0');
+                pArgs->nWarmup = _bBenchmark ? CONFIG_BENCH_WARMUP : 0;
+                if(GetCmdLineValue(_T("warmup"), szBuff, STRING_SIZE(szBuff)))
+                    pArgs->nWarmup = _tcstoul(szBuff, NULL, 10);
+
+                // a headless run can append its frame rate to a results file, e.g. /results=Field.csv
+                if(_bGoOffscreen) GetCmdLineValue(_T("results"), pArgs->szResults, STRING_SIZE(pArgs->szResults));
+
+                // it may also draw on several render threads at once, e.g. /threads=4, each with a context and a scene
+                // of its own, the results are then of all of them together
+                szBuff[0] = _T('\0');
+                pArgs->nContexts = 1;
+                if(_bGoOffscreen && GetCmdLineValue(_T("threads"), szBuff, STRING_SIZE(szBuff)))
+                {
+                    pArgs->nContexts = _tcstoul(szBuff, NULL, 10);
+                    if(pArgs->nContexts < 1) pArgs->nContexts = 1;
+                    if(pArgs->nContexts > CONFIG_MAX_CONTEXTS) pArgs->nContexts = CONFIG_MAX_CONTEXTS;
+                }
+
+                // a benchmark that isn't told when to stop renders a fixed number of frames, and writes what it
+                // measured as JSON when it's done, to the file given or Benchmark.json if there isn't one
+                if(_bBenchmark)
+                {
+                    if((pArgs->nFrames == 0) && (pArgs->nSeconds == 0)) pArgs->nFrames = CONFIG_BENCH_FRAMES;
+
+                    if(szBenchmark[0] == _T('\0')) _tcscpy_s(szBenchmark, STRING_SIZE(szBenchmark), _T("Benchmark.json"));
+                    _tcscpy_s(pArgs->szBenchmark, STRING_SIZE(pArgs->szBenchmark), szBenchmark);
+                }
+            }
+
+            /*/
+            / / Here, we determine which scene the render thread draws, e.g. /scene=field /instances=10000
+            / / draws a field of ten thousand triforces with instancing. The default is the triforce.
+            /*/
+            {
+                static const LPCTSTR szScenes[] = SCENE_NAMES;
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+                int i = 0;
+
+                pArgs->nScene = SCENE_TRIFORCE;
+                if(GetCmdLineValue(_T("scene"), szBuff, STRING_SIZE(szBuff)))
+                {
+                    for(i = 0; i < SCENE_COUNT; i++)
+                        if(STRING_MATCH(szBuff, szScenes[i])) pArgs->nScene = (SCENE)i;
+                }
+
+                szBuff[0] = _T('\0');
+                if(GetCmdLineValue(_T("instances"), szBuff, STRING_SIZE(szBuff)))
+                    pArgs->nInstances = _tcstoul(szBuff, NULL, 10);
+
+                if(pArgs->nInstances == 0) pArgs->nInstances = 3;
+            }
+
+            // frames are drawn no faster than the target frame rate, e.g. /fps=60 or /fps=0 for no limit
+            // a headless run has no limit unless one is asked for, since it's meant to measure throughput
+            {
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+
+                pArgs->nTargetFPS = _bGoOffscreen ? 0 : CONFIG_TARGET_FPS;
+                if(GetCmdLineValue(_T("fps"), szBuff, STRING_SIZE(szBuff))) pArgs->nTargetFPS = _tcstoul(szBuff, NULL, 10);
+
+                pArgs->nUpdateRate = CONFIG_UPDATE_RATE;
+            }
+
+            // a frame budget in milliseconds, e.g. /budget=16, has frames drawn at a lower resolution and stretched
+            // over the window whenever they take longer than that, /budget=0 always draws them at full size
+            {
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+
+                pArgs->nBudget = CONFIG_FRAME_BUDGET;
+                if(GetCmdLineValue(_T("budget"), szBuff, STRING_SIZE(szBuff))) pArgs->nBudget = _tcstoul(szBuff, NULL, 10);
+            }
+
+            // the frame timings are written to <name>.csv and <name>.json when the render thread ends
+            // e.g. /stats=Timings, the default comes from the config and an empty one writes nothing
+            if(!GetCmdLineValue(_T("stats"), pArgs->szStats, STRING_SIZE(pArgs->szStats)))
+                _tcscpy_s(pArgs->szStats, STRING_SIZE(pArgs->szStats), CONFIG_STATS_FILE);
+
+            // a bitmap drawn behind every scene, e.g. /backdrop=Sky.bmp, it's loaded in the background
+            GetCmdLineValue(_T("backdrop"), pArgs->szBackdrop, STRING_SIZE(pArgs->szBackdrop));
+
+            // the mesh file the model scene draws, e.g. /scene=model /mesh=Ship.mesh (see /convert above)
+            GetCmdLineValue(_T("mesh"), pArgs->szMesh, STRING_SIZE(pArgs->szMesh));
+
+            // primitives are drawn from buffer objects unless the /immediate switch asks for
+            // the immediate mode path, which is kept as a reference to compare performance with
+            {
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+                pArgs->bRetained = (CONFIG_RETAINED_MODE && !GetCmdLineValue(_T("immediate"), szBuff, STRING_SIZE(szBuff))) ? true : false;
+
+                // the /software switch has the triforce drawn on the CPU, the GL only shows the finished image
+                pArgs->bSoftware = GetCmdLineValue(_T("software"), szBuff, STRING_SIZE(szBuff)) ? true : false;
+            }
+
+            /*/
+            / / Here, we check if the frames are to be captured or replayed. A capture, e.g. /capture=Run.cap, keeps
+            / / what every frame drawn depended on. A replay, e.g. /replay=Run.cap, draws those same frames again
+            / / with the scene options the capture was made with, as fast as it can unless /fps is given too.
+            /*/
+            {
+                TCHAR szBuff[MAX_LOADSTRING] = {0};
+
+                GetCmdLineValue(_T("capture"), pArgs->szCapture, STRING_SIZE(pArgs->szCapture));
+
+                if(GetCmdLineValue(_T("replay"), pArgs->szReplay, STRING_SIZE(pArgs->szReplay)))
+                {
+                    if(!LoadReplay(pArgs->szReplay, pArgs))
+                    {
+                        ResourceMessage(NULL, IDS_ERR_REPLAY, 0, MB_OK|MB_ICONERROR);
+                        bReturn = false;
+                    }
+
+                    if(!GetCmdLineValue(_T("fps"), szBuff, STRING_SIZE(szBuff))) pArgs->nTargetFPS = 0;
+                }
+
+                // a capture holds the frames of a single render thread, so it's made and replayed with just the one
+                if((pArgs->szCapture[0] != _T('\0')) || (pArgs->szReplay[0] != _T('\0'))) pArgs->nContexts = 1;
+            }
+
             /*/
             / / Here, we need to determine if this app allows fullscreen mode. If so, do we default to it
             / / or not? If not, then process nothing and stay windowed. If it is allowed, then we need to
@@ -588,7 +877,12 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
                 TCHAR szBuff[MAX_LOADSTRING] = {0};
 
                 // read the command line arguments to see what we should do about fullscreen
-                if(GetCmdLineValue(_T("fullscreen"), szBuff, STRING_SIZE(szBuff)))
+                // there is no display to take over when rendering offscreen, so skip it then
+                if(_bGoOffscreen)
+                {
+                    _bGoFullscreen = false;
+                }
+                else if(GetCmdLineValue(_T("fullscreen"), szBuff, STRING_SIZE(szBuff)))
                 {
                     // any value other than "no" (including no value) is considered a yes
                     if(!STRING_MATCH(szBuff, _T("no"))) _bGoFullscreen = true;
@@ -608,7 +902,8 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
 
             // get the bits per pixel data (if any) from the registry, can only be 8, 16, 24, or 32
             dwTemp = 0;
-            if(!GetUserValue(NULL, _T("BPP"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
+            // a benchmark never reads the registry, so it runs with the same settings wherever it runs
+            if(_bBenchmark || !GetUserValue(NULL, _T("BPP"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
                 pArgs->nBPP = CONFIG_DEF_BPP;
             else
             {
@@ -621,7 +916,7 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
 
             // get the vertical refresh rate data (if any) from the registry, must be between min and max
             dwTemp = 0;
-            if(!GetUserValue(NULL, _T("Refresh"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
+            if(_bBenchmark || !GetUserValue(NULL, _T("Refresh"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
                 pArgs->nRefresh = CONFIG_MIN_REFRESH;
             else
             {
@@ -645,7 +940,7 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
             {
                 // assume vsync is indeterminate if no setting is found
                 dwTemp = 0;
-                if(!GetUserValue(NULL, _T("VSync"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
+                if(_bBenchmark || !GetUserValue(NULL, _T("VSync"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
 
                     // if no option is set, then default to indeterminate
                     pArgs->bVSync = maybe;
@@ -665,7 +960,7 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
 
             // independently test left/top (if not in registry then we center the window later on)
             // if we are in fullscreen mode, always leave these set to zero
-            if(!_bGoFullscreen)
+            if(!_bGoFullscreen && !_bBenchmark)
             {
                 GetUserValue(NULL, _T("Left"), REG_DWORD, &pWndRect->left, sizeof(LONG));
                 GetUserValue(NULL, _T("Top"), REG_DWORD, &pWndRect->top, sizeof(LONG));
@@ -683,8 +978,11 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
             #if CONFIG_ALLOW_RESIZE
             {
                 // if this data doesn't exist or is bogus, we just revert back to the default width/height
-                GetUserValue(NULL, _T("Width"), REG_DWORD, &pWndRect->right, sizeof(LONG));
-                GetUserValue(NULL, _T("Height"), REG_DWORD, &pWndRect->bottom, sizeof(LONG));
+                if(!_bBenchmark)
+                {
+                    GetUserValue(NULL, _T("Width"), REG_DWORD, &pWndRect->right, sizeof(LONG));
+                    GetUserValue(NULL, _T("Height"), REG_DWORD, &pWndRect->bottom, sizeof(LONG));
+                }
 
                 pWndRect->right = (pWndRect->right <= 0) ? CONFIG_DEF_WIDTH : pWndRect->right;
                 pWndRect->bottom = (pWndRect->bottom <= 0) ? CONFIG_DEF_HEIGHT : pWndRect->bottom;
@@ -693,7 +991,7 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
                 {
                     // if we are in windowed mode, get the maximized state so we can restore it if needed
                     dwTemp = 0;
-                    if(!GetUserValue(NULL, _T("Zoom"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
+                    if(_bBenchmark || !GetUserValue(NULL, _T("Zoom"), REG_DWORD, &dwTemp, sizeof(dwTemp)))
                         pArgs->bZoomed = false;
                     else
                         // ensure we are working with proper boolean data
@@ -710,5 +1008,64 @@ __procStartOptions (PRENDERARGS pArgs, PRECT pWndRect, HANDLE *pMutex)
     return bReturn;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nCommand = command to send the render thread
+/ /     nParam1 = first value of the command (bPaused, nScene, bVSync or nWidth depending on the command)
+/ /     nParam2 = second value of the command (nHeight for RENDER_RESIZE, otherwise ignored)
+/ /
+/ / PURPOSE:
+/ /     Fills out a render command and queues it for every render thread.
+/ /
+/ / NOTES:
+/ /     This must only be called from the main thread, the render command queue has one producer.
+/*/
+
+static void
+__postCommand (RENDERCMD nCommand, UINT nParam1, UINT nParam2)
+{
+    RENDERCOMMAND Command = {0};
+    UINT i = 0;
+
+    Command.nCommand = nCommand;
+
+    switch(nCommand)
+    {
+        case RENDER_PAUSE:
+
+            Command.Data.bPaused = (bool)nParam1;
+            break;
+
+        case RENDER_SCENE:
+
+            Command.Data.nScene = (SCENE)nParam1;
+            break;
+
+        case RENDER_VSYNC:
+
+            Command.Data.bVSync = (bool)nParam1;
+            break;
+
+        case RENDER_RESIZE:
+
+            Command.Data.Size.nWidth = nParam1;
+            Command.Data.Size.nHeight = nParam2;
+            break;
+    }
+
+    // a render thread empties its queue every frame, so it can only be full if the render thread is stuck,
+    // a stop request must get through regardless, so keep trying as long as the render thread is alive
+    // note: anything sent before the render threads are started is for the first one, which always starts
+    for(i = 0; (i == 0) || (i < _nRenderThreads); i++)
+    {
+        while(!PostRenderCommand(i, &Command) && (nCommand == RENDER_STOP))
+        {
+            if(WaitForSingleObject(_ahRenderThreads[i], 1) != WAIT_TIMEOUT) break;
+        }
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
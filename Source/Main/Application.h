@@ -38,6 +38,7 @@ typedef enum {no=FALSE, yes=TRUE, maybe=-1} tribool;
 // application constants
 #define APP_NAME        _T("OpenGL Base")                                    // name of the application
 #define CLASS_NAME      _T("GL_BASE_9826C328_598D_4C2E_85D4_0FF8E0310366")   // unique class name of the main window
+#define CONTEXT_CLASS   _T("GL_BASE_CTX_4A17E0B3_9C62_4D8F_B5E1_27F3C8D0")   // class of the hidden windows extra render threads draw with
 #define COMPANY_NAME    _T("Wizkit")                                         // company responsible for this software
 #define MAX_LOADSTRING  256                                                  // max buffer size for simple string data
 
@@ -46,16 +47,31 @@ typedef enum {no=FALSE, yes=TRUE, maybe=-1} tribool;
 #define CONFIG_ALLOW_RESIZE        FALSE         // can the main window to be resized? (windowed only)
 #define CONFIG_ALLOW_MENU          FALSE         // do we have a default menu
 #define CONFIG_ALLOW_VSYNC         FALSE         // do allow the enabling/disabling of vertical sync?
+#define CONFIG_ARENA_FRAMES        3             // frames whose arena memory is kept before it's reused (1 to 3)
+#define CONFIG_ARENA_SIZE          (256 * 1024)  // bytes of arena each job thread starts out with per frame (it grows if need be)
+#define CONFIG_BENCH_FRAMES        1000          // frames a /benchmark run measures if it isn't given /frames or /seconds
+#define CONFIG_BENCH_WARMUP        60            // frames a /benchmark run draws before it starts measuring, unless given /warmup
 #define CONFIG_DEF_BACKGROUND      RGB(0, 0, 0)  // default background color to clear the screen with
 #define CONFIG_DEF_BPP             16            // default bits-per-pixel
 #define CONFIG_DEF_FULLSCREEN      FALSE         // should the app default to fullscreen or windowed
 #define CONFIG_DEF_WIDTH           1024          // default width of the resolution
 #define CONFIG_DEF_HEIGHT          768           // default height of the resolution
+#define CONFIG_FRAME_BUDGET        0             // milliseconds a frame may take before it's drawn at a lower resolution (zero means never)
+#define CONFIG_JOB_WORKERS         0             // number of job worker threads (zero means one per processor but one)
+#define CONFIG_MAX_CONTEXTS        16            // most render threads a headless run can draw on at once (each with its own context)
 #define CONFIG_MAX_REFRESH         120           // default max refresh rate to use for fullscreen mode (in hertz)
 #define CONFIG_MIN_REFRESH         60            // default min refresh rate to use for fullscreen mode (in hertz)
+#define CONFIG_MIN_SCALE           0.5f          // least fraction of the width and height a frame is drawn at to keep to the budget
 #define CONFIG_MIN_WIDTH           0             // minimum width of the main window (zero means no min)
 #define CONFIG_MIN_HEIGHT          0             // minimum height of the main window (zero means no min)
 #define CONFIG_PAUSE_MINIMIZED     TRUE          // do we pause the render when the main window is minimized
+#define CONFIG_RETAINED_MODE       TRUE          // draw primitives from buffer objects rather than immediate mode
+#define CONFIG_SHADER_CACHE        _T("Shaders.bin")  // file linked shader programs are cached in between runs (empty means none)
 #define CONFIG_SINGLE_INSTANCE     TRUE          // do we allow single or multiple instances of the app
+#define CONFIG_STATS_FILE          _T("")        // base name of the frame timing files written on exit (empty means none)
+#define CONFIG_STREAM_SIZE         (16 * 1024 * 1024)  // bytes of the ring vertex data that changes every frame is streamed through
+#define CONFIG_TARGET_FPS          120           // most frames per second to render (zero means no limit, ignored if headless)
+#define CONFIG_UPDATE_RATE         60            // number of fixed steps per second the scene is animated with
+#define CONFIG_UPLOAD_BUDGET       (512 * 1024)  // most bytes of loaded files uploaded to the GL per frame
 
 #endif  // APPLICATION_H
\ No newline at end of file
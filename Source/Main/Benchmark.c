@@ -0,0 +1,163 @@
+#include "Main\Application.h"    // standard application include
+#include "Main\Benchmark.h"      // include for this file
+#include "Utility\Timing.h"      // timing routines
+#include "Utility\VecMath.h"     // vector math routines
+#include <math.h>                // fabs()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////// BENCHMARK ROUTINES /////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// number of times each kernel is timed, the fastest run is kept since anything slower was disturbed by something else
+#define BENCH_RUNS  5
+
+// local function prototypes
+static float __maxError (const float *pA, const float *pB, size_t nFloats);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nCount = number of matrices (and vectors) to transform
+/ /     szResults = CSV file to append the results to
+/ /
+/ / PURPOSE:
+/ /     Times the batch matrix routines with every set of kernels the CPU supports, so the SIMD paths can be
+/ /     compared against the scalar one. Each kernel gets a line with its best time, the rate, the speedup over
+/ /     the scalar kernel and the largest difference from the scalar results. Returns false if the memory
+/ /     couldn't be allocated or the results couldn't be written.
+/ /
+/ / NOTES:
+/ /     Every local matrix is multiplied by a view projection matrix and every vector by the same matrix, the
+/ /     arrays are much larger than the caches so this measures what a real batch would see.
+/*/
+
+bool
+RunMathBenchmark (unsigned int nCount, LPCTSTR szResults)
+{
+    static const LPCTSTR szPaths[] = MATH_PATH_NAMES;
+    MATHPATH nOriginal = GetMathPath();
+    MAT4 Projection, View, ViewProj;
+    PMAT4 pLocal = NULL, pOut = NULL, pReference = NULL;
+    PVEC4 pIn = NULL, pVectors = NULL, pVecReference = NULL;
+    FILE *pFile = NULL;
+    bool bReturn = false;
+    unsigned int i = 0;
+    int nPath = 0, nRun = 0;
+
+    if((nCount == 0) || (szResults == NULL) || (szResults[0] == _T('\0'))) return false;
+
+    pLocal = (PMAT4)malloc(nCount * sizeof(MAT4));
+    pOut = (PMAT4)malloc(nCount * sizeof(MAT4));
+    pReference = (PMAT4)malloc(nCount * sizeof(MAT4));
+    pIn = (PVEC4)malloc(nCount * sizeof(VEC4));
+    pVectors = (PVEC4)malloc(nCount * sizeof(VEC4));
+    pVecReference = (PVEC4)malloc(nCount * sizeof(VEC4));
+
+    if((pLocal != NULL) && (pOut != NULL) && (pReference != NULL) && (pIn != NULL) && (pVectors != NULL) && (pVecReference != NULL) &&
+       (_tfopen_s(&pFile, szResults, _T("a")) == 0))
+    {
+        VEC3 Eye = {0.0f, 10.0f, 30.0f}, Center = {0.0f, 0.0f, -35.0f}, Up = {0.0f, 1.0f, 0.0f};
+        double adScalar[2] = {0.0, 0.0};
+
+        SetPerspective(&Projection, 45.0f, 16.0f / 9.0f, 1.0f, 100.0f);
+        SetLookAt(&View, &Eye, &Center, &Up);
+        MultiplyMatrix(&ViewProj, &Projection, &View);
+
+        // the same sort of transforms the field of triforces uses, spread out and turned every which way
+        for(i = 0; i < nCount; i++)
+        {
+            VEC3 Position = {(float)(i % 1000) - 500.0f, (float)((i / 1000) % 1000) - 500.0f, -35.0f};
+            QUAT Rotation;
+
+            SetQuatRotation(&Rotation, (float)(i % 360), 0.3f, 1.0f, 0.2f);
+            ComposeMatrix(&pLocal[i], &Position, &Rotation, 0.5f + ((i % 7) * 0.25f));
+
+            pIn[i].x = Position.x;
+            pIn[i].y = Position.y;
+            pIn[i].z = (float)(i % 100);
+            pIn[i].w = 1.0f;
+        }
+
+        fseek(pFile, 0, SEEK_END);
+        if(ftell(pFile) == 0) _ftprintf(pFile, _T("kernel,path,count,seconds,per_second,speedup,max_error\n"));
+
+        for(nPath = MATH_SCALAR; nPath < MATH_PATHS; nPath++)
+        {
+            double dMultiply = 0.0, dTransform = 0.0;
+
+            if(!SetMathPath((MATHPATH)nPath)) continue;
+
+            for(nRun = 0; nRun < BENCH_RUNS; nRun++)
+            {
+                double dStart = GetClockSeconds();
+                MultiplyMatrices(pOut, &ViewProj, pLocal, nCount);
+                dStart = GetClockSeconds() - dStart;
+                if((nRun == 0) || (dStart < dMultiply)) dMultiply = dStart;
+
+                dStart = GetClockSeconds();
+                TransformVectors(pVectors, &ViewProj, pIn, nCount);
+                dStart = GetClockSeconds() - dStart;
+                if((nRun == 0) || (dStart < dTransform)) dTransform = dStart;
+            }
+
+            // the scalar kernels run first, so their results are what the others are checked against
+            if(nPath == MATH_SCALAR)
+            {
+                memcpy(pReference, pOut, nCount * sizeof(MAT4));
+                memcpy(pVecReference, pVectors, nCount * sizeof(VEC4));
+                adScalar[0] = dMultiply;
+                adScalar[1] = dTransform;
+            }
+
+            _ftprintf(pFile, _T("multiply_matrices,%s,%u,%.6f,%.0f,%.2f,%g\n"), szPaths[nPath], nCount, dMultiply, nCount / dMultiply,
+                adScalar[0] / dMultiply, __maxError(pOut->m, pReference->m, nCount * 16));
+            _ftprintf(pFile, _T("transform_vectors,%s,%u,%.6f,%.0f,%.2f,%g\n"), szPaths[nPath], nCount, dTransform, nCount / dTransform,
+                adScalar[1] / dTransform, __maxError(&pVectors->x, &pVecReference->x, nCount * 4));
+        }
+
+        bReturn = (fclose(pFile) == 0);
+        SetMathPath(nOriginal);
+    }
+
+    // free() doesn't mind NULL, so whatever did get allocated is released
+    free(pLocal);
+    free(pOut);
+    free(pReference);
+    free(pIn);
+    free(pVectors);
+    free(pVecReference);
+
+    return bReturn;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pA, pB = arrays of floats to compare
+/ /     nFloats = number of floats in each array
+/ /
+/ / PURPOSE:
+/ /     Returns the largest difference between two arrays, the SIMD kernels add in the same order as the
+/ /     scalar ones so this should be zero, but a compiler that contracts to FMA can make it a little off.
+/*/
+
+static float
+__maxError (const float *pA, const float *pB, size_t nFloats)
+{
+    float fMax = 0.0f;
+    size_t i = 0;
+
+    for(i = 0; i < nFloats; i++)
+    {
+        float fError = (float)fabs(pA[i] - pB[i]);
+        if(fError > fMax) fMax = fError;
+    }
+
+    return fMax;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
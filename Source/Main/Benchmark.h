@@ -0,0 +1,9 @@
+#if !defined (BENCHMARK_H_3D7C1A58_B92E_4F06_9C4D_E815A26F70B3_)
+#define BENCHMARK_H_3D7C1A58_B92E_4F06_9C4D_E815A26F70B3_
+
+#pragma once  // in case the compiler supports it
+
+// microbenchmarks that run without a window or render thread, they append their results to a CSV file
+bool RunMathBenchmark (unsigned int nCount, LPCTSTR szResults);
+
+#endif  // BENCHMARK_H
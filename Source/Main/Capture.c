@@ -0,0 +1,396 @@
+#include "Main\Application.h"    // standard application include
+#include "Main\Render.h"         // render thread arguments and commands
+#include "Main\Capture.h"        // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// CAPTURE AND REPLAY ROUTINES //////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / What the render thread draws only depends on the arguments it was started with and, from one frame to the
+/ / next, on how much time has passed, how big the viewport is and which commands came in, the scenes are built
+/ / from fixed seeds and animated in fixed steps. So a capture is the arguments that decide what's drawn, then a
+/ / record per frame with its elapsed time, its viewport size and the commands carried out before it. Replaying
+/ / a capture feeds those back in place of the clock, the window and the command queue, which draws the exact
+/ / same frames no matter how long each one takes, so two builds can be timed on the same work.
+/*/
+
+#define CAPTURE_MAGIC   0x50434C47      // "GLCP"
+#define CAPTURE_VERSION 2
+#define CAPTURE_BUFFER  (64 * 1024)     // bytes written to the file at a time
+
+// first bytes of the file
+typedef struct
+{
+    DWORD dwMagic;                  // always CAPTURE_MAGIC
+    DWORD dwVersion;                // always CAPTURE_VERSION
+    DWORD dwFrames;                 // number of frames that follow (written when the capture stops)
+    DWORD nScene;                   // scene the run started with
+    DWORD nInstances;               // number of instances the scenes were built with
+    DWORD nUpdateRate;              // number of fixed steps per second the scene was animated with
+    DWORD bRetained;                // non-zero if primitives were drawn from buffer objects
+    DWORD bSoftware;                // non-zero if the triforce was drawn by the software rasterizer
+    DWORD nWidth;                   // width of the viewport the first frame was drawn at
+    DWORD nHeight;                  // height of the viewport the first frame was drawn at
+
+}  CAPTUREHEADER;
+
+// one frame, followed by the commands that were carried out before it
+typedef struct
+{
+    double dElapsed;                // seconds since the frame before, what the scene was animated by
+    DWORD  nWidth;                  // width of the viewport the frame was drawn at
+    DWORD  nHeight;                 // height of the viewport the frame was drawn at
+    DWORD  nCommands;               // number of commands that follow
+    DWORD  dwReserved;              // zero, keeps the records a multiple of eight bytes
+
+}  CAPTUREFRAME;
+
+// a command as it's kept in the file, only the ones that change what's drawn are
+typedef struct
+{
+    DWORD nCommand;                 // RENDER_SCENE or RENDER_VSYNC
+    DWORD nValue;                   // the scene to switch to, or non-zero to turn vsync on
+
+}  CAPTURECOMMAND;
+
+// local variables
+static FILE           *_pCapture     = NULL;    // file being captured to (NULL if none)
+static DWORD           _dwCaptured   = 0;       // number of frames captured so far
+static CAPTURECOMMAND *_pPending     = NULL;    // commands carried out since the last frame was captured
+static DWORD           _nPending     = 0;       // number of those commands
+static DWORD           _nPendingSize = 0;       // number of commands the pending array has room for
+
+static BYTE                 *_pReplay   = NULL; // the whole capture being replayed (NULL if none)
+static size_t                _nReplay   = 0;    // bytes in the capture
+static size_t                _nNext     = 0;    // where the next frame starts
+static const CAPTURECOMMAND *_pCommands = NULL; // commands of the frame being replayed that haven't been handed out
+static DWORD                 _nCommands = 0;    // number of those commands
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szFile = file to capture to, it's overwritten
+/ /     pArgs = arguments the render thread was started with
+/ /     nWidth = width of the viewport the first frame is drawn at
+/ /     nHeight = height of the viewport the first frame is drawn at
+/ /
+/ / PURPOSE:
+/ /     Starts capturing every frame drawn from now on, until StopCapture() is called. Returns false if the file
+/ /     couldn't be created, nothing is captured then.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, after the scene has been built and before the
+/ /     first frame is drawn.
+/*/
+
+bool
+StartCapture (LPCTSTR szFile, const RENDERARGS *pArgs, UINT nWidth, UINT nHeight)
+{
+    CAPTUREHEADER Header = {CAPTURE_MAGIC, CAPTURE_VERSION, 0};
+
+    if((_pCapture != NULL) || (szFile == NULL) || (pArgs == NULL)) return false;
+    if(_tfopen_s(&_pCapture, szFile, _T("wb")) != 0) return false;
+
+    // the records are small, so they are gathered into large writes
+    setvbuf(_pCapture, NULL, _IOFBF, CAPTURE_BUFFER);
+
+    Header.nScene = (DWORD)pArgs->nScene;
+    Header.nInstances = pArgs->nInstances;
+    Header.nUpdateRate = pArgs->nUpdateRate;
+    Header.bRetained = pArgs->bRetained ? 1 : 0;
+    Header.bSoftware = pArgs->bSoftware ? 1 : 0;
+    Header.nWidth = nWidth;
+    Header.nHeight = nHeight;
+
+    if(fwrite(&Header, sizeof(Header), 1, _pCapture) != 1)
+    {
+        fclose(_pCapture);
+        _pCapture = NULL;
+        return false;
+    }
+
+    _dwCaptured = 0;
+    _nPending = 0;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Writes the number of frames captured into the header and closes the file.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, after the last frame has been drawn.
+/*/
+
+void
+StopCapture (void)
+{
+    if(_pCapture != NULL)
+    {
+        // the frame count is the third DWORD of the header
+        if(fseek(_pCapture, 2 * sizeof(DWORD), SEEK_SET) == 0) fwrite(&_dwCaptured, sizeof(_dwCaptured), 1, _pCapture);
+
+        fclose(_pCapture);
+        _pCapture = NULL;
+    }
+
+    free(_pPending);
+    _pPending = NULL;
+    _nPending = _nPendingSize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pCommand = command the render thread has just carried out
+/ /
+/ / PURPOSE:
+/ /     Keeps the command for the next frame captured, if it's one that changes what's drawn. A resize is kept by
+/ /     the frame itself, and pausing or stopping changes when frames are drawn but not what they are.
+/ /
+/ / NOTES:
+/ /     Commands are kept in the order they were carried out, even when several come in between two frames.
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+CaptureCommand (const RENDERCOMMAND *pCommand)
+{
+    CAPTURECOMMAND *pKept = NULL;
+
+    if((_pCapture == NULL) || (pCommand == NULL)) return;
+    if((pCommand->nCommand != RENDER_SCENE) && (pCommand->nCommand != RENDER_VSYNC)) return;
+
+    if(_nPending == _nPendingSize)
+    {
+        DWORD nSize = (_nPendingSize > 0) ? (_nPendingSize * 2) : 8;
+
+        if((pKept = (CAPTURECOMMAND *)realloc(_pPending, nSize * sizeof(CAPTURECOMMAND))) == NULL) return;
+        _pPending = pKept;
+        _nPendingSize = nSize;
+    }
+
+    pKept = &_pPending[_nPending++];
+    pKept->nCommand = (DWORD)pCommand->nCommand;
+    pKept->nValue = (pCommand->nCommand == RENDER_SCENE) ? (DWORD)pCommand->Data.nScene : (pCommand->Data.bVSync ? 1 : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dElapsed = seconds since the frame before, as the scene is animated by them
+/ /     nWidth = width of the viewport the frame is drawn at
+/ /     nHeight = height of the viewport the frame is drawn at
+/ /
+/ / PURPOSE:
+/ /     Captures a frame along with the commands carried out since the last one. If the file can't be written
+/ /     to the capture stops there, what was written up to then can still be replayed.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once per frame drawn, before it's animated.
+/*/
+
+void
+CaptureFrame (double dElapsed, UINT nWidth, UINT nHeight)
+{
+    CAPTUREFRAME Frame = {0};
+
+    if(_pCapture == NULL) return;
+
+    Frame.dElapsed = dElapsed;
+    Frame.nWidth = nWidth;
+    Frame.nHeight = nHeight;
+    Frame.nCommands = _nPending;
+
+    if((fwrite(&Frame, sizeof(Frame), 1, _pCapture) != 1) ||
+       ((_nPending > 0) && (fwrite(_pPending, sizeof(CAPTURECOMMAND), _nPending, _pCapture) != _nPending)))
+    {
+        StopCapture();
+        return;
+    }
+
+    _dwCaptured++;
+    _nPending = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szFile = capture to replay
+/ /     pArgs = arguments the render thread will be started with, they are changed to the ones the capture was
+/ /             started with (and the size of the offscreen target to the first viewport size if headless)
+/ /
+/ / PURPOSE:
+/ /     Reads a capture into memory so the render thread can replay it rather than run from the clock, the window
+/ /     and the command queue. Returns false if it couldn't be read or isn't a capture.
+/ /
+/ / NOTES:
+/ /     The whole file is read up front, so replaying it doesn't read from the disk while frames are timed.
+/ /     This must be called before the render thread is started.
+/*/
+
+bool
+LoadReplay (LPCTSTR szFile, PRENDERARGS pArgs)
+{
+    const CAPTUREHEADER *pHeader = NULL;
+    FILE *pFile = NULL;
+    long nSize = 0;
+
+    if((szFile == NULL) || (pArgs == NULL)) return false;
+
+    FreeReplay();
+    if(_tfopen_s(&pFile, szFile, _T("rb")) != 0) return false;
+
+    if((fseek(pFile, 0, SEEK_END) == 0) && ((nSize = ftell(pFile)) >= (long)sizeof(CAPTUREHEADER)) && (fseek(pFile, 0, SEEK_SET) == 0))
+    {
+        if((_pReplay = (BYTE *)malloc(nSize)) != NULL)
+        {
+            if(fread(_pReplay, nSize, 1, pFile) == 1) _nReplay = (size_t)nSize;
+            else FreeReplay();
+        }
+    }
+
+    fclose(pFile);
+    if(_pReplay == NULL) return false;
+
+    pHeader = (const CAPTUREHEADER *)_pReplay;
+    if((pHeader->dwMagic != CAPTURE_MAGIC) || (pHeader->dwVersion != CAPTURE_VERSION) || (pHeader->nScene >= SCENE_COUNT))
+    {
+        FreeReplay();
+        return false;
+    }
+
+    pArgs->nScene = (SCENE)pHeader->nScene;
+    pArgs->nInstances = pHeader->nInstances;
+    pArgs->nUpdateRate = pHeader->nUpdateRate;
+    pArgs->bRetained = (pHeader->bRetained != 0);
+    pArgs->bSoftware = (pHeader->bSoftware != 0);
+
+    if(pArgs->bOffscreen && (pHeader->nWidth > 0) && (pHeader->nHeight > 0))
+    {
+        pArgs->nWidth = pHeader->nWidth;
+        pArgs->nHeight = pHeader->nHeight;
+    }
+
+    _nNext = sizeof(CAPTUREHEADER);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases the capture read by LoadReplay(), IsReplaying() returns false after this.
+/*/
+
+void
+FreeReplay (void)
+{
+    free(_pReplay);
+
+    _pReplay = NULL;
+    _nReplay = _nNext = 0;
+    _pCommands = NULL;
+    _nCommands = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pElapsed = receives the seconds to animate the scene by
+/ /     pWidth = receives the width of the viewport to draw the frame at
+/ /     pHeight = receives the height of the viewport to draw the frame at
+/ /
+/ / PURPOSE:
+/ /     Moves on to the next frame of the replay, whose commands are then handed out by ReplayCommand(). Returns
+/ /     false once every frame has been replayed (or if the rest of the capture is cut short).
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once per frame drawn.
+/*/
+
+bool
+ReplayFrame (double *pElapsed, UINT *pWidth, UINT *pHeight)
+{
+    const CAPTUREFRAME *pFrame = NULL;
+
+    _pCommands = NULL;
+    _nCommands = 0;
+
+    if((_pReplay == NULL) || ((_nReplay - _nNext) < sizeof(CAPTUREFRAME))) return false;
+
+    pFrame = (const CAPTUREFRAME *)(_pReplay + _nNext);
+    if(((_nReplay - _nNext - sizeof(CAPTUREFRAME)) / sizeof(CAPTURECOMMAND)) < pFrame->nCommands) return false;
+
+    _pCommands = (const CAPTURECOMMAND *)(pFrame + 1);
+    _nCommands = pFrame->nCommands;
+    _nNext += sizeof(CAPTUREFRAME) + (pFrame->nCommands * sizeof(CAPTURECOMMAND));
+
+    *pElapsed = pFrame->dElapsed;
+    *pWidth = pFrame->nWidth;
+    *pHeight = pFrame->nHeight;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pCommand = receives the next command of the frame being replayed
+/ /
+/ / PURPOSE:
+/ /     Hands out the commands that were carried out before the frame being replayed, in the order they were.
+/ /     Returns false once there are none left.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread.
+/*/
+
+bool
+ReplayCommand (PRENDERCOMMAND pCommand)
+{
+    if(_nCommands == 0) return false;
+
+    memset(pCommand, 0, sizeof(RENDERCOMMAND));
+    pCommand->nCommand = (RENDERCMD)_pCommands->nCommand;
+
+    if(pCommand->nCommand == RENDER_SCENE) pCommand->Data.nScene = (SCENE)_pCommands->nValue;
+    else pCommand->Data.bVSync = (_pCommands->nValue != 0);
+
+    _pCommands++;
+    _nCommands--;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns true if a capture is being replayed, the render thread takes its frames from it then.
+/*/
+
+bool
+IsReplaying (void)
+{
+    return (_pReplay != NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
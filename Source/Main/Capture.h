@@ -0,0 +1,19 @@
+#if !defined (CAPTURE_H_6E2B9D14_A7C3_4F58_8B01_D3F65E29A7C4_)
+#define CAPTURE_H_6E2B9D14_A7C3_4F58_8B01_D3F65E29A7C4_
+
+#pragma once  // in case the compiler supports it
+
+// a capture holds what a run was started with and, for every frame it drew, what the frame depended on from
+// outside the render thread, so the same frames can be drawn again later
+bool StartCapture   (LPCTSTR szFile, const RENDERARGS *pArgs, UINT nWidth, UINT nHeight);
+void StopCapture    (void);
+void CaptureCommand (const RENDERCOMMAND *pCommand);
+void CaptureFrame   (double dElapsed, UINT nWidth, UINT nHeight);
+
+bool LoadReplay     (LPCTSTR szFile, PRENDERARGS pArgs);
+void FreeReplay     (void);
+bool ReplayFrame    (double *pElapsed, UINT *pWidth, UINT *pHeight);
+bool ReplayCommand  (PRENDERCOMMAND pCommand);
+bool IsReplaying    (void);
+
+#endif  // CAPTURE_H
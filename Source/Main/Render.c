@@ -1,25 +1,124 @@
 #include "Main\Application.h"    // standard application include
 #include "Main\Render.h"         // include for this file
+#include "Main\Capture.h"        // frame capture and replay routines
+#include "Primitives\Model.h"    // mesh file primitive
 #include "Primitives\Triforce.h" // Zelda triforce primitive
+#include "Utility\Arena.h"       // frame arena routines
+#include "Utility\Extensions.h"  // GL extension routines
+#include "Utility\General.h"     // general utility routines
 #include "Utility\Graphical.h"   // graphical utility routines
+#include "Utility\Jobs.h"        // job routines
+#include "Utility\Loader.h"      // asset loader routines
+#include "Utility\Profile.h"     // frame timing routines
+#include "Utility\Queue.h"       // single producer queue routines
+#include "Utility\Scaling.h"     // dynamic resolution routines
+#include "Utility\Shader.h"      // shader program routines
+#include "Utility\State.h"       // render state routines
+#include "Utility\Stream.h"      // streaming buffer routines
+#include "Utility\Timing.h"      // timing routines
+#include "Utility\VecMath.h"     // vector math routines
+#include <psapi.h>               // GetProcessMemoryInfo()
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////// MAIN OPENGL RENDERING ROUTINES ///////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// local state variables, used to signal the worker thread (terminate, resize, etc.), if another
-// thread wishes to set the states these track then they must do so via the message queue
-static bool _bStopRenderThread = false;
-static bool _bResizeFrame = true; // must default to true to set initial sizes
-static bool _bPaused = false;
+// most time (in seconds) the animation catches up on in a single frame, after a stall (like being dragged or
+// stopped in a debugger) the scene jumps ahead rather than the frame running thousands of updates to catch up
+#define MAX_BACKLOG 0.25
+
+// everything a render thread keeps about the context it draws into, there is one per render thread that may
+// run at once, the flags are used to signal the render thread (terminate, resize, etc.), if another thread
+// wishes to set the states these track then it must do so via PostRenderCommand()
+typedef struct
+{
+    bool           bStop;           // flag to indicate the render thread should end
+    bool           bResize;         // flag to indicate the viewport must be set up again before the next frame
+    bool           bPaused;         // flag to indicate nothing is drawn until rendering is resumed
+    RenderDelegate pRenderFrame;    // delegate function to be called when a frame needs to be rendered
+    UpdateDelegate pUpdateFrame;    // delegate function to be called when the scene needs to be animated
+    RENDERCOMMAND  aCommands[64];   // storage for the commands sent to the render thread
+    QUEUE          Commands;        // commands sent to the render thread and not yet carried out
+    HANDLE         hWakeEvent;      // signaled whenever a command is queued, the render thread sleeps on it when idle
+    MAT4           Projection;      // projection matrix set up by the last resize
+    GLuint         nBackdrop;       // texture drawn behind every scene once it has streamed in (if any)
+    DWORD          nFrames;         // number of frames the render thread measured (set once it's done)
+    double         dSeconds;        // how long it took to draw them
+    double         dScale;          // average fraction of the client area's width and height they were drawn at
+
+}  RENDERCONTEXT, *PRENDERCONTEXT;
 
 // local function prototypes
 static void   __initRender    (const PRENDERARGS pArgList);
+static void   __initScene     (const PRENDERARGS pArgList);
+static void   __killRender    (const PRENDERARGS pArgList);
+static void   __killScene     (void);
+static void   __drawBackdrop  (void);
+static void   __onBackdrop    (const LOADRESULT *pResult, void *pContext);
+static void   __writeResults  (const PRENDERARGS pArgList, DWORD nFrames, double dSeconds);
+static void   __writeBenchmark (const PRENDERARGS pArgList, DWORD nFrames, double dSeconds);
+static void   __writeJSONString (FILE *pFile, const char *szString);
+static void   __endWarmup     (UINT nContexts);
 static void   __onResizeFrame (HWND hWnd, unsigned int nWidth, unsigned int nHeight);
-static void   __threadProc    (UINT uMsg, WPARAM wParam, LPARAM lParam);
+static void   __runCommand    (const PRENDERARGS pArgList, PRECT pClient, const RENDERCOMMAND *pCommand);
+static void   __runCommands   (const PRENDERARGS pArgList, PRECT pClient);
+static PRENDERCONTEXT __getContext (UINT nContext);
 
 // local variables
-static RenderDelegate _pRenderFrame = NULL; // delegate function to be called when a frame needs to be rendered
+static RENDERCONTEXT _aContexts[CONFIG_MAX_CONTEXTS];      // one per render thread that may run at once
+static volatile LONG _nContextsSet = 0;                     // 0 until the contexts are set up, 1 while they are, 2 after
+static volatile LONG _nWarmedUp = 0;                        // number of render threads done with their warm-up
+static HANDLE _hWarmedUp = NULL;                            // set once every render thread is done with its warm-up
+static volatile LONG _nFinished = 0;                        // number of render threads done measuring
+static __declspec(thread) PRENDERCONTEXT _pContext = NULL;  // context of the render thread calling
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     afMatrix = array that receives the projection matrix (column major)
+/ /
+/ / PURPOSE:
+/ /     Returns the projection matrix the viewport was last set up with, so a render delegate can derive
+/ /     its view frustum from it without reading it back from the GL.
+/ /
+/ / NOTE:
+/ /     This must be called in the context of the render thread, it returns that thread's projection.
+/*/
+
+void
+GetProjection (float afMatrix[16])
+{
+    memcpy(afMatrix, _pContext->Projection.m, sizeof(_pContext->Projection.m));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nContext = which render thread to send the command to (RENDERARGS::nContext)
+/ /     pCommand = command (and its data) to send to the render thread
+/ /
+/ / PURPOSE:
+/ /     Queues a command for a render thread, which carries out every queued command at the start of
+/ /     its next frame, and wakes it up if it's idle. Returns false if the queue is full, in which case
+/ /     the command is dropped.
+/ /
+/ / NOTE:
+/ /     The queues have no lock, so only one thread (the main thread) may send the render threads commands.
+/ /     Commands may be sent before a render thread has started, they are carried out once it has.
+/*/
+
+bool
+PostRenderCommand (UINT nContext, const RENDERCOMMAND *pCommand)
+{
+    PRENDERCONTEXT pContext = __getContext(nContext);
+
+    if(!PushQueueItem(&pContext->Commands, pCommand)) return false;
+
+    SetEvent(pContext->hWakeEvent);
+    return true;
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -27,12 +126,33 @@ static RenderDelegate _pRenderFrame = NULL; // delegate function to be called wh
 / / PARAMETERS:
 / /     pArgList->bVSync;          // flag to indicate if we enable or disable or leave alone vsync
 / /     pArgList->hWnd;            // handle to the calling window
-/ /     pArgList->hDC;             // handle to the device context of the client area of the calling window
+/ /     pArgList->hDC;             // handle to the device context of the client area of the calling window (or of a hidden
+/ /                                // window of its own, for every render thread after the first)
 / /     pArgList->nBPP;            // bits per pixel the application is trying to use (ignored if windowed)
 / /     pArgList->nRefresh;        // vertical refresh rate of the display in hertz (ignored if windowed)
 / /     pArgList->bFullscreen;     // flag to indicate to the thread if we are in fullscreen mode
 / /     pArgList->bZoomed;         // flag to indicate to the thread if we are to maximize the main window
-/ /     pArgList->pRenderFrame;    // delegate function to be called when a frame needs to be rendered
+/ /     pArgList->bOffscreen;      // flag to indicate to the thread to render headless into an offscreen target
+/ /     pArgList->nWidth;          // width of the offscreen target in pixels (ignored if not offscreen)
+/ /     pArgList->nHeight;         // height of the offscreen target in pixels (ignored if not offscreen)
+/ /     pArgList->nFrames;         // number of frames to render before stopping (zero means no limit)
+/ /     pArgList->nSeconds;        // number of seconds to render for before stopping (zero means no limit)
+/ /     pArgList->nWarmup;         // number of frames drawn before anything is measured (and before nFrames counts)
+/ /     pArgList->nTargetFPS;      // number of frames per second to limit rendering to (zero means no limit)
+/ /     pArgList->nUpdateRate;     // number of fixed steps per second the scene is animated with
+/ /     pArgList->bRetained;       // flag to indicate if primitives are drawn from buffer objects (retained mode)
+/ /     pArgList->bSoftware;       // flag to indicate the triforce is drawn by the software rasterizer (whatever the scene)
+/ /     pArgList->nScene;          // which scene (render delegate) to draw
+/ /     pArgList->nInstances;      // number of instances to draw (ignored unless the scene uses instancing)
+/ /     pArgList->szResults;       // file a headless run appends its frame rate to (ignored if empty)
+/ /     pArgList->szStats;         // base name of the frame timing files written on exit (ignored if empty)
+/ /     pArgList->szBenchmark;     // file the measurements of a headless run are written to as JSON (ignored if empty)
+/ /     pArgList->szBackdrop;      // bitmap streamed in and drawn behind every scene (ignored if empty)
+/ /     pArgList->szMesh;          // binary mesh file the model scene draws (ignored unless the scene is the model)
+/ /     pArgList->szCapture;       // file every frame's inputs are captured to (ignored if empty)
+/ /     pArgList->szReplay;        // capture the frames are replayed from, already read by LoadReplay() (ignored if empty)
+/ /     pArgList->nContext;        // which render thread this is, zero for the one that owns the jobs, loader and capture
+/ /     pArgList->nContexts;       // number of render threads drawing at once, each into a context of its own
 / /
 / / PURPOSE:
 / /        Wraps the process of calling initialization routines and
@@ -50,17 +170,48 @@ RenderMain (const PRENDERARGS pArgList)
         unsigned short nFPS = 0;                // current frame rate (FPS) for the main loop
     #endif
 
-    static double dLastTime = 0, dCurTime = 0;  // used to calculate CPU cycles during a render
-    static double dElapsed = 0;                 // used to calculate CPU cycles during a render
+    double dLastTime = 0, dCurTime = 0;         // used to calculate CPU cycles during a render (one set per render thread)
+    double dElapsed = 0;                        // used to calculate CPU cycles during a render
+    double dFirstTime = 0;                      // time the first frame started, used for the results of a headless run
+    double dUpdatedTime = 0, dDrawnTime = 0;    // time the updates and the delegate returned, for profiling
+    double dShownTime = 0;                      // time the frame was presented, for profiling
+    double dStep = 0, dBacklog = 0;             // length of one update, and time not yet animated
+    double dAnimated = 0;                       // time the scene is animated by this frame (the captured time if replaying)
+    double dCost = 0;                           // time the frame took to draw, the dynamic resolution is picked by it
+    double dScaled = 0;                         // sum of the resolution scale of every frame measured
 
     HGLRC hRC     = NULL;                       // handle to the GLs render context
     RECT rcClient = {0};                        // coordinates of the area safe to draw on
-    MSG msg       = {0};                        // message structure for the queue
+    OFFSCREEN Offscreen = {0};                  // render target used in place of the window if headless
+    LIMITER Limiter = {0};                      // paces the loop to the target frame rate (if any)
+    DWORD nFrames = 0;                          // number of frames rendered so far (not counting the warm-up)
+    DWORD nWarmup = pArgList->nWarmup;          // number of warm-up frames still to be drawn
+    DWORD nTotal = 0;                           // number of frames every render thread measured together
+    UINT nDrawWidth = 0, nDrawHeight = 0;       // size the frame is drawn at (less than the client area while it's scaled)
+    double dSlowest = 0;                        // longest any render thread took to measure its frames
+    bool bLast = false;                         // flag to indicate this is the last render thread to be done
+    PRENDERCONTEXT pContext = NULL;             // what this render thread keeps about its context
+    UINT i = 0;
+
+    // the helpers (and GetProjection()) find the context through the thread, it starts out needing a resize
+    pContext = _pContext = __getContext(pArgList->nContext);
+    pContext->bStop = pContext->bPaused = false;
+    pContext->bResize = true;
+
+    // every run starts its frame timings from scratch, after the warm-up if there is one
+    if(nWarmup == 0) __endWarmup(pArgList->nContexts);
 
     // create and activate (in OGL) the render context
     hRC = wglCreateContext(pArgList->hDC);
     if(wglMakeCurrent(pArgList->hDC, hRC))
     {
+        // read what the GL offers past 1.1 once, everything after this only asks the loader
+        // note: if it can't be read every capability simply reads as missing
+        InitExtensions();
+
+        // a fresh context is in its default state, so the state cache can start out knowing all of it
+        ResetState();
+
         #ifdef _DEBUG
             ENTER_GL
         #endif
@@ -70,41 +221,86 @@ RenderMain (const PRENDERARGS pArgList)
 
         #ifdef _DEBUG
             // test to see if we got an initialization error, if so then stop the render thread
-            _bStopRenderThread = LEAVE_GL(_T("__initRender()"))
+            pContext->bStop = LEAVE_GL(_T("__initRender()"))
         #endif
 
-        // if no previous error exists, let the main thread know it's ok to display the main window
-        if(!_bStopRenderThread) _bStopRenderThread = (bool)!SendMessage(pArgList->hWnd, UWM_SHOW, pArgList->bZoomed, 0);
+        if(!pContext->bStop)
+        {
+            // if headless, rendering goes into a framebuffer object of the requested size and the window is
+            // never shown, otherwise if no previous error exists let the main thread know it's ok to display it
+            if(pArgList->bOffscreen)
+                pContext->bStop = !CreateOffscreen(&Offscreen, pArgList->nWidth, pArgList->nHeight);
+            else
+                pContext->bStop = (bool)!SendMessage(pArgList->hWnd, UWM_SHOW, pArgList->bZoomed, 0);
+
+            // set-up the perspective screen to be the size of the client area, to avoid clipping use
+            // the client area size, not the window size, later sizes come with the resize commands
+            // when headless the offscreen target takes the place of the client area
+            if(pArgList->bOffscreen)
+                SetRect(&rcClient, 0, 0, Offscreen.nWidth, Offscreen.nHeight);
+            else
+                GetClientRect(pArgList->hWnd, &rcClient);
+
+            // with a frame budget the frames are drawn at whatever resolution keeps them inside it, and stretched
+            // over the client area (or the offscreen target), without one they're always drawn at full size
+            InitScaling(pArgList->nBudget / 1000.0, pArgList->bOffscreen ? Offscreen.nFrameBuffer : 0);
+
+            // the scene is animated in fixed steps, and frames are drawn no faster than asked for (if at all)
+            dStep = 1.0 / ((pArgList->nUpdateRate > 0) ? pArgList->nUpdateRate : CONFIG_UPDATE_RATE);
+            CreateFrameLimiter(&Limiter, pArgList->nTargetFPS);
+            dLastTime = GetClockSeconds();
+
+            // every frame drawn from here on is captured, e.g. to be replayed against another build
+            if((pArgList->nContext == 0) && (pArgList->szCapture[0] != _T('\0'))) StartCapture(pArgList->szCapture, pArgList, rcClient.right, rcClient.bottom);
+        }
     }
 
     // note: this is the main render loop used for OpenGL, it's an endless loop
     // with low level access to the video hardware, use this power wisely
-    while(!_bStopRenderThread && (_pRenderFrame != NULL))
+    while(!pContext->bStop && (pContext->pRenderFrame != NULL))
     {
-        // NOTE: it is imperative that PeekMessage() is used rather than GetMessage()
-        // listen to the queue in case this thread receives a message
-        if(PeekMessage(&msg, NULL, UWM_PAUSE, UWM_STOP, PM_REMOVE)) __threadProc(msg.message, msg.wParam, msg.lParam);
+        // carry out every command that was sent since the last frame, not just one of them
+        __runCommands(pArgList, &rcClient);
+        if(pContext->bStop) break;
 
         // do not waste processing time if the window is minimized
         // note: even in fullscreen a window can end up minimized
-        if(!IsIconic(pArgList->hWnd))
+        if(pArgList->bOffscreen || !IsIconic(pArgList->hWnd))
         {
-            // if we need to resize the window then do so, but only once per request
-            // this will be called on startup
-            if(_bResizeFrame)
+            // if we need to resize the viewport then do so, but only once no matter how many
+            // resize commands came in since the last frame, this will be called on startup
+            if(pContext->bResize)
             {
-                // set-up the perspective screen to be the size of the client area
-                // to avoid clipping, use the client area size, not the window size
-                GetClientRect(pArgList->hWnd, &rcClient);
-
                 // call the resize handler and set flag that it's been processed
                 __onResizeFrame(pArgList->hWnd, rcClient.right, rcClient.bottom);
-                _bResizeFrame = false;
+                pContext->bResize = false;
             }
 
             // only perform this action if the rendering isn't paused
-            if(!_bPaused)
+            if(!pContext->bPaused)
             {
+                // a replay draws the frames that were captured, at the size they were drawn at and after the
+                // commands that came in before them, and stops once there are no more of them
+                if(IsReplaying())
+                {
+                    RENDERCOMMAND Command = {0};
+                    UINT nWidth = 0, nHeight = 0;
+
+                    if(!ReplayFrame(&dAnimated, &nWidth, &nHeight))
+                    {
+                        pContext->bStop = true;
+                        continue;
+                    }
+
+                    while(ReplayCommand(&Command)) __runCommand(pArgList, &rcClient, &Command);
+
+                    if((nWidth != (UINT)rcClient.right) || (nHeight != (UINT)rcClient.bottom))
+                    {
+                        SetRect(&rcClient, 0, 0, nWidth, nHeight);
+                        __onResizeFrame(pArgList->hWnd, rcClient.right, rcClient.bottom);
+                    }
+                }
+
                 #ifdef _DEBUG
                     // use a low resolution for the FPS count
                     dwFPSCurrent = GetTickCount();
@@ -112,24 +308,109 @@ RenderMain (const PRENDERARGS pArgList)
                     ENTER_GL
                 #endif
 
-                // call the main drawing delegate, if it's to be seen, this routine must show it
-                // we use time-based rendering, so the time argument should be used as a factor
-                dCurTime = GetCPUTicks();
+                dCurTime = GetClockSeconds();
                 dElapsed = dCurTime - dLastTime;
-                _pRenderFrame(dElapsed, rcClient.right, rcClient.bottom);
+                if(nFrames == 0) dFirstTime = dCurTime;
+
+                if(!IsReplaying()) dAnimated = dElapsed;
+                CaptureFrame(dAnimated, rcClient.right, rcClient.bottom);
+
+                // take back the arena memory of the oldest frame in flight, this frame allocates from it
+                BeginArenaFrame();
+
+                // animate the scene in as many fixed steps as fit in the time that has passed, whatever is
+                // left over carries on to the next frame, so the animation is the same at any frame rate
+                dBacklog += (dAnimated < MAX_BACKLOG) ? dAnimated : MAX_BACKLOG;
+                while(dBacklog >= dStep)
+                {
+                    if(pContext->pUpdateFrame != NULL) pContext->pUpdateFrame(dStep);
+                    dBacklog -= dStep;
+                }
+
+                dUpdatedTime = GetClockSeconds();
+
+                // the frame is drawn at the scale the last few frames' costs picked, the clear included
+                BeginScaledFrame(rcClient.right, rcClient.bottom, &nDrawWidth, &nDrawHeight);
+
+                // every frame starts out cleared, this is done here rather than in the delegate so the GPU
+                // time it takes can be told apart from the time the delegate's own drawing takes
+                MarkGPUTime(GPU_BEGIN);
+                glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+                MarkGPUTime(GPU_CLEARED);
+
+                // upload a slice of whatever has been loaded in the background, never so much that this frame is
+                // held up by it, whatever finishes is handed to its owner before it's drawn (the loader belongs
+                // to the first render thread, it's the one that asked for the files)
+                if(pArgList->nContext == 0) UpdateLoader(CONFIG_UPLOAD_BUDGET);
+                if(pContext->nBackdrop != 0) __drawBackdrop();
+
+                // call the main drawing delegate, if it's to be seen, this routine must show it
+                // the frame falls between two updates, so the delegate is told how far along it is
+                pContext->pRenderFrame(dBacklog / dStep, nDrawWidth, nDrawHeight);
+                MarkGPUTime(GPU_DRAWN);
+                dDrawnTime = GetClockSeconds();
+
+                // stretch it over the output if it was drawn smaller, the time it takes counts as presenting it
+                EndScaledFrame();
                 dLastTime = dCurTime;
 
                 #ifdef _DEBUG
                     // if we had OGL errors during the render, let's find out about them
-                    _bPaused = LEAVE_GL(_T("RenderDelegate()"))
+                    pContext->bPaused = LEAVE_GL(_T("RenderDelegate()"))
                 #endif
 
-                // swap the buffers (double buffering)
-                SwapBuffers(pArgList->hDC);
+                if(pArgList->bOffscreen)
+                {
+                    // there is no front buffer to present, so wait for the GL to finish the frame instead
+                    // this paces the loop by the real rendering rather than by how fast commands queue up
+                    glFinish();
+                }
+                else
+                {
+                    // swap the buffers (double buffering)
+                    SwapBuffers(pArgList->hDC);
+                }
+
+                // the ring regions this frame wrote can't be written again until the GL is done drawing from them
+                EndStreamFrame();
+
+                MarkGPUTime(GPU_SHOWN);
+
+                // record how long this frame took to draw and present, the first frame has no previous
+                // one to measure its length against (and it also pays for everything being created lazily)
+                dShownTime = GetClockSeconds();
+                RecordFrameTime(PROFILE_UPDATE, dUpdatedTime - dCurTime);
+                RecordFrameTime(PROFILE_DELEGATE, dDrawnTime - dUpdatedTime);
+                RecordFrameTime(PROFILE_SWAP, dShownTime - dDrawnTime);
+                if(nFrames > 0) RecordFrameTime(PROFILE_FRAME, dElapsed);
+                EndStateFrame();
+
+                // the warm-up frames are drawn like any other, but what they measured is thrown away once they're done
+                // (everything created lazily and every cache that starts out cold has settled down by then)
+                if(nWarmup > 0)
+                {
+                    if(--nWarmup == 0) __endWarmup(pArgList->nContexts);
+                }
+                else
+                {
+                    // stop once we've rendered as many frames as were requested, or for as long as was asked (if either)
+                    nFrames++;
+                    dScaled += GetScale();
+                    if(pArgList->bOffscreen && (((pArgList->nFrames > 0) && (nFrames >= pArgList->nFrames)) ||
+                       ((pArgList->nSeconds > 0) && ((dShownTime - dFirstTime) >= pArgList->nSeconds))))
+                        pContext->bStop = true;
+                }
+
+                // the frames that follow are scaled by what this one cost, the CPU's time or the GPU's, whichever is
+                // longer, the GPU's is only known with timer queries, otherwise waiting on the present stands in for it
+                dCost = GetGPUFrameTime();
+                if(dCost <= 0.0) dCost = dShownTime - dCurTime;
+                else if(dCost < (dDrawnTime - dCurTime)) dCost = dDrawnTime - dCurTime;
+                UpdateScaling(dCost);
 
                 #ifdef _DEBUG
 
-                    if(!pArgList->bFullscreen)
+                    if(!pArgList->bFullscreen && !pArgList->bOffscreen)
                     {
                         // display the FPS on the title bar of the main window if not in fullscreen mode
                         if(nFPS == 0)
@@ -147,12 +428,21 @@ RenderMain (const PRENDERARGS pArgList)
                             {
                                 TCHAR szBuff[MAX_LOADSTRING] = {0};
                                 TCHAR szVersion[MAX_LOADSTRING] = {0};
+                                FRAMESTATS Stats = {0};
+                                STATESTATS State = {0};
+                                ARENASTATS Arena = {0};
                                 size_t nConverted = 0;
 
                                 // to save performance, only update the window title once a second
-                                // also, place the OGL version information in the title bar
+                                // also, place the OGL version information in the title bar, along with the
+                                // 99th percentile frame time since the frame rate alone hides any stutter, how many
+                                // of the last frame's state changes the state cache dropped, and how much of the arena it used
                                 mbstowcs_s(&nConverted, szVersion, MAX_LOADSTRING, (const char *)glGetString(GL_VERSION), MAX_LOADSTRING);
-                                wsprintf(szBuff, _T("OpenGL %s - %hu FPS"), szVersion, nFPS);
+                                GetFrameStats(PROFILE_FRAME, &Stats);
+                                GetStateStats(&State, NULL);
+                                GetArenaStats(&Arena);
+                                _stprintf_s(szBuff, STRING_SIZE(szBuff), _T("OpenGL %s - %hu FPS - %.2f ms p99 - %I64u of %I64u state calls skipped - %Iu KB arena"),
+                                    szVersion, nFPS, Stats.dP99, State.nSkipped, State.nIssued + State.nSkipped, Arena.nUsed / 1024);
                                 SetWindowText(pArgList->hWnd, szBuff);
 
                                 nFPS = 0;
@@ -160,16 +450,73 @@ RenderMain (const PRENDERARGS pArgList)
                         }
                     }
                 #endif
+
+                // don't draw frames faster than asked for, the wait sleeps rather than spinning a core
+                WaitFrameLimiter(&Limiter);
             }
             else
             {
-                // in order to keep the timed-based counter current, call this if we're paused
-                dLastTime = GetCPUTicks();
+                // nothing is drawn while paused, so sleep until the next command comes in rather than spin
+                // then in order to keep the timed-based counter current, call this once we're awake
+                WaitForSingleObject(pContext->hWakeEvent, INFINITE);
+                dLastTime = GetClockSeconds();
             }
         }
+        else
+        {
+            // likewise nothing is drawn while minimized, restoring the window sends a resize command
+            WaitForSingleObject(pContext->hWakeEvent, INFINITE);
+            dLastTime = GetClockSeconds();
+        }
+    }
+
+    // a render thread that stopped before it was warmed up still has to let the others through
+    if(nWarmup > 0) __endWarmup(pArgList->nContexts);
+
+    // the capture is done once the last frame has been drawn (only the first render thread captures or replays)
+    if(pArgList->nContext == 0)
+    {
+        StopCapture();
+        FreeReplay();
     }
 
     // clean-up (OGL and wiggle specific items)
+    __killRender(pArgList);
+    DestroyFrameLimiter(&Limiter);
+
+    // the last render thread to be done reports on all of them, together they drew every frame they measured
+    // in the time the slowest of them took (the frame timings are shared, they already cover every thread)
+    pContext->nFrames = nFrames;
+    pContext->dSeconds = (nFrames > 0) ? (dShownTime - dFirstTime) : 0.0;
+    pContext->dScale = (nFrames > 0) ? (dScaled / nFrames) : 1.0;
+    bLast = (InterlockedIncrement(&_nFinished) >= (LONG)pArgList->nContexts);
+
+    if(bLast)
+    {
+        for(i = 0; (i < pArgList->nContexts) && (i < CONFIG_MAX_CONTEXTS); i++)
+        {
+            nTotal += _aContexts[i].nFrames;
+            if(_aContexts[i].dSeconds > dSlowest) dSlowest = _aContexts[i].dSeconds;
+        }
+
+        // dump the frame timings of the whole run, if any were asked for
+        if((nTotal > 0) && (pArgList->szStats[0] != _T('\0'))) WriteFrameStats(pArgList->szStats);
+    }
+
+    if(pArgList->bOffscreen)
+    {
+        if(bLast && (nTotal > 0))
+        {
+            __writeResults(pArgList, nTotal, dSlowest);
+            __writeBenchmark(pArgList, nTotal, dSlowest);
+        }
+        DestroyOffscreen(&Offscreen);
+
+        // nobody sees the window when headless, so we are the ones who decide when the app is done
+        if(bLast) PostMessage(pArgList->hWnd, WM_CLOSE, 0, 0);
+    }
+
+    DestroyExtensions();
     wglMakeCurrent(NULL, NULL);
     wglDeleteContext(hRC);
 
@@ -212,9 +559,9 @@ __initRender (const PRENDERARGS pArgList)
 
         // set-up the depth buffer
         glClearDepth(1.0f);
-        glEnable(GL_DEPTH_TEST);
-        glDepthMask(true);
-        glDepthFunc(GL_LEQUAL);
+        SetEnabled(GL_DEPTH_TEST, true);
+        SetDepthMask(true);
+        SetDepthFunc(GL_LEQUAL);
 
         // set up one-byte alignment for pixel storage (saves memory)
         glPixelStorei(GL_PACK_ALIGNMENT, 1);
@@ -228,15 +575,359 @@ __initRender (const PRENDERARGS pArgList)
         glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
 
         // use lighting
-        glEnable(GL_LIGHTING);
-        glEnable(GL_LIGHT0);
+        SetEnabled(GL_LIGHTING, true);
+        SetEnabled(GL_LIGHT0, true);
         glLightfv(GL_LIGHT0, GL_POSITION, LightPos);
 
+        // build the GLSL stand-in for the lighting above, and any program after it, from the binary cache if we can
+        // (only the first render thread keeps the cache, so no two of them ever write the file at once)
+        InitShaders((pArgList->nContext == 0) ? CONFIG_SHADER_CACHE : NULL);
+
+        // time each stage of the frame on the GPU too, if it can be done
+        InitGPUTimers();
+
+        // vertex data that changes every frame is written into a ring the GL draws from, mapped for good if it can be
+        InitStream(CONFIG_STREAM_SIZE);
+
+        // start the worker threads the delegates can spread their preparation work across, the other render
+        // threads run their jobs themselves, as they already keep the cores busy between them
+        if(pArgList->nContext == 0) InitJobs(CONFIG_JOB_WORKERS);
+
+        // whatever a frame needs only while it's drawn comes out of the frame arena, each job thread has its own
+        // part of it, and a frame's memory is kept for as many frames as are in flight before it's reused
+        InitFrameArena(CONFIG_ARENA_SIZE, CONFIG_ARENA_FRAMES);
+
+        // files are read and decoded on a thread of their own, the backdrop shows up once it has been uploaded
+        if((pArgList->nContext == 0) && InitLoader() && (pArgList->szBackdrop[0] != _T('\0')))
+            RequestLoad(pArgList->szBackdrop, LOAD_TEXTURE, __onBackdrop, _pContext);
+
         ///// THIS IS WHERE THE MAIN RENDER ROUTINE IS SET //////
+        __initScene(pArgList);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /
+/ / PURPOSE:
+/ /     Sets the main render delegate to be the scene pArgList->nScene asks for, and builds its geometry.
+/ /     This is called once by __initRender() and again every time the scene is switched.
+/ /
+/ / NOTES:
+/ /        This must be called in the context of the render thread.
+/*/
+
+static void
+__initScene (const PRENDERARGS pArgList)
+{
+    _pContext->pRenderFrame = NULL;
+
+    // the software rasterizer stands in for the GL's own, it draws the triforce whichever scene was asked for
+    if(pArgList->bSoftware && InitTriforceSoftware()) _pContext->pRenderFrame = TriforceSoftwarePrimitive;
+    else switch(pArgList->nScene)
+    {
+        case SCENE_FIELD:
+
+            // a field of triforces drawn with instancing
+            if(InitTriforceField(pArgList->nInstances)) _pContext->pRenderFrame = TriforceFieldPrimitive;
+            break;
+
+        case SCENE_SCATTER:
+
+            // a crowd of triforces all around the eye, only the ones in view are drawn
+            if(InitTriforceScatter(pArgList->nInstances)) _pContext->pRenderFrame = TriforceScatterPrimitive;
+            break;
+
+        case SCENE_MODEL:
+
+            // a mesh file made by /convert, drawn straight from the mapped file
+            if(InitModel(pArgList->szMesh)) _pContext->pRenderFrame = ModelPrimitive;
+            break;
+    }
+
+    // the triforce is the default scene, and what's shown if the GL can't draw the one asked for
+    if(_pContext->pRenderFrame == NULL)
+    {
+        InitTriforce(pArgList->bRetained);
+        _pContext->pRenderFrame = TriforcePrimitive;
+    }
+
+    _pContext->pUpdateFrame = (_pContext->pRenderFrame == ModelPrimitive) ? ModelUpdate : TriforceUpdate;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /
+/ / PURPOSE:
+/ /     This routine releases whatever __initRender() created for the render delegate.
+/ /     This should only be called once, after the main render loop has ended.
+/ /
+/ / NOTES:
+/ /        This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+static void
+__killRender (const PRENDERARGS pArgList)
+{
+    __killScene();
+    if(pArgList->nContext == 0) DestroyLoader();
 
-        // set the main render delegate to be the triforce
-        _pRenderFrame = TriforcePrimitive;
+    if(_pContext->nBackdrop != 0)
+    {
+        SetTexture(GL_TEXTURE_2D, 0);
+        glDeleteTextures(1, &_pContext->nBackdrop);
+        _pContext->nBackdrop = 0;
     }
+
+    DestroyShaders();
+    DestroyScaling();
+    DestroyGPUTimers();
+    DestroyStream();
+    DestroyFrameArena();
+    if(pArgList->nContext == 0) DestroyJobs();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     This routine releases whatever __initScene() created for the render delegate.
+/ /
+/ / NOTES:
+/ /        This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+static void
+__killScene (void)
+{
+    if((_pContext->pRenderFrame == TriforcePrimitive) || (_pContext->pRenderFrame == TriforceFieldPrimitive) ||
+       (_pContext->pRenderFrame == TriforceScatterPrimitive) || (_pContext->pRenderFrame == TriforceSoftwarePrimitive))
+        DestroyTriforce();
+    else if(_pContext->pRenderFrame == ModelPrimitive)
+        DestroyModel();
+
+    _pContext->pRenderFrame = NULL;
+    _pContext->pUpdateFrame = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Draws the backdrop texture over the whole viewport, behind whatever the render delegate draws.
+/ /
+/ / NOTES:
+/ /        This must be called in the context of the render thread, right after the frame is cleared.
+/*/
+
+static void
+__drawBackdrop (void)
+{
+    // the quad is given in clip space, so neither matrix nor the depth buffer nor the lights take part
+    SetEnabled(GL_DEPTH_TEST, false);
+    SetEnabled(GL_LIGHTING, false);
+    SetEnabled(GL_TEXTURE_2D, true);
+    SetTexture(GL_TEXTURE_2D, _pContext->nBackdrop);
+    SetColor(255, 255, 255, 255);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, -1.0f);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, 1.0f);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, 1.0f);
+    glEnd();
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    SetEnabled(GL_TEXTURE_2D, false);
+    SetEnabled(GL_LIGHTING, true);
+    SetEnabled(GL_DEPTH_TEST, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pResult = what the load came to
+/ /     pContext = context of the render thread that asked for the backdrop
+/ /
+/ / PURPOSE:
+/ /     Takes the backdrop texture once the loader has uploaded it. If it couldn't be loaded there's no backdrop.
+/*/
+
+static void
+__onBackdrop (const LOADRESULT *pResult, void *pContext)
+{
+    ((PRENDERCONTEXT)pContext)->nBackdrop = pResult->nName;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /     nFrames = number of frames that were rendered, by every render thread together
+/ /     dSeconds = how long it took to render them (the longest any render thread took)
+/ /
+/ / PURPOSE:
+/ /     Appends one line of comma separated values describing a headless run to the results file. The
+/ /     column names are written first if the file is new, so several runs can be compared side by side.
+/*/
+
+static void
+__writeResults (const PRENDERARGS pArgList, DWORD nFrames, double dSeconds)
+{
+    static const LPCTSTR szScenes[] = SCENE_NAMES;
+    FILE *pFile = NULL;
+    FRAMESTATS Stats = {0};
+    STATESTATS State = {0};
+    ARENASTATS Arena = {0};
+    SCENE nScene = pArgList->bSoftware ? SCENE_TRIFORCE : pArgList->nScene;    // the software rasterizer only draws the triforce
+
+    if((pArgList->szResults[0] == _T('\0')) || (dSeconds <= 0.0)) return;
+
+    if(_tfopen_s(&pFile, pArgList->szResults, _T("a")) == 0)
+    {
+        fseek(pFile, 0, SEEK_END);
+        if(ftell(pFile) == 0) _ftprintf(pFile, _T("scene,instances,width,height,frames,seconds,fps,p50_ms,p95_ms,p99_ms,max_ms,state_calls,state_skipped,arena_peak_kb,contexts,rasterizer\n"));
+
+        // the state counts are written as averages per frame
+        GetFrameStats(PROFILE_FRAME, &Stats);
+        GetStateStats(NULL, &State);
+        GetArenaStats(&Arena);
+        if(State.nFrames == 0) State.nFrames = 1;
+
+        _ftprintf(pFile, _T("%s,%u,%u,%u,%lu,%.4f,%.2f,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.1f,%u,%s\n"), szScenes[nScene],
+            (nScene == SCENE_TRIFORCE) ? 3 : ((nScene == SCENE_MODEL) ? 1 : pArgList->nInstances), pArgList->nWidth, pArgList->nHeight,
+            nFrames, dSeconds, nFrames / dSeconds, Stats.dP50, Stats.dP95, Stats.dP99, Stats.dMax,
+            (double)(State.nIssued + State.nSkipped) / State.nFrames, (double)State.nSkipped / State.nFrames, Arena.nPeak / 1024.0, pArgList->nContexts,
+            pArgList->bSoftware ? _T("software") : _T("gl"));
+
+        fclose(pFile);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /     nFrames = number of frames that were rendered by every render thread together, not counting the warm-up
+/ /     dSeconds = how long it took to render them (the longest any render thread took)
+/ /
+/ / PURPOSE:
+/ /     Writes everything a headless run measured to the benchmark file as a single JSON object: what was drawn
+/ /     and on what, the frame rate, the percentiles of every frame timing channel, the state changes per frame
+/ /     and the peak memory use of the process (and of the frame arena). The file is overwritten.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+static void
+__writeBenchmark (const PRENDERARGS pArgList, DWORD nFrames, double dSeconds)
+{
+    static const LPCTSTR szScenes[] = SCENE_NAMES;
+    static const LPCTSTR szChannels[] = PROFILE_NAMES;
+    static const LPCTSTR szClocks[] = CLOCK_NAMES;
+    PROCESS_MEMORY_COUNTERS Memory = {0};
+    FILE *pFile = NULL;
+    FRAMESTATS Stats = {0};
+    STATESTATS State = {0};
+    ARENASTATS Arena = {0};
+    SCENE nScene = pArgList->bSoftware ? SCENE_TRIFORCE : pArgList->nScene;    // the software rasterizer only draws the triforce
+    double dScale = 0.0;
+    unsigned int i = 0;
+
+    if((pArgList->szBenchmark[0] == _T('\0')) || (dSeconds <= 0.0)) return;
+
+    // the resolution scale is averaged over every frame measured, whichever render thread drew it
+    for(i = 0; (i < pArgList->nContexts) && (i < CONFIG_MAX_CONTEXTS); i++) dScale += _aContexts[i].dScale * _aContexts[i].nFrames;
+    dScale = (nFrames > 0) ? (dScale / nFrames) : 1.0;
+
+    if(_tfopen_s(&pFile, pArgList->szBenchmark, _T("w")) == 0)
+    {
+        // the state counts are written as averages per frame
+        GetStateStats(NULL, &State);
+        GetArenaStats(&Arena);
+        if(State.nFrames == 0) State.nFrames = 1;
+
+        Memory.cb = sizeof(Memory);
+        GetProcessMemoryInfo(GetCurrentProcess(), &Memory, sizeof(Memory));
+
+        _ftprintf(pFile, _T("{\n    \"scene\": \"%s\",\n    \"instances\": %u,\n    \"width\": %u,\n    \"height\": %u,\n    \"contexts\": %u,\n"), szScenes[nScene],
+            (nScene == SCENE_TRIFORCE) ? 3 : ((nScene == SCENE_MODEL) ? 1 : pArgList->nInstances), pArgList->nWidth, pArgList->nHeight, pArgList->nContexts);
+
+        // the GL only puts the image on screen when the software rasterizer draws the frames
+        _ftprintf(pFile, _T("    \"rasterizer\": \"%s\",\n    \"clock\": \"%s\",\n"), pArgList->bSoftware ? _T("software") : _T("gl"),
+            szClocks[GetClockSource()]);
+        _ftprintf(pFile, _T("    \"budget_ms\": %u,\n    \"resolution_scale\": %.3f,\n    \"renderer\": "), pArgList->nBudget, dScale);
+        __writeJSONString(pFile, (const char *)glGetString(GL_RENDERER));
+        _ftprintf(pFile, _T(",\n    \"version\": "));
+        __writeJSONString(pFile, (const char *)glGetString(GL_VERSION));
+
+        _ftprintf(pFile, _T(",\n    \"warmup_frames\": %lu,\n    \"frames\": %lu,\n    \"seconds\": %.4f,\n    \"fps\": %.2f,\n    \"timings\": {\n"),
+            pArgList->nWarmup, nFrames, dSeconds, nFrames / dSeconds);
+
+        for(i = 0; i < PROFILE_COUNT; i++)
+        {
+            GetFrameStats((PROFILE)i, &Stats);
+            _ftprintf(pFile, _T("        \"%s\": {\"count\": %I64u, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}%s\n"),
+                szChannels[i], Stats.nCount, Stats.dMean, Stats.dP50, Stats.dP95, Stats.dP99, Stats.dMax, (i < (PROFILE_COUNT - 1)) ? _T(",") : _T(""));
+        }
+
+        _ftprintf(pFile, _T("    },\n    \"state_calls_per_frame\": %.2f,\n    \"state_skipped_per_frame\": %.2f,\n"),
+            (double)(State.nIssued + State.nSkipped) / State.nFrames, (double)State.nSkipped / State.nFrames);
+
+        _ftprintf(pFile, _T("    \"memory\": {\"peak_working_set_kb\": %Iu, \"peak_pagefile_kb\": %Iu, \"arena_peak_kb\": %.1f}\n}\n"),
+            Memory.PeakWorkingSetSize / 1024, Memory.PeakPagefileUsage / 1024, Arena.nPeak / 1024.0);
+
+        fclose(pFile);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pFile = file to write to
+/ /     szString = string to write (may be NULL)
+/ /
+/ / PURPOSE:
+/ /     Writes a string as a quoted JSON string, anything that would need escaping (quotes, backslashes and
+/ /     control characters) is replaced by a question mark, as the strings the GL reports are only for reading.
+/*/
+
+static void
+__writeJSONString (FILE *pFile, const char *szString)
+{
+    _fputtc(_T('"'), pFile);
+
+    // this does not support Unicode, but the GL only ever reports ASCII
+    for(; (szString != NULL) && (*szString != '\0'); szString++)
+        _fputtc(((*szString == '"') || (*szString == '\\') || ((BYTE)*szString < 0x20)) ? _T('?') : (TCHAR)*szString, pFile);
+
+    _fputtc(_T('"'), pFile);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -266,13 +957,10 @@ __onResizeFrame (HWND hWnd, unsigned int nWidth, unsigned int nHeight)
     // (re)size the viewport to consume the entire client area
     glViewport(0, 0, nWidth, nHeight);
 
-    // reset the projection matrix
+    // (re)calculate the aspect ratio of the viewport (0,0 is bottom left) and upload the finished projection
+    SetPerspective(&_pContext->Projection, 45.0f, (float)nWidth / (float)nHeight, 1.0f, 100.0f);
     glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-
-    // (re)calculate the aspect ratio of the viewport (0,0 is bottom left)
-    //glOrtho(0.0f, nWidth, 0.0f, nHeight, 0.0f, 1.0f);
-    gluPerspective(45.0f, (float)nWidth / (float)nHeight, 1.0f, 100.0f);
+    glLoadMatrixf(_pContext->Projection.m);
 
     // lastly, reset the modelview matrix
     glMatrixMode(GL_MODELVIEW);
@@ -282,41 +970,173 @@ __onResizeFrame (HWND hWnd, unsigned int nWidth, unsigned int nHeight)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /*/
-/ / void
-/ /        ThreadProc (UINT uMsg, WPARAM wParam, LPARAM lParam)
-/ /
-/ /        uMsg = message to process
-/ /        wParam = word sized parameter who's value depends on the message
-/ /        lParam = long sized parameter who's value depends on the message
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /     pClient = coordinates of the area safe to draw on, updated by resize commands
+/ /     pCommand = command to carry out
 / /
 / / PURPOSE:
-/ /        Procedure to handle messages for this thread.
+/ /     Carries out a single command, whether it was queued with PostRenderCommand() or comes from a replay.
+/ /
+/ / NOTES:
+/ /        This must be called in the context of the render thread.
 /*/
 
 static void
-__threadProc (UINT uMsg, WPARAM wParam, LPARAM lParam)
+__runCommand (const PRENDERARGS pArgList, PRECT pClient, const RENDERCOMMAND *pCommand)
 {
-    switch(uMsg)
+    // a capture keeps whatever changes what the frames after it draw
+    CaptureCommand(pCommand);
+
+    switch(pCommand->nCommand)
     {
-        case UWM_PAUSE:
+        case RENDER_PAUSE:
 
             // notification that we should either pause or resume rendering
-            _bPaused = (bool)wParam;
+            _pContext->bPaused = pCommand->Data.bPaused;
             break;
 
-        case UWM_RESIZE:
+        case RENDER_RESIZE:
 
-            // notification that viewport(s) need(s) to be resized
-            _bResizeFrame = true;
+            // notification that viewport(s) need(s) to be resized, the offscreen target never is
+            if(!pArgList->bOffscreen)
+            {
+                SetRect(pClient, 0, 0, pCommand->Data.Size.nWidth, pCommand->Data.Size.nHeight);
+                _pContext->bResize = true;
+            }
             break;
 
-        case UWM_STOP:
+        case RENDER_STOP:
 
             // notification that we should stop the render thread from executing
-            _bStopRenderThread = true;
+            _pContext->bStop = true;
+            break;
+
+        case RENDER_SCENE:
+
+            // notification that another scene is to be drawn, so swap out the delegate
+            if((pCommand->Data.nScene < SCENE_COUNT) && (pCommand->Data.nScene != pArgList->nScene))
+            {
+                __killScene();
+                pArgList->nScene = pCommand->Data.nScene;
+                __initScene(pArgList);
+            }
+            break;
+
+        case RENDER_VSYNC:
+
+            // notification that vsync is to be turned on or off
+            SetVerticalSync(pCommand->Data.bVSync);
+            pArgList->bVSync = pCommand->Data.bVSync ? yes : no;
             break;
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArgList = pointer to argument structure that the render thread received
+/ /     pClient = coordinates of the area safe to draw on, updated by resize commands
+/ /
+/ / PURPOSE:
+/ /     Carries out every command queued with PostRenderCommand() since the last time this was called.
+/ /
+/ / NOTES:
+/ /        While a capture is replayed only pausing and stopping are taken from the queue, the rest come from
+/ /        the capture so the frames it draws are the ones that were captured.
+/ /        This must be called in the context of the render thread.
+/*/
+
+static void
+__runCommands (const PRENDERARGS pArgList, PRECT pClient)
+{
+    RENDERCOMMAND Command = {0};
+
+    while(PopQueueItem(&_pContext->Commands, &Command))
+    {
+        if(IsReplaying() && (Command.nCommand != RENDER_PAUSE) && (Command.nCommand != RENDER_STOP)) continue;
+        __runCommand(pArgList, pClient, &Command);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nContext = which render thread's context to return
+/ /
+/ / PURPOSE:
+/ /     Returns what a render thread keeps about its context, setting up every context the first time.
+/ /
+/ / NOTES:
+/ /        The main thread may send commands before any render thread has started, so either may be the first
+/ /        to need a context, whichever gets here first sets them all up while the other waits for it. The
+/ /        wake events are auto-reset events, so a command queued between a render thread emptying its queue
+/ /        and going to sleep still wakes it right away. They live as long as the process.
+/*/
+
+static PRENDERCONTEXT
+__getContext (UINT nContext)
+{
+    unsigned int i = 0;
+
+    if(_nContextsSet != 2)
+    {
+        if(InterlockedCompareExchange(&_nContextsSet, 1, 0) == 0)
+        {
+            for(i = 0; i < CONFIG_MAX_CONTEXTS; i++)
+            {
+                _aContexts[i].Commands.nCapacity = (LONG)(sizeof(_aContexts[i].aCommands) / sizeof(_aContexts[i].aCommands[0]));
+                _aContexts[i].Commands.nItemSize = sizeof(_aContexts[i].aCommands[0]);
+                _aContexts[i].Commands.pItems = (BYTE *)_aContexts[i].aCommands;
+                _aContexts[i].hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+            }
+
+            // the render threads all wait on this at the end of their warm-up, so it stays set once it's set
+            _hWarmedUp = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+            InterlockedExchange(&_nContextsSet, 2);
+        }
+        else
+        {
+            while(_nContextsSet != 2) YieldProcessor();
+        }
+    }
+
+    return &_aContexts[(nContext < CONFIG_MAX_CONTEXTS) ? nContext : 0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nContexts = number of render threads drawing at once
+/ /
+/ / PURPOSE:
+/ /     Throws away what the calling render thread measured so far, at the end of its warm-up (or before its
+/ /     first frame if it has none). The frame timings are shared by every render thread, so every one of them
+/ /     waits here until the last is warmed up, which is the one that starts them over; nothing is measured by
+/ /     any thread before that, and none records a time while they're being cleared.
+/ /
+/ / NOTES:
+/ /        The state counts are kept per thread, so each thread starts its own over once it's let through.
+/ /        A render thread that stops before its warm-up is done must still come here, or the others wait forever.
+/*/
+
+static void
+__endWarmup (UINT nContexts)
+{
+    if(InterlockedIncrement(&_nWarmedUp) >= (LONG)nContexts)
+    {
+        ResetFrameTimes();
+        SetEvent(_hWarmedUp);
+    }
+    else
+        WaitForSingleObject(_hWarmedUp, INFINITE);
+
+    ResetStateStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -5,28 +5,82 @@
 
 // delegate function to be called when a frame needs to be rendered
 // it will be called in the context of the RC that requires it
-typedef void (*RenderDelegate) (const double dElapsed, const unsigned int nWidth, const unsigned int nHeight);
+typedef void (*RenderDelegate) (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+
+// delegate function to be called when the scene needs to be animated by one fixed step
+// it will be called in the context of the render thread, but nothing should be drawn in it
+typedef void (*UpdateDelegate) (const double dStep);
+
+// scenes (render delegates) the render thread can be asked to draw, the names are used by the /scene switch
+typedef enum {SCENE_TRIFORCE = 0, SCENE_FIELD, SCENE_SCATTER, SCENE_MODEL, SCENE_COUNT} SCENE;
+#define SCENE_NAMES {_T("triforce"), _T("field"), _T("scatter"), _T("model")}
 
 // needed to pass multiple arguments when creating a worker thread
 typedef struct
 {
     tribool bVSync;                 // flag to indicate if we enable or disable or leave alone vsync
     HWND    hWnd;                   // handle to the calling window
-    HDC     hDC;                    // handle to the device context of the client area of the calling window
+    HDC     hDC;                    // handle to the device context of the client area of the calling window (or of a hidden
+                                    // window of its own, for every render thread after the first)
     BYTE    nBPP;                   // bits per pixel the application is trying to use (ignored if windowed)
     BYTE    nRefresh;               // vertical refresh rate of the display in hertz (ignored if windowed)
     bool    bFullscreen;            // flag to indicate to the thread if we are in fullscreen mode
     bool    bZoomed;                // flag to indicate to the thread if we are to maximize the main window
+    bool    bOffscreen;             // flag to indicate to the thread to render headless into an offscreen target
+    UINT    nWidth;                 // width of the offscreen target in pixels (ignored if not offscreen)
+    UINT    nHeight;                // height of the offscreen target in pixels (ignored if not offscreen)
+    DWORD   nFrames;                // number of frames to render before stopping (zero means no limit)
+    DWORD   nSeconds;               // number of seconds to render for before stopping (zero means no limit)
+    DWORD   nWarmup;                // number of frames drawn before anything is measured (and before nFrames counts)
+    UINT    nTargetFPS;             // number of frames per second to limit rendering to (zero means no limit)
+    UINT    nUpdateRate;            // number of fixed steps per second the scene is animated with
+    UINT    nBudget;                // milliseconds a frame may take before its resolution is lowered (zero means always full)
+    bool    bRetained;              // flag to indicate if primitives are drawn from buffer objects (retained mode)
+    bool    bSoftware;              // flag to indicate the triforce is drawn by the software rasterizer (whatever the scene)
+    SCENE   nScene;                 // which scene (render delegate) to draw
+    UINT    nInstances;             // number of instances to draw (ignored unless the scene uses instancing)
+    TCHAR   szResults[MAX_PATH];    // file a headless run appends its frame rate to (ignored if empty)
+    TCHAR   szStats[MAX_PATH];      // base name of the frame timing files written on exit (ignored if empty)
+    TCHAR   szBenchmark[MAX_PATH];  // file the measurements of a headless run are written to as JSON (ignored if empty)
+    TCHAR   szBackdrop[MAX_PATH];   // bitmap streamed in and drawn behind every scene (ignored if empty)
+    TCHAR   szMesh[MAX_PATH];       // binary mesh file the model scene draws (ignored unless the scene is the model)
+    TCHAR   szCapture[MAX_PATH];    // file every frame's inputs are captured to (ignored if empty)
+    TCHAR   szReplay[MAX_PATH];     // capture the frames are replayed from, already read by LoadReplay() (ignored if empty)
+    UINT    nContext;               // which render thread this is, zero for the one that owns the jobs, loader and capture
+    UINT    nContexts;              // number of render threads drawing at once, each into a context of its own
 
 }  RENDERARGS, *PRENDERARGS;
 
+// commands another thread can send a render thread with PostRenderCommand()
+typedef enum {RENDER_PAUSE = 0, RENDER_RESIZE, RENDER_STOP, RENDER_SCENE, RENDER_VSYNC} RENDERCMD;
+
+typedef struct
+{
+    RENDERCMD nCommand;             // what the render thread is asked to do
+
+    union
+    {
+        bool  bPaused;              // RENDER_PAUSE: true to pause rendering, false to resume it
+        SCENE nScene;               // RENDER_SCENE: scene (render delegate) to switch to
+        bool  bVSync;               // RENDER_VSYNC: true to enable vsync, false to disable it
+
+        struct
+        {
+            UINT nWidth;            // RENDER_RESIZE: new width of the client area in pixels
+            UINT nHeight;           // RENDER_RESIZE: new height of the client area in pixels
+
+        }  Size;
+
+    }  Data;
+
+}  RENDERCOMMAND, *PRENDERCOMMAND;
+
 // function prototypes
+void GetProjection     (float afMatrix[16]);
+bool PostRenderCommand (UINT nContext, const RENDERCOMMAND *pCommand);
 unsigned int __stdcall RenderMain (const PRENDERARGS pArgList);
 
 // user defined window messages the render thread uses to communicate
-#define UWM_PAUSE   (WM_APP + 1)
-#define UWM_RESIZE  (WM_APP + 2)
 #define UWM_SHOW    (WM_APP + 3)
-#define UWM_STOP    (WM_APP + 4)
 
 #endif  // RENDER_H
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "Main\Application.h"       // standard application include
+#include "Primitives\Model.h"       // include for this file
+#include "Utility\Mesh.h"           // binary mesh routines
+#include "Utility\State.h"          // render state routines
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////// MESH FILE PRIMITIVE ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define MODEL_DEPTH     -35.0f      // distance of the center of the model from the eye
+#define MODEL_SIZE      16.0f       // size the longest side of the model's box is scaled to
+
+// diffuse colors the submeshes are drawn with in turn, the files only name their materials
+static const GLfloat _Palette[][4] = {{0.86f, 0.74f, 0.14f, 1.0f}, {0.25f, 0.55f, 0.85f, 1.0f}, {0.80f, 0.30f, 0.25f, 1.0f},
+                                      {0.35f, 0.70f, 0.35f, 1.0f}, {0.75f, 0.75f, 0.75f, 1.0f}};
+
+// local variables (kept per thread, as each render thread draws a scene of its own)
+static __declspec(thread) MESH     _Mesh        = {0};     // mapped mesh file, and its buffer objects if it was uploaded
+static __declspec(thread) GLfloat  _afCenter[3] = {0};     // center of the box around the mesh
+static __declspec(thread) GLfloat  _fScale      = 1.0f;    // uniform scale that makes the mesh MODEL_SIZE across
+static __declspec(thread) GLdouble _dAngle      = 0.0;     // angle (in degrees) the model is at after the last update
+static __declspec(thread) GLdouble _dLastAngle  = 0.0;     // angle the model was at before the last update
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szMesh = path of the binary mesh file to draw (see ConvertMesh())
+/ /
+/ / PURPOSE:
+/ /     Maps a binary mesh file and uploads it into buffer objects straight from the view, then sets up the vertex
+/ /     arrays to draw from them. Without buffer objects the arrays point into the mapped file instead. Returns
+/ /     false if the file couldn't be opened, ModelPrimitive() must not be used then.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, before ModelPrimitive() is.
+/*/
+
+bool
+InitModel (LPCTSTR szMesh)
+{
+    const MESHHEADER *pHeader = NULL;
+    GLfloat fSize = 0.0f;
+    int i = 0;
+
+    if(!OpenMesh(szMesh, &_Mesh)) return false;
+
+    UploadMesh(&_Mesh);
+    BindMesh(&_Mesh, true);
+
+    // center the model and fit it to the same space the triforce takes up
+    pHeader = _Mesh.pHeader;
+    for(i = 0; i < 3; i++)
+    {
+        _afCenter[i] = (pHeader->afMin[i] + pHeader->afMax[i]) * 0.5f;
+        if((pHeader->afMax[i] - pHeader->afMin[i]) > fSize) fSize = pHeader->afMax[i] - pHeader->afMin[i];
+    }
+
+    _fScale = (fSize > 0.0f) ? (MODEL_SIZE / fSize) : 1.0f;
+
+    // the scale would shrink or stretch the normals along with the model
+    SetEnabled(GL_NORMALIZE, true);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Takes down the vertex arrays set up by InitModel(), and releases the mesh and its buffer objects.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, before the RC is destroyed.
+/*/
+
+void
+DestroyModel (void)
+{
+    if(_Mesh.pHeader == NULL) return;
+
+    SetEnabled(GL_NORMALIZE, false);
+    BindMesh(&_Mesh, false);
+    CloseMesh(&_Mesh);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAlpha =   how far (from 0.0 to 1.0) the frame is between the last two updates, we use this
+/ /                to blend their states so motion stays smooth whatever the frame rate is
+/ /     nWidth =   width of the render context in which to draw on
+/ /     nHeight =  height of the render context in which to draw on
+/ /
+/ / PURPOSE:
+/ /     This draws the mesh on the main render context within the scope of the render thread, one indexed
+/ /     draw call per submesh, each in the next color of the palette.
+/*/
+
+void
+ModelPrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight)
+{
+    GLdouble x = _dLastAngle + ((_dAngle - _dLastAngle) * dAlpha);
+    DWORD i = 0;
+
+    glLoadIdentity();
+    glTranslatef(0.0f, 0.0f, MODEL_DEPTH);
+    glRotated(x, 0.0, 1.0, 0.0);
+    glScalef(_fScale, _fScale, _fScale);
+    glTranslatef(-_afCenter[0], -_afCenter[1], -_afCenter[2]);
+
+    for(i = 0; i < _Mesh.pHeader->nSubmeshes; i++)
+    {
+        SetMaterial(GL_FRONT, GL_DIFFUSE, _Palette[i % (sizeof(_Palette) / sizeof(_Palette[0]))]);
+        DrawSubmesh(&_Mesh, i);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dStep = how many seconds of animation to advance by, this is always the same amount
+/ /
+/ / PURPOSE:
+/ /     This turns the model by one fixed step, at the same rate the triforce turns.
+/*/
+
+void
+ModelUpdate (const double dStep)
+{
+    _dLastAngle = _dAngle;
+    _dAngle += 45.0 * dStep;
+
+    // keep both angles in range together, so blending between them never goes the long way around
+    if(_dAngle >= 360.0)
+    {
+        _dAngle -= 360.0;
+        _dLastAngle -= 360.0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,9 @@
+#if !defined (MODEL_H_9C41E7B2_3D6A_4F85_A02E_71B5C8D39E64_)
+#define MODEL_H_9C41E7B2_3D6A_4F85_A02E_71B5C8D39E64_
+
+bool InitModel      (LPCTSTR szMesh);
+void DestroyModel   (void);
+void ModelPrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+void ModelUpdate    (const double dStep);
+
+#endif  // MODEL_H
@@ -1,15 +1,479 @@
 #include "Main\Application.h"       // standard application include
 #include "Main\Render.h"            // include for this file
 #include "Primitives\Triforce.h"    // include for this file
+#include "Utility\Arena.h"          // frame arena routines
+#include "Utility\Graphical.h"      // graphical utility routines
+#include "Utility\VecMath.h"        // vector math routines
+#include "Utility\Culling.h"        // view frustum culling
+#include "Utility\DrawQueue.h"      // sorted draw submission
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\Instancing.h"     // instanced rendering
+#include "Utility\Jobs.h"           // job routines
+#include "Utility\Profile.h"        // frame timing routines
+#include "Utility\Raster.h"         // software rasterization routines
+#include "Utility\Shader.h"         // shader program routines
+#include "Utility\State.h"          // render state routines
+#include "Utility\Timing.h"         // timing routines
+#include <math.h>                   // sqrt(), ceil(), etc.
+#include <stddef.h>                 // offsetof()
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////// LEGEEND OF ZELDA TRIFORCE PRIMITIVE /////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// layout of a single vertex in the retained mesh, interleaved so one buffer feeds all the arrays
+// (it's also the layout of RASTERVERTEX, so the software rasterizer draws from the same array)
+typedef struct
+{
+    GLfloat afPosition[3];          // object space position
+    GLfloat afNormal[3];            // face normal, vertices are not shared between faces
+    GLubyte acColor[4];             // diffuse color (fed to the material through GL_COLOR_MATERIAL)
+
+}  TRIFORCEVERTEX;
+
+// one piece of the triforce, the same geometry the immediate mode path submits, the two triangles are
+// yellow and the two side quads are dark yellow, the quads are split into triangles for the index buffer
+static const TRIFORCEVERTEX _Vertices[] =
+{
+    {{-5, -5, -1}, { 0,  0, -1}, {220, 190, 35, 255}},     // front left
+    {{ 0,  5, -1}, { 0,  0, -1}, {220, 190, 35, 255}},     // front top
+    {{ 5, -5, -1}, { 0,  0, -1}, {220, 190, 35, 255}},     // front right
+    {{-5, -5,  1}, { 0,  0,  1}, {220, 190, 35, 255}},     // back left
+    {{ 0,  5,  1}, { 0,  0,  1}, {220, 190, 35, 255}},     // back top
+    {{ 5, -5,  1}, { 0,  0,  1}, {220, 190, 35, 255}},     // back right
+
+    {{-5, -5, -1}, {-1,  0,  0}, {200, 150,  0, 255}},     // left side bottom left
+    {{ 0,  5, -1}, {-1,  0,  0}, {200, 150,  0, 255}},     // left side top left
+    {{ 0,  5,  1}, {-1,  0,  0}, {200, 150,  0, 255}},     // left side top right
+    {{-5, -5,  1}, {-1,  0,  0}, {200, 150,  0, 255}},     // left side bottom right
+    {{ 5, -5,  1}, { 1,  0,  0}, {200, 150,  0, 255}},     // right side bottom left
+    {{ 0,  5,  1}, { 1,  0,  0}, {200, 150,  0, 255}},     // right side top left
+    {{ 0,  5, -1}, { 1,  0,  0}, {200, 150,  0, 255}},     // right side top right
+    {{ 5, -5, -1}, { 1,  0,  0}, {200, 150,  0, 255}}      // right side bottom right
+};
+
+static const GLubyte _Indices[] =
+{
+    0, 1, 2,        3, 4, 5,            // front and back triangles
+    6, 7, 8,        6, 8, 9,            // left side quad
+    10, 11, 12,     10, 12, 13          // right side quad
+};
+
+// where each of the three pieces sits relative to the eye
+static const GLfloat _Offsets[][3] = {{-5, -5, -35}, {5, -5, -35}, {0, 5, -35}};
+
+// the two materials of the immediate mode path, the fronts and backs of a piece use the first and its sides the second
+#define MATERIAL_FACES  0
+#define MATERIAL_SIDES  1
+
+static const GLubyte _MaterialColors[][4] = {{220, 190, 35, 255}, {200, 150, 0, 255}};         // yellow, dark yellow
+static const GLfloat _MaterialDiffuse[][4] = {{0.86f, 0.74f, 0.14f, 1.0f}, {0.78f, 0.59f, 0.0f, 1.0f}};
+
+// distance of the far clipping plane, depths handed to the draw queue are a fraction of it
+#define FAR_PLANE       100.0f
+
+// size of the square the field of triforces fits in, and how far it sits from the eye
+#define FIELD_EXTENT    26.0f
+#define FIELD_DEPTH     -35.0f
+
+// how the field of triforces is laid out in the current frame, shared by every job that builds a part of it
+// the jobs may run on other threads, so they're handed the instance data rather than finding it themselves
+typedef struct
+{
+    GLdouble     dAngle;            // angle of the first piece, the others follow it
+    unsigned int nColumns;          // number of pieces per row (and rows)
+    GLfloat      fCell;             // width and height of the square each piece sits in
+    PINSTANCE    pField;            // per-instance data the pieces are built into
+
+}  FIELDLAYOUT;
+
+// how far the crowd of triforces spreads out around the eye (it must stay inside the far clipping plane)
+#define SCATTER_NEAR    20.0f
+#define SCATTER_FAR     95.0f
+#define SCATTER_HEIGHT  25.0f
+
+// one piece of the crowd of triforces, where it is lives in the bounds used to cull it
+typedef struct
+{
+    GLfloat fPhase;                 // angle the piece is ahead of the others
+    GLfloat fScale;                 // uniform scale of the piece
+    GLubyte acColor[4];             // tint of the piece
+
+}  SCATTERPIECE, *PSCATTERPIECE;
+
+// how the visible pieces of the crowd are drawn in the current frame, shared by every job that builds a part of it
+typedef struct
+{
+    GLdouble             dAngle;    // angle of a piece without a phase, the others follow it
+    const unsigned int  *pDrawList; // which pieces are visible, in the order they're drawn
+    const SCATTERPIECE  *pScatter;  // every piece of the crowd
+    const BOUNDS        *pBounds;   // bounds of every piece of the crowd, where they are is their center
+    PINSTANCE            pField;    // per-instance data the visible pieces are built into
+
+}  SCATTERLAYOUT;
+
+// local function prototypes
+static void __buildField    (void *pData, unsigned int nBegin, unsigned int nEnd);
+static void __buildScatter  (void *pData, unsigned int nBegin, unsigned int nEnd);
+static void __drawFaces     (const void *pData, unsigned int nParam);
+static void __drawImmediate (GLdouble dAngle);
+static void __drawPiece     (const void *pData, unsigned int nParam);
+static void __drawRetained  (GLdouble dAngle);
+static void __setTransform  (PINSTANCE pInstance, GLfloat x, GLfloat y, GLfloat z, GLdouble dAngle, GLfloat fScale);
+static float __random       (unsigned int *pSeed);
+
+// local variables (each render thread draws a scene of its own, so they're kept per thread)
+static __declspec(thread) bool   _bRetained     = false;   // true if the pieces are drawn from the buffer objects
+static __declspec(thread) bool   _bSoftware     = false;   // true if the pieces are drawn by the software rasterizer
+static __declspec(thread) GLuint _nVertexBuffer = 0;       // name of the buffer object holding the vertices
+static __declspec(thread) GLuint _nIndexBuffer  = 0;       // name of the buffer object holding the indices
+
+static __declspec(thread) DRAWQUEUE _Queue      = {0};     // draws of the current frame, sorted by their state and depth
+
+static __declspec(thread) PINSTANCE    _pField  = NULL;    // per-instance data of the field of triforces (or the visible part of the crowd)
+static __declspec(thread) unsigned int _nField  = 0;       // number of triforces in the field (or the crowd)
+
+static __declspec(thread) PSCATTERPIECE _pScatter  = NULL; // pieces of the crowd of triforces
+static __declspec(thread) BOUNDS        _Bounds    = {0};  // bounds of every piece of the crowd
+
+static __declspec(thread) GLdouble _dAngle      = 0.0;     // angle (in degrees) the pieces are at after the last update
+static __declspec(thread) GLdouble _dLastAngle  = 0.0;     // angle the pieces were at before the last update
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     bRetained = flag to indicate if the geometry should be drawn from buffer objects (retained mode)
+/ /                 rather than being resubmitted with glBegin()/glEnd() every frame (immediate mode)
+/ /
+/ / PURPOSE:
+/ /     Builds the triforce mesh into GPU-resident vertex and index buffers once, and sets up the vertex
+/ /     array state and instanced drawing (if it's there) to draw from them. If buffer objects are not
+/ /     available the immediate mode path is used instead, it remains selectable as a reference. Returns
+/ /     true if the retained path is in use.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, before TriforcePrimitive() is.
+/*/
+
+bool
+InitTriforce (bool bRetained)
+{
+    _bRetained = false;
+
+    // the queue grows if it has to, so even if this fails every piece still gets drawn
+    CreateDrawQueue(&_Queue, 0);
+
+    // only attempt this if buffer objects are supported (they are part of the core since 1.5)
+    if(bRetained && HasCapability(CAP_VERTEX_BUFFERS))
+    {
+        // upload the mesh, it never changes so the driver is free to keep it in video memory
+        glGenBuffers(1, &_nVertexBuffer);
+        SetBuffer(GL_ARRAY_BUFFER, _nVertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(_Vertices), _Vertices, GL_STATIC_DRAW);
+
+        glGenBuffers(1, &_nIndexBuffer);
+        SetBuffer(GL_ELEMENT_ARRAY_BUFFER, _nIndexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(_Indices), _Indices, GL_STATIC_DRAW);
+
+        // the arrays point into the bound buffers, so these are offsets rather than addresses
+        SetClientArray(GL_VERTEX_ARRAY, true);
+        SetClientArray(GL_NORMAL_ARRAY, true);
+        SetClientArray(GL_COLOR_ARRAY, true);
+        glVertexPointer(3, GL_FLOAT, sizeof(TRIFORCEVERTEX), (const GLvoid *)offsetof(TRIFORCEVERTEX, afPosition));
+        glNormalPointer(GL_FLOAT, sizeof(TRIFORCEVERTEX), (const GLvoid *)offsetof(TRIFORCEVERTEX, afNormal));
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TRIFORCEVERTEX), (const GLvoid *)offsetof(TRIFORCEVERTEX, acColor));
+
+        // the vertex color takes the place of the glMaterialfv() calls of the immediate mode path
+        glColorMaterial(GL_FRONT, GL_DIFFUSE);
+        SetEnabled(GL_COLOR_MATERIAL, true);
+
+        // the pieces are drawn with a single instanced call when it can be done, one draw call each otherwise
+        InitInstancing();
+
+        _bRetained = true;
+    }
+
+    return _bRetained;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases the buffer objects created by InitTriforce() (if any), and the draw queue.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, before the RC is destroyed.
+/*/
+
+void
+DestroyTriforce (void)
+{
+    if(_pField != NULL)
+    {
+        free(_pField);
+        _pField = NULL;
+        _nField = 0;
+    }
+
+    // free() doesn't mind NULL, and neither does DestroyBounds()
+    free(_pScatter);
+    _pScatter = NULL;
+    DestroyBounds(&_Bounds);
+
+    DestroyDrawQueue(&_Queue);
+    DestroyInstancing();
+
+    if(_bSoftware)
+    {
+        DestroyRaster();
+        _bSoftware = false;
+    }
+
+    if(_bRetained)
+    {
+        SetEnabled(GL_COLOR_MATERIAL, false);
+        SetClientArray(GL_COLOR_ARRAY, false);
+        SetClientArray(GL_NORMAL_ARRAY, false);
+        SetClientArray(GL_VERTEX_ARRAY, false);
+
+        SetBuffer(GL_ARRAY_BUFFER, 0);
+        SetBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &_nVertexBuffer);
+        glDeleteBuffers(1, &_nIndexBuffer);
+
+        _nVertexBuffer = _nIndexBuffer = 0;
+        _bRetained = false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nInstances = number of triforce pieces in the field
+/ /
+/ / PURPOSE:
+/ /     Sets up the field of triforces drawn by TriforceFieldPrimitive(), a grid of identical pieces drawn with
+/ /     one instanced draw call. This builds the retained mesh as well, and returns false if that's not possible.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, instead of InitTriforce().
+/*/
+
+bool
+InitTriforceField (unsigned int nInstances)
+{
+    if(nInstances == 0) nInstances = 1;
+
+    // the instances share the mesh of the retained path, it's required for this (it also sets up instancing,
+    // without which the field still draws, only one piece at a time)
+    if(!InitTriforce(true)) return false;
+
+    if((_pField = (PINSTANCE)malloc(nInstances * sizeof(INSTANCE))) == NULL)
+    {
+        DestroyTriforce();
+        return false;
+    }
+
+    _nField = nInstances;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nInstances = number of triforce pieces in the crowd
+/ /
+/ / PURPOSE:
+/ /     Sets up the crowd of triforces drawn by TriforceScatterPrimitive(), pieces scattered all around the eye
+/ /     so only a fraction of them is ever in view. Each piece gets a bounding box so the ones that are out of
+/ /     view can be culled. Returns false if the retained mesh can't be built or the memory can't be allocated.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, instead of InitTriforce().
+/*/
+
+bool
+InitTriforceScatter (unsigned int nInstances)
+{
+    unsigned int i = 0, nSeed = 1;
+
+    if(nInstances == 0) nInstances = 1;
+    if(!InitTriforceField(nInstances)) return false;
+
+    // the pieces in view are sorted front to back every frame, so the queue has to hold them all
+    DestroyDrawQueue(&_Queue);
+
+    _pScatter = (PSCATTERPIECE)malloc(nInstances * sizeof(SCATTERPIECE));
+
+    if((_pScatter == NULL) || !CreateBounds(&_Bounds, nInstances) || !CreateDrawQueue(&_Queue, nInstances))
+    {
+        DestroyTriforce();
+        return false;
+    }
+
+    // the same seed every time, so every run draws the same crowd
+    for(i = 0; i < nInstances; i++)
+    {
+        double dHeading = __random(&nSeed) * 6.283185307179586;
+        GLfloat fDistance = SCATTER_NEAR + ((SCATTER_FAR - SCATTER_NEAR) * (float)sqrt(__random(&nSeed)));
+        GLfloat fScale = 0.1f + (0.3f * __random(&nSeed));
+        VEC3 Center, Min, Max;
+
+        Center.x = fDistance * (float)sin(dHeading);
+        Center.y = SCATTER_HEIGHT * ((2.0f * __random(&nSeed)) - 1.0f);
+        Center.z = -fDistance * (float)cos(dHeading);
+
+        // a piece spins around Y, so its box has to hold the widest it gets (the diagonal of the front and side)
+        Min.x = Center.x - (5.1f * fScale); Max.x = Center.x + (5.1f * fScale);
+        Min.y = Center.y - (5.0f * fScale); Max.y = Center.y + (5.0f * fScale);
+        Min.z = Center.z - (5.1f * fScale); Max.z = Center.z + (5.1f * fScale);
+        SetBoxBounds(&_Bounds, i, &Min, &Max);
+
+        _pScatter[i].fPhase = 360.0f * __random(&nSeed);
+        _pScatter[i].fScale = fScale;
+        _pScatter[i].acColor[0] = (GLubyte)(128 + (127 * __random(&nSeed)));
+        _pScatter[i].acColor[1] = (GLubyte)(128 + (127 * __random(&nSeed)));
+        _pScatter[i].acColor[2] = 255;
+        _pScatter[i].acColor[3] = 255;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Sets up the triforce drawn by TriforceSoftwarePrimitive(), the same three pieces TriforcePrimitive() draws,
+/ /     only drawn on the CPU by the software rasterizer. Returns false if the rasterizer can't be set up.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, instead of InitTriforce().
+/*/
+
+bool
+InitTriforceSoftware (void)
+{
+    _bSoftware = InitRaster();
+    return _bSoftware;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAlpha =   how far (from 0.0 to 1.0) the frame is between the last two updates, we use this
+/ /                to blend their states so motion stays smooth whatever the frame rate is
+/ /     nWidth =   width of the render context in which to draw on
+/ /     nHeight =  height of the render context in which to draw on
+/ /
+/ / PURPOSE:
+/ /     This draws a square field of spinning triforce pieces, as many as InitTriforceField() was given.
+/ /     Every transform is rebuilt each frame, so this also measures the cost of streaming instance data.
+/*/
+
+void
+TriforceFieldPrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight)
+{
+    FIELDLAYOUT Layout = {0};
+
+    glLoadIdentity();                                    // reset modelview matrix
+
+    // lay the pieces out in a square grid, the more there are the smaller each one gets
+    Layout.dAngle = _dLastAngle + ((_dAngle - _dLastAngle) * dAlpha);
+    Layout.nColumns = (unsigned int)ceil(sqrt((double)_nField));
+    Layout.fCell = FIELD_EXTENT / Layout.nColumns;
+    Layout.pField = _pField;
+
+    // the instance data is built on every core, only drawing it has to happen on this thread
+    ParallelFor(_nField, 0, __buildField, &Layout);
+
+    DrawInstanced((GLsizei)(sizeof(_Indices) / sizeof(_Indices[0])), GL_UNSIGNED_BYTE, _pField, _nField);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAlpha =   how far (from 0.0 to 1.0) the frame is between the last two updates, we use this
+/ /                to blend their states so motion stays smooth whatever the frame rate is
+/ /     nWidth =   width of the render context in which to draw on
+/ /     nHeight =  height of the render context in which to draw on
+/ /
+/ / PURPOSE:
+/ /     This draws the crowd of triforces InitTriforceScatter() set up while the eye turns around in the middle
+/ /     of it. Every piece is tested against the view frustum first, and only the ones in view are built and drawn,
+/ /     nearest first.
+/*/
+
+void
+TriforceScatterPrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight)
+{
+    SCATTERLAYOUT Layout = {0};
+    MAT4 Projection, View, ViewProj;
+    FRUSTUM Frustum;
+    BYTE *pVisible = NULL;
+    unsigned int *pDrawList = NULL;
+    unsigned int i = 0, nVisible = 0;
+
+    // which pieces are in view, and in what order, only matters for this frame, so it lives in the frame arena
+    pVisible = (BYTE *)FrameAlloc(_nField * sizeof(BYTE));
+    pDrawList = (unsigned int *)FrameAlloc(_nField * sizeof(unsigned int));
+    Layout.pDrawList = pDrawList;
+    Layout.pScatter = _pScatter;
+    Layout.pBounds = &_Bounds;
+    Layout.pField = _pField;
+    Layout.dAngle = _dLastAngle + ((_dAngle - _dLastAngle) * dAlpha);
+
+    // the eye turns as fast as the pieces spin, the frustum comes out in the same space as the pieces
+    GetProjection(Projection.m);
+    SetRotation(&View, (float)Layout.dAngle, 0.0f, 1.0f, 0.0f);
+    MultiplyMatrix(&ViewProj, &Projection, &View);
+    SetFrustum(&Frustum, &ViewProj);
+
+    // list the pieces in view nearest first, only those get their instance data built, and since the instances
+    // are drawn in the order they're listed the nearer pieces fill the depth buffer before the ones they hide
+    if((pVisible != NULL) && (pDrawList != NULL) && (CullBounds(&Frustum, &_Bounds, pVisible) > 0))
+    {
+        for(i = 0; i < _nField; i++)
+        {
+            if(pVisible[i])
+            {
+                GLfloat fDistance = -((View.m[2] * _Bounds.pCenterX[i]) + (View.m[6] * _Bounds.pCenterY[i]) + (View.m[10] * _Bounds.pCenterZ[i]) + View.m[14]);
+                SubmitDraw(&_Queue, MakeDrawKey(0, DRAW_OPAQUE, 0, 0, 0, fDistance / FAR_PLANE), NULL, NULL, i);
+            }
+        }
+
+        SortDrawQueue(&_Queue);
+
+        for(nVisible = 0; nVisible < _Queue.nCount; nVisible++)
+            pDrawList[nVisible] = _Queue.pPackets[nVisible].nParam;
+
+        ClearDrawQueue(&_Queue);
+    }
+
+    ParallelFor(nVisible, 0, __buildScatter, &Layout);
+
+    glLoadMatrixf(View.m);
+    DrawInstanced((GLsizei)(sizeof(_Indices) / sizeof(_Indices[0])), GL_UNSIGNED_BYTE, _pField, nVisible);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 /*/
 / / PARAMETERS:
-/ /     dElapsed = how many CPU cycles per second have passed recently, we use this as
-/ /                a factor to help throttle animation either up or down as needed
+/ /     dAlpha =   how far (from 0.0 to 1.0) the frame is between the last two updates, we use this
+/ /                to blend their states so motion stays smooth whatever the frame rate is
 / /     nWidth =   width of the render context in which to draw on
 / /     nHeight =  height of the render context in which to draw on
 / /
@@ -18,136 +482,340 @@
 /*/
 
 void
-TriforcePrimitive (const double dElapsed, const unsigned int nWidth, const unsigned int nHeight)
+TriforcePrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight)
 {
-    static GLdouble x = 0.0;
-    const static GLfloat MatYellowDiffuse[] = {0.86f, 0.74f, 0.14f, 1.0f};
-    const static GLfloat MatOrangeDiffuse[] = {0.78f, 0.59f, 0.0f, 1.0f};
+    GLdouble x = _dLastAngle + ((_dAngle - _dLastAngle) * dAlpha);
 
-    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);    // clear screen and depth buffers
     glLoadIdentity();                                    // reset modelview matrix
 
-    // get the angle we wish to use
-    if(x >= 360.0f) x = 0.0f;
+    // draw the three pieces with whichever path was selected at initialization
+    if(_bRetained)
+        __drawRetained(x);
+    else
+        __drawImmediate(x);
+}
 
-    // move and rotate the cube
-    glPushMatrix();
-        glTranslatef(-5, -5, -35);
-        glRotated(x, 0.0f, 1.0f, 0.0f);
-
-        glColor3ub(220, 190, 35);           // yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatYellowDiffuse);
-
-        // draw the cube
-        glBegin(GL_TRIANGLES);
-            glNormal3f(0, 0, -1);
-            glVertex3f(-5, -5, -1);         // left
-            glVertex3f(0, 5, -1);           // top
-            glVertex3f(5, -5, -1);          // right
-
-            glNormal3f(0, 0, 1);
-            glVertex3f(-5, -5, 1);          // left
-            glVertex3f(0, 5, 1);            // top
-            glVertex3f(5, -5, 1);           // right
-        glEnd();
-
-        glColor3ub(200, 150, 0);            // dark yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatOrangeDiffuse);
-
-        glBegin(GL_QUADS);
-            glNormal3f(-1, 0, 0);
-            glVertex3f(-5, -5, -1);         // bottom left
-            glVertex3f(0, 5, -1);           // top left
-            glVertex3f(0, 5, 1);            // top right
-            glVertex3f(-5, -5, 1);          // bottom right
-
-            glNormal3f(1, 0, 0);
-            glVertex3f(5, -5, 1);           // bottom left
-            glVertex3f(0, 5, 1);            // top left
-            glVertex3f(0, 5, -1);           // top right
-            glVertex3f(5, -5, -1);          // bottom right
-        glEnd();
-    glPopMatrix();
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAlpha =   how far (from 0.0 to 1.0) the frame is between the last two updates, we use this
+/ /                to blend their states so motion stays smooth whatever the frame rate is
+/ /     nWidth =   width of the render context in which to draw on
+/ /     nHeight =  height of the render context in which to draw on
+/ /
+/ / PURPOSE:
+/ /     This draws the triforce with the software rasterizer, the GL only gets the finished image. It gives the
+/ /     same picture as TriforcePrimitive() whatever GL is installed, so its frame times only depend on the CPU.
+/*/
+
+void
+TriforceSoftwarePrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight)
+{
+    GLdouble x = _dLastAngle + ((_dAngle - _dLastAngle) * dAlpha);
+    INSTANCE Piece;
+    MAT4 Projection;
+    unsigned int i = 0;
+
+    GetProjection(Projection.m);
+    if(!BeginRaster(nWidth, nHeight, &Projection)) return;
+
+    // the pieces are placed the way the other paths place them, every transform is a whole modelview matrix
+    for(i = 0; i < (sizeof(_Offsets) / sizeof(_Offsets[0])); i++)
+    {
+        __setTransform(&Piece, _Offsets[i][0], _Offsets[i][1], _Offsets[i][2], x, 1.0f);
+        DrawRaster((const MAT4 *)Piece.afTransform, (const RASTERVERTEX *)_Vertices, _Indices, sizeof(_Indices) / sizeof(_Indices[0]));
+    }
+
+    // binning and filling the tiles is where the time goes, it gets a channel of its own
+    BEGIN_TIMED_SCOPE
+        EndRaster();
+    END_TIMED_SCOPE(PROFILE_RASTER)
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dStep = how many seconds of animation to advance by, this is always the same amount
+/ /
+/ / PURPOSE:
+/ /     This animates the triforce (and the field of triforces) by one fixed step, it's called at a steady
+/ /     rate no matter how fast frames are drawn, so the animation is the same on every machine.
+/*/
+
+void
+TriforceUpdate (const double dStep)
+{
+    _dLastAngle = _dAngle;
 
+    // rotate 45 degrees every second
+    _dAngle += 45.0 * dStep;
+
+    // keep both angles in range together, so blending between them never goes the long way around
+    if(_dAngle >= 360.0)
+    {
+        _dAngle -= 360.0;
+        _dLastAngle -= 360.0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the FIELDLAYOUT of the current frame
+/ /     nBegin = first piece of the field to build
+/ /     nEnd = one past the last piece of the field to build
+/ /
+/ / PURPOSE:
+/ /     Fills in the transform and color of a range of pieces of the field, this runs as a job so the
+/ /     ranges are built on several threads at once.
+/*/
+
+static void
+__buildField (void *pData, unsigned int nBegin, unsigned int nEnd)
+{
+    const FIELDLAYOUT *pLayout = (const FIELDLAYOUT *)pData;
+    unsigned int i = 0;
+
+    for(i = nBegin; i < nEnd; i++)
+    {
+        unsigned int nColumn = i % pLayout->nColumns, nRow = i / pLayout->nColumns;
+
+        // each piece is a little behind its neighbor so the field ripples rather than spins as one
+        __setTransform(&pLayout->pField[i],
+            (-FIELD_EXTENT / 2.0f) + (pLayout->fCell * (nColumn + 0.5f)), (-FIELD_EXTENT / 2.0f) + (pLayout->fCell * (nRow + 0.5f)), FIELD_DEPTH,
+            pLayout->dAngle + ((nColumn + nRow) * 10.0), pLayout->fCell / 12.0f);
+
+        pLayout->pField[i].acColor[0] = 255;
+        pLayout->pField[i].acColor[1] = (GLubyte)(128 + ((127 * nRow) / pLayout->nColumns));
+        pLayout->pField[i].acColor[2] = (GLubyte)(128 + ((127 * nColumn) / pLayout->nColumns));
+        pLayout->pField[i].acColor[3] = 255;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the SCATTERLAYOUT of the current frame
+/ /     nBegin = first entry of the draw list to build
+/ /     nEnd = one past the last entry of the draw list to build
+/ /
+/ / PURPOSE:
+/ /     Fills in the transform and color of a range of the visible pieces of the crowd, this runs as a job.
+/*/
+
+static void
+__buildScatter (void *pData, unsigned int nBegin, unsigned int nEnd)
+{
+    const SCATTERLAYOUT *pLayout = (const SCATTERLAYOUT *)pData;
+    unsigned int i = 0;
+
+    for(i = nBegin; i < nEnd; i++)
+    {
+        unsigned int nPiece = pLayout->pDrawList[i];
+
+        __setTransform(&pLayout->pField[i], pLayout->pBounds->pCenterX[nPiece], pLayout->pBounds->pCenterY[nPiece], pLayout->pBounds->pCenterZ[nPiece],
+            pLayout->dAngle + pLayout->pScatter[nPiece].fPhase, pLayout->pScatter[nPiece].fScale);
+
+        memcpy(pLayout->pField[i].acColor, pLayout->pScatter[nPiece].acColor, sizeof(pLayout->pField[i].acColor));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the INSTANCE holding the transform of the piece
+/ /     nParam = which faces to draw, MATERIAL_FACES for the front and back or MATERIAL_SIDES for the sides
+/ /
+/ / PURPOSE:
+/ /     Draws part of one piece through glBegin()/glEnd(), this is the draw routine of an immediate mode packet.
+/*/
+
+static void
+__drawFaces (const void *pData, unsigned int nParam)
+{
+    const INSTANCE *pPiece = (const INSTANCE *)pData;
+
+    SetColor(_MaterialColors[nParam][0], _MaterialColors[nParam][1], _MaterialColors[nParam][2], _MaterialColors[nParam][3]);
+    SetMaterial(GL_FRONT, GL_DIFFUSE, _MaterialDiffuse[nParam]);
+
+    // move and rotate the piece
     glPushMatrix();
-        glTranslatef(5, -5, -35);
-        glRotated(x, 0.0f, 1.0f, 0.0f);
-
-        glColor3ub(220, 190, 35);           // yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatYellowDiffuse);
-
-        // draw the cube
-        glBegin(GL_TRIANGLES);
-            glNormal3f(0, 0, -1);
-            glVertex3f(-5, -5, -1);         // left
-            glVertex3f(0, 5, -1);           // top
-            glVertex3f(5, -5, -1);          // right
-
-            glNormal3f(0, 0, 1);
-            glVertex3f(-5, -5, 1);          // left
-            glVertex3f(0, 5, 1);            // top
-            glVertex3f(5, -5, 1);           // right
-        glEnd();
-
-        glColor3ub(200, 150, 0);            // dark yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatOrangeDiffuse);
-
-        glBegin(GL_QUADS);
-            glNormal3f(-1, 0, 0);
-            glVertex3f(-5, -5, -1);         // bottom left
-            glVertex3f(0, 5, -1);           // top left
-            glVertex3f(0, 5, 1);            // top right
-            glVertex3f(-5, -5, 1);          // bottom right
-
-            glNormal3f(1, 0, 0);
-            glVertex3f(5, -5, 1);           // bottom left
-            glVertex3f(0, 5, 1);            // top left
-            glVertex3f(0, 5, -1);           // top right
-            glVertex3f(5, -5, -1);          // bottom right
-        glEnd();
+        glMultMatrixf(pPiece->afTransform);
+
+        if(nParam == MATERIAL_FACES)
+        {
+            glBegin(GL_TRIANGLES);
+                glNormal3f(0, 0, -1);
+                glVertex3f(-5, -5, -1);     // left
+                glVertex3f(0, 5, -1);       // top
+                glVertex3f(5, -5, -1);      // right
+
+                glNormal3f(0, 0, 1);
+                glVertex3f(-5, -5, 1);      // left
+                glVertex3f(0, 5, 1);        // top
+                glVertex3f(5, -5, 1);       // right
+            glEnd();
+        }
+        else
+        {
+            glBegin(GL_QUADS);
+                glNormal3f(-1, 0, 0);
+                glVertex3f(-5, -5, -1);     // bottom left
+                glVertex3f(0, 5, -1);       // top left
+                glVertex3f(0, 5, 1);        // top right
+                glVertex3f(-5, -5, 1);      // bottom right
+
+                glNormal3f(1, 0, 0);
+                glVertex3f(5, -5, 1);       // bottom left
+                glVertex3f(0, 5, 1);        // top left
+                glVertex3f(0, 5, -1);       // top right
+                glVertex3f(5, -5, -1);      // bottom right
+            glEnd();
+        }
     glPopMatrix();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAngle = angle in degrees to rotate each piece around its vertical axis
+/ /
+/ / PURPOSE:
+/ /     Draws the three pieces by resubmitting every vertex through glBegin()/glEnd(). This is the
+/ /     original reference path, it is kept for comparison and for GLs without buffer objects.
+/ /
+/ / NOTES:
+/ /     Each piece is two packets, one per material, and sorting them draws every front and back before any of
+/ /     the sides, so the material only really changes twice a frame rather than six times.
+/*/
+
+static void
+__drawImmediate (GLdouble dAngle)
+{
+    INSTANCE Pieces[sizeof(_Offsets) / sizeof(_Offsets[0])];
+    unsigned int i = 0;
+
+    for(i = 0; i < (sizeof(_Offsets) / sizeof(_Offsets[0])); i++)
+    {
+        float fDepth = -_Offsets[i][2] / FAR_PLANE;
+
+        __setTransform(&Pieces[i], _Offsets[i][0], _Offsets[i][1], _Offsets[i][2], dAngle, 1.0f);
+        SubmitDraw(&_Queue, MakeDrawKey(0, DRAW_OPAQUE, 0, MATERIAL_FACES, 0, fDepth), __drawFaces, &Pieces[i], MATERIAL_FACES);
+        SubmitDraw(&_Queue, MakeDrawKey(0, DRAW_OPAQUE, 0, MATERIAL_SIDES, 0, fDepth), __drawFaces, &Pieces[i], MATERIAL_SIDES);
+    }
+
+    FlushDrawQueue(&_Queue);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the INSTANCE holding the transform of the piece
+/ /     nParam = not used
+/ /
+/ / PURPOSE:
+/ /     Draws one piece from the buffer objects, this is the draw routine of a retained mode packet.
+/*/
+
+static void
+__drawPiece (const void *pData, unsigned int nParam)
+{
+    const INSTANCE *pPiece = (const INSTANCE *)pData;
 
     glPushMatrix();
-        glTranslatef(0, 5, -35);
-        glRotated(x, 0.0f, 1.0f, 0.0f);
-
-        glColor3ub(220, 190, 35);           // yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatYellowDiffuse);
-
-        // draw the cube
-        glBegin(GL_TRIANGLES);
-            glNormal3f(0, 0, -1);
-            glVertex3f(-5, -5, -1);         // left
-            glVertex3f(0, 5, -1);           // top
-            glVertex3f(5, -5, -1);          // right
-
-            glNormal3f(0, 0, 1);
-            glVertex3f(-5, -5, 1);          // left
-            glVertex3f(0, 5, 1);            // top
-            glVertex3f(5, -5, 1);           // right
-        glEnd();
-
-        glColor3ub(200, 150, 0);            // dark yellow
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, MatOrangeDiffuse);
-
-        glBegin(GL_QUADS);
-            glNormal3f(-1, 0, 0);
-            glVertex3f(-5, -5, -1);         // bottom left
-            glVertex3f(0, 5, -1);           // top left
-            glVertex3f(0, 5, 1);            // top right
-            glVertex3f(-5, -5, 1);          // bottom right
-
-            glNormal3f(1, 0, 0);
-            glVertex3f(5, -5, 1);           // bottom left
-            glVertex3f(0, 5, 1);            // top left
-            glVertex3f(0, 5, -1);           // top right
-            glVertex3f(5, -5, -1);          // bottom right
-        glEnd();
+        glMultMatrixf(pPiece->afTransform);
+
+        glDrawElements(GL_TRIANGLES, (GLsizei)(sizeof(_Indices) / sizeof(_Indices[0])), GL_UNSIGNED_BYTE, NULL);
     glPopMatrix();
+}
 
-    // rotate 45 degrees every second
-    x += 45.0 * dElapsed;
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dAngle = angle in degrees to rotate each piece around its vertical axis
+/ /
+/ / PURPOSE:
+/ /     Draws the three pieces from the buffer objects built by InitTriforce(). The pieces only differ by their
+/ /     offset, so with instancing they are a single draw call, otherwise it's one indexed draw call each.
+/*/
+
+static void
+__drawRetained (GLdouble dAngle)
+{
+    INSTANCE Pieces[sizeof(_Offsets) / sizeof(_Offsets[0])];
+    unsigned int i = 0;
+
+    for(i = 0; i < (sizeof(_Offsets) / sizeof(_Offsets[0])); i++)
+    {
+        __setTransform(&Pieces[i], _Offsets[i][0], _Offsets[i][1], _Offsets[i][2], dAngle, 1.0f);
+        memset(Pieces[i].acColor, 255, sizeof(Pieces[i].acColor));
+    }
+
+    if(IsInstancingReady())
+    {
+        DrawInstanced((GLsizei)(sizeof(_Indices) / sizeof(_Indices[0])), GL_UNSIGNED_BYTE, Pieces, (GLsizei)i);
+        return;
+    }
+
+    // without instancing the finished transforms are handed to the matrix stack one piece at a time, nearest
+    // first, lit by the GLSL equivalent of the fixed-function lighting if there is one
+    UseProgram(GetLightingProgram());
+
+    for(i = 0; i < (sizeof(_Offsets) / sizeof(_Offsets[0])); i++)
+        SubmitDraw(&_Queue, MakeDrawKey(0, DRAW_OPAQUE, GetLightingProgram(), 0, 0, -_Offsets[i][2] / FAR_PLANE), __drawPiece, &Pieces[i], 0);
+
+    FlushDrawQueue(&_Queue);
+    UseProgram(0);
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pInstance = pointer to the instance to receive the transform
+/ /     x, y, z = where the piece is placed relative to the eye
+/ /     dAngle = angle in degrees to rotate the piece around its vertical axis
+/ /     fScale = uniform scale of the piece
+/ /
+/ / PURPOSE:
+/ /     Builds the same transform glTranslatef(), glRotated() around Y and glScalef() would, in that order.
+/*/
+
+static void
+__setTransform (PINSTANCE pInstance, GLfloat x, GLfloat y, GLfloat z, GLdouble dAngle, GLfloat fScale)
+{
+    VEC3 Position = {x, y, z};
+    QUAT Rotation;
+
+    // INSTANCE keeps its transform in the same column major layout as MAT4
+    SetQuatRotation(&Rotation, (float)dAngle, 0.0f, 1.0f, 0.0f);
+    ComposeMatrix((PMAT4)pInstance->afTransform, &Position, &Rotation, fScale);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pSeed = state of the generator, it's advanced on every call
+/ /
+/ / PURPOSE:
+/ /     Returns a pseudo random number from 0.0 to 1.0, the same seed always gives the same sequence.
+/*/
+
+static float
+__random (unsigned int *pSeed)
+{
+    *pSeed = (*pSeed * 1103515245) + 12345;
+    return ((*pSeed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -1,6 +1,15 @@
 #if !defined (TRIFORCE_H_846DC3B7_AC3B_4B17_A473_3E13831658ED_)
 #define TRIFORCE_H_846DC3B7_AC3B_4B17_A473_3E13831658ED_
 
-void TriforcePrimitive (const double dElapsed, const unsigned int nWidth, const unsigned int nHeight);
+bool InitTriforce              (bool bRetained);
+bool InitTriforceField         (unsigned int nInstances);
+bool InitTriforceScatter       (unsigned int nInstances);
+bool InitTriforceSoftware      (void);
+void DestroyTriforce           (void);
+void TriforcePrimitive         (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+void TriforceFieldPrimitive    (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+void TriforceScatterPrimitive  (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+void TriforceSoftwarePrimitive (const double dAlpha, const unsigned int nWidth, const unsigned int nHeight);
+void TriforceUpdate            (const double dStep);
 
-#endif  // TRIFORCE_H
\ No newline at end of file
+#endif  // TRIFORCE_H
@@ -7,12 +7,14 @@
 #define IDS_ERR_CREATEWIN_MAIN          103
 #define IDS_ERR_DISPLAYMODE             104
 #define IDS_ERR_WINVER                  105
+#define IDS_ERR_CONVERT                 106
+#define IDS_ERR_REPLAY                  107
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        106
+#define _APS_NEXT_RESOURCE_VALUE        108
 #define _APS_NEXT_COMMAND_VALUE         4001
 #define _APS_NEXT_CONTROL_VALUE         1001
 #define _APS_NEXT_SYMED_VALUE           101
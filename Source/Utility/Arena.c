@@ -0,0 +1,314 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Arena.h"          // include for this file
+#include "Utility\Jobs.h"           // job routines
+#include <malloc.h>                 // _aligned_malloc()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////// FRAME ARENA ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / Whatever a frame needs only until it has been drawn is carved out of a block of memory by bumping an offset,
+/ / and the whole block is taken back at once by setting the offset back to zero, so nothing is ever freed piece
+/ / by piece and the heap isn't touched while rendering. Every job thread has a block of its own, so threads never
+/ / contend for one, and there is a set of blocks per frame in flight: a frame's memory isn't reused until that
+/ / many frames later, so it can still be read (by the GL from client memory, say) after its frame has ended. An
+/ / allocation that doesn't fit comes from the heap this one time, and the next time that block is reset it's
+/ / made big enough for everything it had to hand out, so after a frame or two of warming up the heap is left
+/ / alone for good. The job threads share one arena, set up by the render thread that runs the jobs, any other
+/ / render thread sets up an arena of its own that only it allocates from.
+/*/
+
+#define ARENA_ALIGN     16          // alignment of every allocation, enough for SSE loads and stores
+#define MAX_FRAMES      3           // most frames the arena keeps in flight
+
+// the part of one frame that belongs to one thread
+typedef struct
+{
+    BYTE   *pBlock;                 // memory allocations are carved from
+    size_t  nSize;                  // bytes in the block
+    size_t  nUsed;                  // bytes of the block handed out so far
+    size_t  nSpilled;               // bytes that didn't fit and came from the heap instead
+    BYTE   *pSpills;                // those allocations, chained through their first bytes
+    BYTE    acPad[64 - (3 * sizeof(size_t)) - (2 * sizeof(BYTE *))]; // keeps each thread's part on its own cache line
+
+}  ARENA, *PARENA;
+
+// every frame of an arena, a part per thread allocating from it
+typedef struct
+{
+    PARENA       pArenas;           // every frame's parts, one frame after another
+    unsigned int nThreads;          // number of parts in a frame, one per job thread (or just one)
+    unsigned int nFrames;           // number of frames the arena keeps
+    unsigned int nFrame;            // frame the parts are being handed out of
+    ARENASTATS   Stats;             // use of the arena so far
+
+}  ARENASET, *PARENASET;
+
+// local function prototypes
+static PARENASET __getArenas  (void);
+static void      __resetArena (PARENASET pSet, PARENA pArena);
+
+// local variables
+static ARENASET _Shared = {0};                          // arena of the job threads, set up by the thread that called InitJobs()
+static __declspec(thread) ARENASET _Own = {0};          // arena of a thread that doesn't run jobs, if it set one up
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nSize = bytes each thread starts out with in each frame (it grows from there if need be)
+/ /     nFrames = number of frames whose memory is kept at once (1 to 3), two or three if any of it is still
+/ /               read after the frame has ended
+/ /
+/ / PURPOSE:
+/ /     Sets up a part of every frame for each job thread, so FrameAlloc() can be called from the jobs as well as
+/ /     from the calling thread. Called by a thread that doesn't run jobs, it sets up an arena only that thread
+/ /     allocates from. Returns false if there wasn't enough memory, FrameAlloc() returns NULL then.
+/ /
+/ / NOTES:
+/ /     The shared arena must be set up by the thread that called InitJobs(), after it did.
+/*/
+
+bool
+InitFrameArena (size_t nSize, unsigned int nFrames)
+{
+    PARENASET pSet = __getArenas();
+    unsigned int i = 0;
+
+    if(pSet->pArenas != NULL) return true;
+
+    pSet->nFrames = (nFrames == 0) ? 1 : ((nFrames > MAX_FRAMES) ? MAX_FRAMES : nFrames);
+    pSet->nThreads = (pSet == &_Shared) ? GetJobThreads() : 1;
+
+    if((pSet->pArenas = (PARENA)_aligned_malloc(pSet->nFrames * pSet->nThreads * sizeof(ARENA), 64)) == NULL) return false;
+    memset(pSet->pArenas, 0, pSet->nFrames * pSet->nThreads * sizeof(ARENA));
+    memset(&pSet->Stats, 0, sizeof(pSet->Stats));
+
+    nSize = (nSize + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+
+    for(i = 0; (i < (pSet->nFrames * pSet->nThreads)) && (nSize > 0); i++)
+    {
+        if((pSet->pArenas[i].pBlock = (BYTE *)_aligned_malloc(nSize, ARENA_ALIGN)) == NULL)
+        {
+            DestroyFrameArena();
+            return false;
+        }
+
+        pSet->pArenas[i].nSize = nSize;
+        pSet->Stats.nReserved += nSize;
+    }
+
+    // the first BeginArenaFrame() moves on to the first frame
+    pSet->nFrame = pSet->nFrames - 1;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases every frame of the arena, nothing FrameAlloc() handed out may be used after this.
+/ /
+/ / NOTES:
+/ /     This must be called by the thread that called InitFrameArena().
+/*/
+
+void
+DestroyFrameArena (void)
+{
+    PARENASET pSet = __getArenas();
+    unsigned int i = 0;
+
+    if(pSet->pArenas == NULL) return;
+
+    for(i = 0; i < (pSet->nFrames * pSet->nThreads); i++)
+    {
+        __resetArena(pSet, &pSet->pArenas[i]);
+        if(pSet->pArenas[i].pBlock != NULL) _aligned_free(pSet->pArenas[i].pBlock);
+    }
+
+    _aligned_free(pSet->pArenas);
+
+    pSet->pArenas = NULL;
+    pSet->nThreads = pSet->nFrames = pSet->nFrame = 0;
+    pSet->Stats.nReserved = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Moves on to the next frame of the arena and takes back everything that was handed out of it the last
+/ /     time it was used, which was as many frames ago as the arena keeps. Also records how much the frame that
+/ /     just ended used.
+/ /
+/ / NOTES:
+/ /     This must be called by the thread that called InitFrameArena(), at the top of every frame, while no jobs
+/ /     are running.
+/*/
+
+void
+BeginArenaFrame (void)
+{
+    PARENASET pSet = __getArenas();
+    PARENA pFrame = NULL;
+    size_t nUsed = 0;
+    unsigned int i = 0;
+
+    if(pSet->pArenas == NULL) return;
+
+    pFrame = &pSet->pArenas[pSet->nFrame * pSet->nThreads];
+    for(i = 0; i < pSet->nThreads; i++) nUsed += pFrame[i].nUsed + pFrame[i].nSpilled;
+
+    pSet->Stats.nUsed = nUsed;
+    if(nUsed > pSet->Stats.nPeak) pSet->Stats.nPeak = nUsed;
+
+    pSet->nFrame = (pSet->nFrame + 1) % pSet->nFrames;
+
+    pFrame = &pSet->pArenas[pSet->nFrame * pSet->nThreads];
+    for(i = 0; i < pSet->nThreads; i++) __resetArena(pSet, &pFrame[i]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nSize = number of bytes to allocate
+/ /
+/ / PURPOSE:
+/ /     Hands out memory for the current frame, aligned to 16 bytes, from the calling thread's part of the arena.
+/ /     It stays valid until BeginArenaFrame() comes back around to this frame, there is no way to free it
+/ /     sooner. Returns NULL if the calling thread has no arena (it neither runs jobs nor set one up), or if
+/ /     the memory couldn't be found at all.
+/ /
+/ / NOTES:
+/ /     The memory isn't zeroed, it holds whatever was last put there.
+/*/
+
+void *
+FrameAlloc (size_t nSize)
+{
+    PARENASET pSet = __getArenas();
+    int nThread = GetJobThread();
+    size_t nAligned = (nSize + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+    PARENA pArena = NULL;
+    BYTE *pSpill = NULL;
+
+    if((pSet->pArenas == NULL) || (nSize == 0) || (nAligned < nSize)) return NULL;
+
+    // a thread outside the job system has an arena of its own, with just the one part
+    if(nThread < 0) nThread = 0;
+    if((unsigned int)nThread >= pSet->nThreads) return NULL;
+
+    pArena = &pSet->pArenas[(pSet->nFrame * pSet->nThreads) + nThread];
+
+    if(nAligned <= (pArena->nSize - pArena->nUsed))
+    {
+        BYTE *pMemory = pArena->pBlock + pArena->nUsed;
+
+        pArena->nUsed += nAligned;
+        return pMemory;
+    }
+
+    // it doesn't fit, so this time it comes from the heap, the block is made big enough once it's reset
+    if((nAligned > ((size_t)-1 - ARENA_ALIGN)) || ((pSpill = (BYTE *)_aligned_malloc(nAligned + ARENA_ALIGN, ARENA_ALIGN)) == NULL)) return NULL;
+
+    *(BYTE **)pSpill = pArena->pSpills;
+    pArena->pSpills = pSpill;
+    pArena->nSpilled += nAligned;
+
+    return pSpill + ARENA_ALIGN;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pStats = pointer to the structure that receives how much of the arena is in use
+/ /
+/ / PURPOSE:
+/ /     Returns how much the last frame used, the most any frame has used, and how much the arena holds. The
+/ /     arena is the one the calling thread allocates from.
+/*/
+
+void
+GetArenaStats (PARENASTATS pStats)
+{
+    if(pStats != NULL) *pStats = __getArenas()->Stats;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the arena the calling thread allocates from, the shared one if it runs jobs and its own if not.
+/*/
+
+static PARENASET
+__getArenas (void)
+{
+    return (GetJobThread() >= 0) ? &_Shared : &_Own;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pSet = pointer to the arena the part belongs to
+/ /     pArena = pointer to one thread's part of a frame
+/ /
+/ / PURPOSE:
+/ /     Takes back everything handed out of a part of a frame. If some of it had to come from the heap, that's
+/ /     released and the block is replaced by one that holds all of it (rounded up to a power of two), so the
+/ /     same frame won't have to fall back to the heap again.
+/*/
+
+static void
+__resetArena (PARENASET pSet, PARENA pArena)
+{
+    while(pArena->pSpills != NULL)
+    {
+        BYTE *pNext = *(BYTE **)pArena->pSpills;
+
+        _aligned_free(pArena->pSpills);
+        pArena->pSpills = pNext;
+    }
+
+    if(pArena->nSpilled > 0)
+    {
+        size_t nNeeded = pArena->nUsed + pArena->nSpilled, nSize = ARENA_ALIGN;
+        BYTE *pBlock = NULL;
+
+        while((nSize < nNeeded) && (nSize <= ((size_t)-1 / 2))) nSize *= 2;
+
+        // if the bigger block can't be had the old one is kept, and the heap will be used again
+        if((nSize >= nNeeded) && ((pBlock = (BYTE *)_aligned_malloc(nSize, ARENA_ALIGN)) != NULL))
+        {
+            if(pArena->pBlock != NULL) _aligned_free(pArena->pBlock);
+
+            pSet->Stats.nReserved += nSize - pArena->nSize;
+            pSet->Stats.nGrowths++;
+
+            pArena->pBlock = pBlock;
+            pArena->nSize = nSize;
+        }
+    }
+
+    pArena->nUsed = 0;
+    pArena->nSpilled = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
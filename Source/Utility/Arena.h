@@ -0,0 +1,22 @@
+#if !defined (ARENA_H_D4B8271E_6F3C_4A95_8E07_2C91A5F3B6D8_)
+#define ARENA_H_D4B8271E_6F3C_4A95_8E07_2C91A5F3B6D8_
+
+#pragma once  // in case the compiler supports it
+
+// how much of the frame arena is in use, in bytes
+typedef struct
+{
+    size_t    nUsed;                // handed out during the last frame, by every thread together
+    size_t    nPeak;                // most handed out during any one frame so far
+    size_t    nReserved;            // held by the arena, across all its threads and frames
+    ULONGLONG nGrowths;             // times a thread ran out of its part of a frame and it had to be made bigger
+
+}  ARENASTATS, *PARENASTATS;
+
+bool  InitFrameArena    (size_t nSize, unsigned int nFrames);
+void  DestroyFrameArena (void);
+void  BeginArenaFrame   (void);
+void *FrameAlloc        (size_t nSize);
+void  GetArenaStats     (PARENASTATS pStats);
+
+#endif  // ARENA_H
@@ -0,0 +1,364 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Jobs.h"       // job routines
+#include "Utility\VecMath.h"    // vector math routines
+#include "Utility\Culling.h"    // include for this file
+#include <malloc.h>             // _aligned_malloc()
+#include <math.h>               // sqrt(), fabs()
+
+#ifdef MATH_SIMD
+    #include <immintrin.h>      // SSE and AVX intrinsics
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////// VIEW FRUSTUM CULLING ROUTINES ////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// objects are culled in groups of eight (one AVX register), the arrays are padded to a whole number of groups
+#define CULL_GROUP      8
+
+// below this many objects it's not worth waking the job threads, the calling thread culls them all by itself
+#define CULL_PARALLEL   16384
+
+// what every job that culls a part of the objects shares
+typedef struct
+{
+    const FRUSTUM *pFrustum;        // frustum to test against
+    const BOUNDS  *pBounds;         // objects to test
+    BYTE          *pVisible;        // receives a flag per object
+    volatile LONG  nVisible;        // number of objects found visible so far
+
+}  CULLJOB;
+
+// local function prototypes
+static void __cullGroups (void *pData, unsigned int nBegin, unsigned int nEnd);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pBounds = pointer to the structure that receives the arrays
+/ /     nCount = number of objects to hold bounds for
+/ /
+/ / PURPOSE:
+/ /     Allocates the arrays of a set of bounds, every object starts out as a point at the origin. Returns false
+/ /     if the memory couldn't be allocated.
+/ /
+/ / NOTES:
+/ /     All the arrays live in one block, each starts on a 32 byte boundary and holds a whole number of groups.
+/*/
+
+bool
+CreateBounds (PBOUNDS pBounds, unsigned int nCount)
+{
+    size_t nPadded = ((nCount + CULL_GROUP - 1) / CULL_GROUP) * CULL_GROUP;
+    float *pBlock = NULL;
+
+    if(pBounds == NULL) return false;
+    memset(pBounds, 0, sizeof(BOUNDS));
+
+    if((nCount == 0) || ((pBlock = (float *)_aligned_malloc(nPadded * 7 * sizeof(float), 32)) == NULL)) return false;
+    memset(pBlock, 0, nPadded * 7 * sizeof(float));
+
+    pBounds->pCenterX = pBlock;
+    pBounds->pCenterY = pBlock + nPadded;
+    pBounds->pCenterZ = pBlock + (nPadded * 2);
+    pBounds->pRadius  = pBlock + (nPadded * 3);
+    pBounds->pExtentX = pBlock + (nPadded * 4);
+    pBounds->pExtentY = pBlock + (nPadded * 5);
+    pBounds->pExtentZ = pBlock + (nPadded * 6);
+    pBounds->nCount = nCount;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pBounds = bounds to release
+/ /
+/ / PURPOSE:
+/ /     Releases the arrays allocated by CreateBounds().
+/*/
+
+void
+DestroyBounds (PBOUNDS pBounds)
+{
+    if(pBounds == NULL) return;
+
+    // the first array is the start of the block
+    if(pBounds->pCenterX != NULL) _aligned_free(pBounds->pCenterX);
+    memset(pBounds, 0, sizeof(BOUNDS));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pBounds = bounds to change
+/ /     nIndex = object to change the bounds of
+/ /     pMin, pMax = opposite corners of the object's axis aligned bounding box
+/ /
+/ / PURPOSE:
+/ /     Bounds an object by a box, the sphere is set to the one that just encloses the box.
+/*/
+
+void
+SetBoxBounds (PBOUNDS pBounds, unsigned int nIndex, const VEC3 *pMin, const VEC3 *pMax)
+{
+    VEC3 Extent;
+
+    if((pBounds == NULL) || (nIndex >= pBounds->nCount)) return;
+
+    Extent.x = (pMax->x - pMin->x) / 2.0f;
+    Extent.y = (pMax->y - pMin->y) / 2.0f;
+    Extent.z = (pMax->z - pMin->z) / 2.0f;
+
+    pBounds->pCenterX[nIndex] = pMin->x + Extent.x;
+    pBounds->pCenterY[nIndex] = pMin->y + Extent.y;
+    pBounds->pCenterZ[nIndex] = pMin->z + Extent.z;
+    pBounds->pRadius[nIndex]  = (float)sqrt(DotVector3(&Extent, &Extent));
+    pBounds->pExtentX[nIndex] = Extent.x;
+    pBounds->pExtentY[nIndex] = Extent.y;
+    pBounds->pExtentZ[nIndex] = Extent.z;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pBounds = bounds to change
+/ /     nIndex = object to change the bounds of
+/ /     pCenter = center of the object's bounding sphere
+/ /     fRadius = radius of the object's bounding sphere
+/ /
+/ / PURPOSE:
+/ /     Bounds an object by a sphere, the box is set to the cube that just encloses the sphere.
+/*/
+
+void
+SetSphereBounds (PBOUNDS pBounds, unsigned int nIndex, const VEC3 *pCenter, float fRadius)
+{
+    if((pBounds == NULL) || (nIndex >= pBounds->nCount)) return;
+
+    pBounds->pCenterX[nIndex] = pCenter->x;
+    pBounds->pCenterY[nIndex] = pCenter->y;
+    pBounds->pCenterZ[nIndex] = pCenter->z;
+    pBounds->pRadius[nIndex]  = fRadius;
+    pBounds->pExtentX[nIndex] = pBounds->pExtentY[nIndex] = pBounds->pExtentZ[nIndex] = fRadius;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pFrustum = pointer to the structure that receives the planes
+/ /     pViewProj = projection matrix times the view matrix, the planes come out in the space the view matrix
+/ /                 takes to eye space (so pass the projection alone to get them in eye space)
+/ /
+/ / PURPOSE:
+/ /     Pulls the six clipping planes out of a matrix, a point is inside the frustum if its distance to
+/ /     every plane is positive.
+/ /
+/ / NOTES:
+/ /     Each plane is the sum or difference of the last row of the matrix and one of the others, since that's
+/ /     what the clip space tests -w <= x <= w, etc. turn into. They are normalized so distances are true ones.
+/*/
+
+void
+SetFrustum (PFRUSTUM pFrustum, const MAT4 *pViewProj)
+{
+    const float *m = pViewProj->m;
+    int i = 0, j = 0;
+
+    for(i = 0; i < 6; i++)
+    {
+        // planes come in pairs, left/right uses the first row, bottom/top the second, near/far the third
+        int nRow = i / 2;
+        float fSign = (i & 1) ? -1.0f : 1.0f, fLength = 0.0f;
+
+        for(j = 0; j < 4; j++) pFrustum->afPlanes[i][j] = m[(j * 4) + 3] + (fSign * m[(j * 4) + nRow]);
+
+        fLength = (float)sqrt((pFrustum->afPlanes[i][0] * pFrustum->afPlanes[i][0]) + (pFrustum->afPlanes[i][1] * pFrustum->afPlanes[i][1]) +
+                              (pFrustum->afPlanes[i][2] * pFrustum->afPlanes[i][2]));
+
+        if(fLength > 0.0f) for(j = 0; j < 4; j++) pFrustum->afPlanes[i][j] /= fLength;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pFrustum = frustum to test against
+/ /     pBounds = objects to test
+/ /     pVisible = array that receives a flag per object, non-zero if any part of it may be visible
+/ /
+/ / PURPOSE:
+/ /     Tests every object against the frustum and returns how many of them may be visible. The SSE and AVX
+/ /     kernels of the vector math library test four or eight objects per instruction (see GetMathPath()),
+/ /     and large sets are split across the job threads.
+/ /
+/ / NOTES:
+/ /     The test is conservative, an object near a corner of the frustum may be kept even if it's outside.
+/*/
+
+unsigned int
+CullBounds (const FRUSTUM *pFrustum, const BOUNDS *pBounds, BYTE *pVisible)
+{
+    CULLJOB Job = {0};
+    unsigned int nGroups = 0;
+
+    if((pFrustum == NULL) || (pBounds == NULL) || (pVisible == NULL) || (pBounds->nCount == 0)) return 0;
+
+    Job.pFrustum = pFrustum;
+    Job.pBounds = pBounds;
+    Job.pVisible = pVisible;
+
+    // the jobs work on whole groups, so the SIMD kernels never straddle two of them
+    nGroups = (pBounds->nCount + CULL_GROUP - 1) / CULL_GROUP;
+
+    if(pBounds->nCount < CULL_PARALLEL)
+        __cullGroups(&Job, 0, nGroups);
+    else
+        ParallelFor(nGroups, 0, __cullGroups, &Job);
+
+    return (unsigned int)Job.nVisible;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the CULLJOB shared by every job
+/ /     nBegin = first group of objects to test
+/ /     nEnd = one past the last group of objects to test
+/ /
+/ / PURPOSE:
+/ /     Tests a range of groups of objects against the frustum, this runs as a job.
+/ /
+/ / NOTES:
+/ /     An object is outside a plane if the plane is further away from its center than the sphere's radius
+/ /     or the box's extent along the plane's normal, whichever is the smaller. Flags past the last object
+/ /     are never written, though the padding of the arrays is read.
+/*/
+
+static void
+__cullGroups (void *pData, unsigned int nBegin, unsigned int nEnd)
+{
+    CULLJOB *pJob = (CULLJOB *)pData;
+    const BOUNDS *pBounds = pJob->pBounds;
+    const float (*pPlanes)[4] = pJob->pFrustum->afPlanes;
+    unsigned int i = nBegin * CULL_GROUP, nLast = nEnd * CULL_GROUP;
+    LONG nVisible = 0;
+    int p = 0;
+
+    if(nLast > pBounds->nCount) nLast = pBounds->nCount;
+
+    #ifdef MATH_SIMD
+
+        if(GetMathPath() == MATH_AVX)
+        {
+            for(; i < nLast; i += 8)
+            {
+                __m256 x = _mm256_load_ps(pBounds->pCenterX + i), y = _mm256_load_ps(pBounds->pCenterY + i);
+                __m256 z = _mm256_load_ps(pBounds->pCenterZ + i), r = _mm256_load_ps(pBounds->pRadius + i);
+                __m256 ex = _mm256_load_ps(pBounds->pExtentX + i), ey = _mm256_load_ps(pBounds->pExtentY + i);
+                __m256 ez = _mm256_load_ps(pBounds->pExtentZ + i), out = _mm256_setzero_ps();
+                unsigned int j = 0;
+                int nMask = 0;
+
+                for(p = 0; p < 6; p++)
+                {
+                    __m256 d, e;
+
+                    d = _mm256_mul_ps(x, _mm256_set1_ps(pPlanes[p][0]));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(y, _mm256_set1_ps(pPlanes[p][1])));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(z, _mm256_set1_ps(pPlanes[p][2])));
+                    d = _mm256_add_ps(d, _mm256_set1_ps(pPlanes[p][3]));
+
+                    e = _mm256_mul_ps(ex, _mm256_set1_ps((float)fabs(pPlanes[p][0])));
+                    e = _mm256_add_ps(e, _mm256_mul_ps(ey, _mm256_set1_ps((float)fabs(pPlanes[p][1]))));
+                    e = _mm256_add_ps(e, _mm256_mul_ps(ez, _mm256_set1_ps((float)fabs(pPlanes[p][2]))));
+                    e = _mm256_min_ps(e, r);
+
+                    // once all eight are out there's no need to test the other planes
+                    out = _mm256_or_ps(out, _mm256_cmp_ps(_mm256_add_ps(d, e), _mm256_setzero_ps(), _CMP_LT_OQ));
+                    if(_mm256_movemask_ps(out) == 0xFF) break;
+                }
+
+                nMask = ~_mm256_movemask_ps(out);
+                for(j = 0; (j < 8) && ((i + j) < nLast); j++)
+                {
+                    pJob->pVisible[i + j] = (BYTE)((nMask >> j) & 1);
+                    nVisible += pJob->pVisible[i + j];
+                }
+            }
+
+            _mm256_zeroupper();
+        }
+        else if(GetMathPath() == MATH_SSE)
+        {
+            for(; i < nLast; i += 4)
+            {
+                __m128 x = _mm_load_ps(pBounds->pCenterX + i), y = _mm_load_ps(pBounds->pCenterY + i);
+                __m128 z = _mm_load_ps(pBounds->pCenterZ + i), r = _mm_load_ps(pBounds->pRadius + i);
+                __m128 ex = _mm_load_ps(pBounds->pExtentX + i), ey = _mm_load_ps(pBounds->pExtentY + i);
+                __m128 ez = _mm_load_ps(pBounds->pExtentZ + i), out = _mm_setzero_ps();
+                unsigned int j = 0;
+                int nMask = 0;
+
+                for(p = 0; p < 6; p++)
+                {
+                    __m128 d, e;
+
+                    d = _mm_mul_ps(x, _mm_set1_ps(pPlanes[p][0]));
+                    d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(pPlanes[p][1])));
+                    d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(pPlanes[p][2])));
+                    d = _mm_add_ps(d, _mm_set1_ps(pPlanes[p][3]));
+
+                    e = _mm_mul_ps(ex, _mm_set1_ps((float)fabs(pPlanes[p][0])));
+                    e = _mm_add_ps(e, _mm_mul_ps(ey, _mm_set1_ps((float)fabs(pPlanes[p][1]))));
+                    e = _mm_add_ps(e, _mm_mul_ps(ez, _mm_set1_ps((float)fabs(pPlanes[p][2]))));
+                    e = _mm_min_ps(e, r);
+
+                    out = _mm_or_ps(out, _mm_cmplt_ps(_mm_add_ps(d, e), _mm_setzero_ps()));
+                    if(_mm_movemask_ps(out) == 0x0F) break;
+                }
+
+                nMask = ~_mm_movemask_ps(out);
+                for(j = 0; (j < 4) && ((i + j) < nLast); j++)
+                {
+                    pJob->pVisible[i + j] = (BYTE)((nMask >> j) & 1);
+                    nVisible += pJob->pVisible[i + j];
+                }
+            }
+        }
+
+    #endif
+
+    for(; i < nLast; i++)
+    {
+        BYTE bVisible = 1;
+
+        for(p = 0; (p < 6) && bVisible; p++)
+        {
+            float d = (pBounds->pCenterX[i] * pPlanes[p][0]) + (pBounds->pCenterY[i] * pPlanes[p][1]) +
+                      (pBounds->pCenterZ[i] * pPlanes[p][2]) + pPlanes[p][3];
+            float e = (float)((pBounds->pExtentX[i] * fabs(pPlanes[p][0])) + (pBounds->pExtentY[i] * fabs(pPlanes[p][1])) +
+                              (pBounds->pExtentZ[i] * fabs(pPlanes[p][2])));
+
+            if(pBounds->pRadius[i] < e) e = pBounds->pRadius[i];
+            if((d + e) < 0.0f) bVisible = 0;
+        }
+
+        pJob->pVisible[i] = bVisible;
+        nVisible += bVisible;
+    }
+
+    InterlockedExchangeAdd(&pJob->nVisible, nVisible);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,37 @@
+#if !defined (CULLING_H_C84F2B61_7E09_4A3D_95B2_1D6E0F83A4C7_)
+#define CULLING_H_C84F2B61_7E09_4A3D_95B2_1D6E0F83A4C7_
+
+#pragma once  // in case the compiler supports it
+
+// the six planes of a view frustum (left, right, bottom, top, near, far), each normalized and facing inward
+typedef struct
+{
+    float afPlanes[6][4];           // x, y, z of the normal and the distance of each plane
+
+}  FRUSTUM, *PFRUSTUM;
+
+// bounds of a set of objects, kept as a structure of arrays so the culling kernels can load four or eight objects
+// at once, every object has both a sphere and an axis aligned box around the same center, and an object is only
+// culled if either of them is entirely outside one of the planes (the arrays are aligned and padded for AVX)
+typedef struct
+{
+    float *pCenterX;                // center of each object's bounds
+    float *pCenterY;
+    float *pCenterZ;
+    float *pRadius;                 // radius of each object's bounding sphere
+    float *pExtentX;                // half the size of each object's bounding box along each axis
+    float *pExtentY;
+    float *pExtentZ;
+    unsigned int nCount;            // number of objects
+
+}  BOUNDS, *PBOUNDS;
+
+bool         CreateBounds    (PBOUNDS pBounds, unsigned int nCount);
+void         DestroyBounds   (PBOUNDS pBounds);
+void         SetBoxBounds    (PBOUNDS pBounds, unsigned int nIndex, const VEC3 *pMin, const VEC3 *pMax);
+void         SetSphereBounds (PBOUNDS pBounds, unsigned int nIndex, const VEC3 *pCenter, float fRadius);
+
+void         SetFrustum      (PFRUSTUM pFrustum, const MAT4 *pViewProj);
+unsigned int CullBounds      (const FRUSTUM *pFrustum, const BOUNDS *pBounds, BYTE *pVisible);
+
+#endif  // CULLING_H
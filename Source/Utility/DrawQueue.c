@@ -0,0 +1,302 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\DrawQueue.h"      // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////// DRAW QUEUE ROUTINES /////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / A frame's draws are submitted to a queue as packets rather than drawn right away, and each packet carries a 64 bit
+/ / key that says where it belongs in the frame. Sorting the keys puts the packets that share a program, material and
+/ / texture next to each other, so the state cache finds most changes already made. From the most significant bit:
+/ /
+/ /     opaque:         layer (4) | 0 | program (11) | material (12) | texture (12) | depth (24)
+/ /     transparent:    layer (4) | 1 | inverted depth (24) | program (11) | material (12) | texture (12)
+/ /
+/ / Opaque packets are grouped by state and, within a group, drawn front to back. Transparent ones come after the
+/ / opaque ones of their layer and are drawn strictly back to front, state only breaks ties. Names and ids that don't
+/ / fit in their field are wrapped, which can only make the grouping worse, never the order wrong.
+/*/
+
+#define KEY_LAYER_BITS      4
+#define KEY_PROGRAM_BITS    11
+#define KEY_MATERIAL_BITS   12
+#define KEY_TEXTURE_BITS    12
+#define KEY_DEPTH_BITS      24
+
+#define KEY_MASK(nBits)     ((((ULONGLONG)1) << (nBits)) - 1)
+
+#define KEY_LAYER_SHIFT     60
+#define KEY_ORDER_SHIFT     59
+
+// the keys are sorted eight bits at a time, least significant first
+#define RADIX_BITS          8
+#define RADIX_BUCKETS       (1 << RADIX_BITS)
+#define RADIX_PASSES        (64 / RADIX_BITS)
+
+// a queue starts out this big if it isn't given a size, and doubles whenever it fills up
+#define MIN_QUEUE_SIZE      64
+
+// local function prototypes
+static bool __growQueue (PDRAWQUEUE pQueue);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = pointer to the structure that receives the arrays
+/ /     nCapacity = number of packets to make room for (zero for a small default), the queue grows past this if needed
+/ /
+/ / PURPOSE:
+/ /     Allocates an empty draw queue. Returns false if the memory couldn't be allocated.
+/*/
+
+bool
+CreateDrawQueue (PDRAWQUEUE pQueue, unsigned int nCapacity)
+{
+    if(pQueue == NULL) return false;
+    memset(pQueue, 0, sizeof(DRAWQUEUE));
+
+    if(nCapacity < MIN_QUEUE_SIZE) nCapacity = MIN_QUEUE_SIZE;
+
+    pQueue->pPackets = (PDRAWPACKET)malloc(nCapacity * sizeof(DRAWPACKET));
+    pQueue->pScratch = (PDRAWPACKET)malloc(nCapacity * sizeof(DRAWPACKET));
+
+    if((pQueue->pPackets == NULL) || (pQueue->pScratch == NULL))
+    {
+        DestroyDrawQueue(pQueue);
+        return false;
+    }
+
+    pQueue->nCapacity = nCapacity;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to release
+/ /
+/ / PURPOSE:
+/ /     Releases the arrays allocated by CreateDrawQueue(), any packets still in the queue are dropped.
+/*/
+
+void
+DestroyDrawQueue (PDRAWQUEUE pQueue)
+{
+    if(pQueue == NULL) return;
+
+    if(pQueue->pPackets != NULL) free(pQueue->pPackets);
+    if(pQueue->pScratch != NULL) free(pQueue->pScratch);
+    memset(pQueue, 0, sizeof(DRAWQUEUE));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nLayer = layer the packet is drawn in (0 to 15), every packet of a layer is drawn before the next layer's
+/ /     nOrder = whether the packet is opaque (front to back) or transparent (back to front)
+/ /     nProgram = name of the program the packet is drawn with (zero for none)
+/ /     nMaterial = id of the material the packet is drawn with, any number that tells materials apart
+/ /     nTexture = name of the texture the packet is drawn with (zero for none)
+/ /     fDepth = distance of the packet from the eye, from 0.0 (the near plane) to 1.0 (the far plane)
+/ /
+/ / PURPOSE:
+/ /     Packs the state and depth of a draw into a sort key for SubmitDraw().
+/*/
+
+ULONGLONG
+MakeDrawKey (unsigned int nLayer, DRAWORDER nOrder, GLuint nProgram, unsigned int nMaterial, GLuint nTexture, float fDepth)
+{
+    ULONGLONG nKey = ((ULONGLONG)nLayer & KEY_MASK(KEY_LAYER_BITS)) << KEY_LAYER_SHIFT;
+    ULONGLONG nState = 0, nDepth = 0;
+
+    // anything outside the range is pinned to the nearest end of it
+    if(!(fDepth > 0.0f)) fDepth = 0.0f;
+    if(fDepth > 1.0f) fDepth = 1.0f;
+    nDepth = (ULONGLONG)((double)fDepth * KEY_MASK(KEY_DEPTH_BITS));
+
+    nState = (((ULONGLONG)nProgram & KEY_MASK(KEY_PROGRAM_BITS)) << (KEY_MATERIAL_BITS + KEY_TEXTURE_BITS)) |
+             (((ULONGLONG)nMaterial & KEY_MASK(KEY_MATERIAL_BITS)) << KEY_TEXTURE_BITS) |
+             ((ULONGLONG)nTexture & KEY_MASK(KEY_TEXTURE_BITS));
+
+    if(nOrder == DRAW_TRANSPARENT)
+        nKey |= (((ULONGLONG)1) << KEY_ORDER_SHIFT) | ((KEY_MASK(KEY_DEPTH_BITS) - nDepth) << (KEY_ORDER_SHIFT - KEY_DEPTH_BITS)) | nState;
+    else
+        nKey |= (nState << KEY_DEPTH_BITS) | nDepth;
+
+    return nKey;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to add the packet to
+/ /     nKey = sort key of the packet, from MakeDrawKey()
+/ /     pfnDraw = routine that draws the packet
+/ /     pData, nParam = values handed to the routine
+/ /
+/ / PURPOSE:
+/ /     Adds a packet to the queue, it's drawn by the next FlushDrawQueue(). Returns false if the queue was full
+/ /     and couldn't be grown, the packet is dropped then.
+/*/
+
+bool
+SubmitDraw (PDRAWQUEUE pQueue, ULONGLONG nKey, DRAWPROC pfnDraw, const void *pData, unsigned int nParam)
+{
+    PDRAWPACKET pPacket = NULL;
+
+    if((pQueue->nCount == pQueue->nCapacity) && !__growQueue(pQueue)) return false;
+
+    pPacket = &pQueue->pPackets[pQueue->nCount++];
+    pPacket->nKey = nKey;
+    pPacket->pfnDraw = pfnDraw;
+    pPacket->pData = pData;
+    pPacket->nParam = nParam;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to empty
+/ /
+/ / PURPOSE:
+/ /     Drops every packet in the queue without drawing it, the memory is kept for the next frame.
+/*/
+
+void
+ClearDrawQueue (PDRAWQUEUE pQueue)
+{
+    pQueue->nCount = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to draw
+/ /
+/ / PURPOSE:
+/ /     Sorts the packets in the queue and draws them in order, then empties the queue.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+FlushDrawQueue (PDRAWQUEUE pQueue)
+{
+    unsigned int i = 0;
+
+    SortDrawQueue(pQueue);
+
+    for(i = 0; i < pQueue->nCount; i++)
+        if(pQueue->pPackets[i].pfnDraw != NULL) pQueue->pPackets[i].pfnDraw(pQueue->pPackets[i].pData, pQueue->pPackets[i].nParam);
+
+    pQueue->nCount = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to sort
+/ /
+/ / PURPOSE:
+/ /     Sorts the packets in the queue by their keys, lowest first, packets with equal keys keep the order they
+/ /     were submitted in. This is a least significant digit radix sort, so it takes the same few passes over
+/ /     the packets however they're ordered to begin with.
+/ /
+/ / NOTES:
+/ /     The counts of every digit are gathered in one pass over the keys, and a digit that's the same in every
+/ /     key is skipped. Keys usually differ in a few fields only (often just the depth), so most passes are.
+/*/
+
+void
+SortDrawQueue (PDRAWQUEUE pQueue)
+{
+    unsigned int nCounts[RADIX_PASSES][RADIX_BUCKETS];
+    PDRAWPACKET pSource = pQueue->pPackets, pDest = pQueue->pScratch;
+    unsigned int i = 0, nPass = 0;
+
+    if(pQueue->nCount < 2) return;
+    memset(nCounts, 0, sizeof(nCounts));
+
+    for(i = 0; i < pQueue->nCount; i++)
+    {
+        ULONGLONG nKey = pSource[i].nKey;
+
+        for(nPass = 0; nPass < RADIX_PASSES; nPass++)
+            nCounts[nPass][(nKey >> (nPass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    for(nPass = 0; nPass < RADIX_PASSES; nPass++)
+    {
+        unsigned int *pCounts = nCounts[nPass];
+        unsigned int nShift = nPass * RADIX_BITS, nOffset = 0, nBucket = 0;
+        PDRAWPACKET pSwap = NULL;
+
+        // every key has this digit, the pass wouldn't move anything
+        if(pCounts[(pSource[0].nKey >> nShift) & (RADIX_BUCKETS - 1)] == pQueue->nCount) continue;
+
+        // turn the counts into where each bucket starts
+        for(nBucket = 0; nBucket < RADIX_BUCKETS; nBucket++)
+        {
+            unsigned int nCount = pCounts[nBucket];
+
+            pCounts[nBucket] = nOffset;
+            nOffset += nCount;
+        }
+
+        for(i = 0; i < pQueue->nCount; i++)
+            pDest[pCounts[(pSource[i].nKey >> nShift) & (RADIX_BUCKETS - 1)]++] = pSource[i];
+
+        pSwap = pSource;
+        pSource = pDest;
+        pDest = pSwap;
+    }
+
+    // the sorted packets end up in whichever array the last pass wrote to, the two simply trade places
+    pQueue->pPackets = pSource;
+    pQueue->pScratch = pDest;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to grow
+/ /
+/ / PURPOSE:
+/ /     Doubles the number of packets a queue can hold, returns false if the memory couldn't be allocated.
+/*/
+
+static bool
+__growQueue (PDRAWQUEUE pQueue)
+{
+    unsigned int nCapacity = (pQueue->nCapacity < MIN_QUEUE_SIZE) ? MIN_QUEUE_SIZE : (pQueue->nCapacity * 2);
+    PDRAWPACKET pPackets = NULL, pScratch = NULL;
+
+    if(nCapacity <= pQueue->nCapacity) return false;
+
+    // the scratch array holds nothing between sorts, so it's replaced rather than copied
+    if((pPackets = (PDRAWPACKET)realloc(pQueue->pPackets, nCapacity * sizeof(DRAWPACKET))) == NULL) return false;
+    pQueue->pPackets = pPackets;
+
+    if((pScratch = (PDRAWPACKET)malloc(nCapacity * sizeof(DRAWPACKET))) == NULL) return false;
+    if(pQueue->pScratch != NULL) free(pQueue->pScratch);
+    pQueue->pScratch = pScratch;
+
+    pQueue->nCapacity = nCapacity;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,43 @@
+#if !defined (DRAWQUEUE_H_A7C3E915_4F2B_4D80_B16E_93D5F0C27A48_)
+#define DRAWQUEUE_H_A7C3E915_4F2B_4D80_B16E_93D5F0C27A48_
+
+#pragma once  // in case the compiler supports it
+
+// how the packets of a layer are ordered by depth, opaque ones front to back so the depth test rejects as
+// much as it can, and transparent ones back to front so they blend over what's behind them
+typedef enum {DRAW_OPAQUE = 0, DRAW_TRANSPARENT} DRAWORDER;
+
+// draws one packet, called on the render thread in the order the packets were sorted into
+typedef void (*DRAWPROC)(const void *pData, unsigned int nParam);
+
+// one draw submitted to a queue, everything about its order is in the key (see MakeDrawKey())
+typedef struct
+{
+    ULONGLONG    nKey;              // sort key, packets are drawn from the lowest key to the highest
+    DRAWPROC     pfnDraw;           // routine that draws the packet (may be NULL if the queue is only sorted)
+    const void  *pData;             // handed to the routine as is
+    unsigned int nParam;            // handed to the routine as is
+
+}  DRAWPACKET, *PDRAWPACKET;
+
+// packets submitted in the current frame, the second array is where the sort puts its passes
+typedef struct
+{
+    PDRAWPACKET  pPackets;          // packets in the order they were submitted (or sorted)
+    PDRAWPACKET  pScratch;          // same size as the packets, used by the sort
+    unsigned int nCount;            // number of packets submitted
+    unsigned int nCapacity;         // number of packets both arrays can hold
+
+}  DRAWQUEUE, *PDRAWQUEUE;
+
+bool      CreateDrawQueue  (PDRAWQUEUE pQueue, unsigned int nCapacity);
+void      DestroyDrawQueue (PDRAWQUEUE pQueue);
+
+ULONGLONG MakeDrawKey      (unsigned int nLayer, DRAWORDER nOrder, GLuint nProgram, unsigned int nMaterial, GLuint nTexture, float fDepth);
+bool      SubmitDraw       (PDRAWQUEUE pQueue, ULONGLONG nKey, DRAWPROC pfnDraw, const void *pData, unsigned int nParam);
+
+void      ClearDrawQueue   (PDRAWQUEUE pQueue);
+void      FlushDrawQueue   (PDRAWQUEUE pQueue);
+void      SortDrawQueue    (PDRAWQUEUE pQueue);
+
+#endif  // DRAWQUEUE_H
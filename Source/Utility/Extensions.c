@@ -0,0 +1,484 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // include for this file
+#include <stddef.h>                 // offsetof()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// GL EXTENSION ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / What a driver offers past GL 1.1 only changes with the RC, so it is all looked up once when the RC is made
+/ / current. The extension names (GL and WGL) are copied into a string pool with an open addressed hash set over
+/ / it, every entry point the application uses is resolved into GLFunctions, and every capability is worked out
+/ / from the version, the extensions and whether its entry points came back. After that a capability check is an
+/ / array lookup and an extension check is a hash and a probe or two, nothing walks the extension string or calls
+/ / wglGetProcAddress() again. All of it is kept per thread, so every render thread looks up what its own RC offers.
+/*/
+
+#define MIN_SET_SIZE    256         // smallest hash set (must be a power of two)
+#define MIN_POOL_SIZE   4096        // smallest string pool in bytes
+
+typedef const char * (APIENTRY *PFNWGLGETEXTENSIONSSTRINGARBPROC) (HDC hdc);
+typedef const char * (APIENTRY *PFNWGLGETEXTENSIONSSTRINGEXTPROC) (void);
+
+// what a capability needs besides its entry points, it is advertised if the GL is at least dVersion, if every
+// extension in aszAll is there, or if szAny is there
+typedef struct
+{
+    double      dVersion;           // GL version the feature became core in (zero if it never did)
+    const char *aszAll[3];          // extensions that together provide it (unused ones are NULL)
+    const char *szAny;              // one extension that provides it on its own (NULL if none)
+
+}  CAPREQUIREMENT;
+
+// one entry point of GLFunctions, the alternate name is tried if the driver doesn't know the first one
+typedef struct
+{
+    GLCAP       nCap;               // capability that can't be offered without it
+    size_t      nOffset;            // where it goes in GLFunctions
+    const char *szName;             // core name
+    const char *szAlternate;        // extension name (NULL if none)
+
+}  ENTRYPOINT;
+
+#define ENTRY(nCap, Field, szName, szAlternate)  {nCap, offsetof(GLFUNCTIONS, Field), szName, szAlternate}
+
+// in the same order as GLCAP
+static const CAPREQUIREMENT _Requirements[CAP_COUNT] =
+{
+    {1.5, {"GL_ARB_vertex_buffer_object", NULL, NULL}, NULL},
+    {3.0, {"GL_ARB_framebuffer_object", NULL, NULL}, "GL_EXT_framebuffer_object"},
+    {2.0, {"GL_ARB_shader_objects", "GL_ARB_vertex_shader", "GL_ARB_fragment_shader"}, NULL},
+    {3.3, {"GL_ARB_instanced_arrays", "GL_ARB_draw_instanced", NULL}, NULL},
+    {3.3, {"GL_ARB_timer_query", NULL, NULL}, NULL},
+    {4.1, {"GL_ARB_get_program_binary", NULL, NULL}, NULL},
+    {0.0, {"WGL_EXT_swap_control", NULL, NULL}, NULL},
+    {2.1, {"GL_ARB_pixel_buffer_object", NULL, NULL}, "GL_EXT_pixel_buffer_object"},
+    {3.2, {"GL_ARB_sync", NULL, NULL}, NULL},
+    {4.4, {"GL_ARB_buffer_storage", "GL_ARB_map_buffer_range", NULL}, NULL},
+    {3.0, {"GL_ARB_framebuffer_object", NULL, NULL}, "GL_EXT_framebuffer_blit"}
+};
+
+// prefer the core names, but the ARB/EXT ones are all an older driver may have
+static const ENTRYPOINT _EntryPoints[] =
+{
+    ENTRY(CAP_VERTEX_BUFFERS,   GenBuffers,               "glGenBuffers",               "glGenBuffersARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   DeleteBuffers,            "glDeleteBuffers",            "glDeleteBuffersARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   BindBuffer,               "glBindBuffer",               "glBindBufferARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   BufferData,               "glBufferData",               "glBufferDataARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   BufferSubData,            "glBufferSubData",            "glBufferSubDataARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   MapBuffer,                "glMapBuffer",                "glMapBufferARB"),
+    ENTRY(CAP_VERTEX_BUFFERS,   UnmapBuffer,              "glUnmapBuffer",              "glUnmapBufferARB"),
+
+    ENTRY(CAP_FRAMEBUFFERS,     GenFramebuffers,          "glGenFramebuffers",          "glGenFramebuffersEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     DeleteFramebuffers,       "glDeleteFramebuffers",       "glDeleteFramebuffersEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     BindFramebuffer,          "glBindFramebuffer",          "glBindFramebufferEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     CheckFramebufferStatus,   "glCheckFramebufferStatus",   "glCheckFramebufferStatusEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     GenRenderbuffers,         "glGenRenderbuffers",         "glGenRenderbuffersEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     DeleteRenderbuffers,      "glDeleteRenderbuffers",      "glDeleteRenderbuffersEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     BindRenderbuffer,         "glBindRenderbuffer",         "glBindRenderbufferEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     RenderbufferStorage,      "glRenderbufferStorage",      "glRenderbufferStorageEXT"),
+    ENTRY(CAP_FRAMEBUFFERS,     FramebufferRenderbuffer,  "glFramebufferRenderbuffer",  "glFramebufferRenderbufferEXT"),
+
+    ENTRY(CAP_FRAMEBUFFER_BLIT, BlitFramebuffer,          "glBlitFramebuffer",          "glBlitFramebufferEXT"),
+
+    ENTRY(CAP_SHADERS,          CreateShader,             "glCreateShader",             NULL),
+    ENTRY(CAP_SHADERS,          DeleteShader,             "glDeleteShader",             NULL),
+    ENTRY(CAP_SHADERS,          ShaderSource,             "glShaderSource",             NULL),
+    ENTRY(CAP_SHADERS,          CompileShader,            "glCompileShader",            NULL),
+    ENTRY(CAP_SHADERS,          GetShaderiv,              "glGetShaderiv",              NULL),
+    ENTRY(CAP_SHADERS,          CreateProgram,            "glCreateProgram",            NULL),
+    ENTRY(CAP_SHADERS,          DeleteProgram,            "glDeleteProgram",            NULL),
+    ENTRY(CAP_SHADERS,          AttachShader,             "glAttachShader",             NULL),
+    ENTRY(CAP_SHADERS,          BindAttribLocation,       "glBindAttribLocation",       "glBindAttribLocationARB"),
+    ENTRY(CAP_SHADERS,          LinkProgram,              "glLinkProgram",              NULL),
+    ENTRY(CAP_SHADERS,          GetProgramiv,             "glGetProgramiv",             NULL),
+    ENTRY(CAP_SHADERS,          UseProgram,               "glUseProgram",               NULL),
+    ENTRY(CAP_SHADERS,          EnableVertexAttribArray,  "glEnableVertexAttribArray",  "glEnableVertexAttribArrayARB"),
+    ENTRY(CAP_SHADERS,          DisableVertexAttribArray, "glDisableVertexAttribArray", "glDisableVertexAttribArrayARB"),
+    ENTRY(CAP_SHADERS,          VertexAttribPointer,      "glVertexAttribPointer",      "glVertexAttribPointerARB"),
+
+    ENTRY(CAP_INSTANCING,       VertexAttribDivisor,      "glVertexAttribDivisor",      "glVertexAttribDivisorARB"),
+    ENTRY(CAP_INSTANCING,       DrawElementsInstanced,    "glDrawElementsInstanced",    "glDrawElementsInstancedARB"),
+
+    ENTRY(CAP_TIMER_QUERIES,    GenQueries,               "glGenQueries",               NULL),
+    ENTRY(CAP_TIMER_QUERIES,    DeleteQueries,            "glDeleteQueries",            NULL),
+    ENTRY(CAP_TIMER_QUERIES,    GetQueryObjectiv,         "glGetQueryObjectiv",         NULL),
+    ENTRY(CAP_TIMER_QUERIES,    QueryCounter,             "glQueryCounter",             NULL),
+    ENTRY(CAP_TIMER_QUERIES,    GetQueryObjectui64v,      "glGetQueryObjectui64v",      NULL),
+
+    ENTRY(CAP_PROGRAM_BINARIES, ProgramParameteri,        "glProgramParameteri",        NULL),
+    ENTRY(CAP_PROGRAM_BINARIES, GetProgramBinary,         "glGetProgramBinary",         NULL),
+    ENTRY(CAP_PROGRAM_BINARIES, ProgramBinary,            "glProgramBinary",            NULL),
+
+    ENTRY(CAP_SYNC,             FenceSync,                "glFenceSync",                NULL),
+    ENTRY(CAP_SYNC,             DeleteSync,               "glDeleteSync",               NULL),
+    ENTRY(CAP_SYNC,             ClientWaitSync,           "glClientWaitSync",           NULL),
+
+    ENTRY(CAP_BUFFER_STORAGE,   BufferStorage,            "glBufferStorage",            NULL),
+    ENTRY(CAP_BUFFER_STORAGE,   MapBufferRange,           "glMapBufferRange",           NULL),
+
+    ENTRY(CAP_SWAP_CONTROL,     SwapIntervalEXT,          "wglSwapIntervalEXT",         NULL)
+};
+
+#define ENTRY_POINTS    (sizeof(_EntryPoints) / sizeof(_EntryPoints[0]))
+
+// local function prototypes
+static void         __addName   (const char *szName, size_t nLen);
+static void         __addNames  (const char *szList);
+static bool         __buildSet  (void);
+static PROC         __getProc   (const char *szName);
+static unsigned int __hashName  (const char *szName, size_t nLen);
+
+// global variables (entry points may differ from one RC to the next, and every render thread has an RC
+// of its own, so everything read from it is kept per thread)
+__declspec(thread) GLFUNCTIONS GLFunctions = {0};   // every entry point past GL 1.1 (NULL if its capability is missing)
+
+// local variables
+static __declspec(thread) char        *_pNames      = NULL;        // every extension name, one after the other and each null terminated
+static __declspec(thread) size_t       _nNamesUsed  = 0;           // bytes of the pool in use
+static __declspec(thread) size_t       _nNamesSize  = 0;           // bytes of the pool allocated
+static __declspec(thread) unsigned int _nNames      = 0;           // number of names in the pool
+static __declspec(thread) DWORD       *_pSet        = NULL;        // hash set of offsets into the pool plus one (zero marks an empty slot)
+static __declspec(thread) unsigned int _nSetMask    = 0;           // size of the set minus one
+static __declspec(thread) double       _dVersion    = 0.0;         // version of the GL the RC was created with
+static __declspec(thread) bool         _abCaps[CAP_COUNT];         // flags to indicate which capabilities are there
+static __declspec(thread) bool         _bLoaded     = false;       // flag to indicate InitExtensions() has run
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Reads the version and the GL and WGL extension lists of the current RC, resolves every entry point the
+/ /     application uses and works out which capabilities are there. Returns false only if the GL could not be
+/ /     queried at all, a missing capability is reported by HasCapability() instead.
+/ /
+/ / NOTES:
+/ /     Core profiles no longer report the extensions as one string, so from 3.0 on they are read one at a time.
+/ /     This must be called in the context of the render thread, once, right after the RC is made current.
+/*/
+
+bool
+InitExtensions (void)
+{
+    PFNWGLGETEXTENSIONSSTRINGARBPROC wglGetExtensionsStringARB = NULL;
+    PFNWGLGETEXTENSIONSSTRINGEXTPROC wglGetExtensionsStringEXT = NULL;
+    const char *szVersion = NULL;
+    GLint nCount = 0, i = 0;
+    unsigned int j = 0, k = 0;
+
+    if(_bLoaded) return true;
+    if((szVersion = (const char *)glGetString(GL_VERSION)) == NULL) return false;
+
+    memset(&GLFunctions, 0, sizeof(GLFunctions));
+    _dVersion = atof(szVersion);
+
+    // gather every name into the pool first, the set is sized for them afterwards
+    if(_dVersion >= 3.0) glGetStringi = (PFNGLGETSTRINGIPROC)__getProc("glGetStringi");
+
+    if(glGetStringi != NULL)
+    {
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nCount);
+        for(i = 0; i < nCount; i++) __addNames((const char *)glGetStringi(GL_EXTENSIONS, i));
+    }
+    else __addNames((const char *)glGetString(GL_EXTENSIONS));
+
+    // the WGL extensions are reported separately, through an extension of their own
+    if((wglGetExtensionsStringARB = (PFNWGLGETEXTENSIONSSTRINGARBPROC)__getProc("wglGetExtensionsStringARB")) != NULL)
+        __addNames(wglGetExtensionsStringARB(wglGetCurrentDC()));
+    else if((wglGetExtensionsStringEXT = (PFNWGLGETEXTENSIONSSTRINGEXTPROC)__getProc("wglGetExtensionsStringEXT")) != NULL)
+        __addNames(wglGetExtensionsStringEXT());
+
+    if(!__buildSet())
+    {
+        DestroyExtensions();
+        return false;
+    }
+
+    // a capability needs the version or its extensions first, only then are its entry points worth asking for
+    // since some drivers hand back stubs for anything they are asked
+    for(k = 0; k < CAP_COUNT; k++)
+    {
+        const CAPREQUIREMENT *pNeed = &_Requirements[k];
+        bool bAll = (pNeed->aszAll[0] != NULL);
+
+        for(j = 0; (j < 3) && (pNeed->aszAll[j] != NULL); j++)
+            if(!IsExtensionSupported(pNeed->aszAll[j])) bAll = false;
+
+        _abCaps[k] = (((pNeed->dVersion > 0.0) && (_dVersion >= pNeed->dVersion)) || bAll ||
+                      ((pNeed->szAny != NULL) && IsExtensionSupported(pNeed->szAny)));
+    }
+
+    // a driver can advertise a capability and still come up short, so it's dropped if any entry point is missing
+    for(j = 0; j < ENTRY_POINTS; j++)
+    {
+        const ENTRYPOINT *pEntry = &_EntryPoints[j];
+        PROC *ppProc = (PROC *)((BYTE *)&GLFunctions + pEntry->nOffset);
+
+        if(!_abCaps[pEntry->nCap]) continue;
+
+        if(((*ppProc = __getProc(pEntry->szName)) == NULL) && (pEntry->szAlternate != NULL))
+            *ppProc = __getProc(pEntry->szAlternate);
+
+        if(*ppProc == NULL) _abCaps[pEntry->nCap] = false;
+    }
+
+    // and then none of its entry points are left behind, so a NULL check is as good as HasCapability()
+    for(j = 0; j < ENTRY_POINTS; j++)
+    {
+        if(!_abCaps[_EntryPoints[j].nCap]) *(PROC *)((BYTE *)&GLFunctions + _EntryPoints[j].nOffset) = NULL;
+    }
+
+    _bLoaded = true;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases the extension set and clears the function table, every capability reads as missing after this.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, after everything using the GL has been released.
+/*/
+
+void
+DestroyExtensions (void)
+{
+    free(_pSet);
+    free(_pNames);
+
+    _pSet = NULL;
+    _pNames = NULL;
+    _nNamesUsed = _nNamesSize = 0;
+    _nNames = _nSetMask = 0;
+    _dVersion = 0.0;
+
+    memset(&GLFunctions, 0, sizeof(GLFunctions));
+    memset(_abCaps, 0, sizeof(_abCaps));
+    _bLoaded = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the major and minor version of the GL, e.g. 3.3, or zero if InitExtensions() hasn't run.
+/*/
+
+double
+GetGLVersion (void)
+{
+    return _dVersion;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nCap = capability to look for
+/ /
+/ / PURPOSE:
+/ /     Returns true if the GL offers the capability and every entry point it needs is in GLFunctions.
+/*/
+
+bool
+HasCapability (GLCAP nCap)
+{
+    return (nCap < CAP_COUNT) ? _abCaps[nCap] : false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szExtension = name of the extension to look for, e.g. "GL_EXT_framebuffer_object"
+/ /
+/ / PURPOSE:
+/ /     Returns true if the extension is in the GL or WGL list the current RC reported. Whole names are
+/ /     matched, so an extension whose name is the prefix of another one will not give a false positive.
+/ /
+/ / NOTES:
+/ /     This only knows what InitExtensions() read on the calling thread, before that (or after DestroyExtensions())
+/ /     it returns false.
+/*/
+
+bool
+IsExtensionSupported (const char *szExtension)
+{
+    unsigned int nSlot = 0;
+    size_t nLen = 0;
+
+    // this does not support Unicode, but that's ok because the user
+    // will never see the string data that we test with
+    if((_pSet == NULL) || (szExtension == NULL) || ((nLen = strlen(szExtension)) == 0)) return false;
+
+    for(nSlot = __hashName(szExtension, nLen) & _nSetMask; _pSet[nSlot] != 0; nSlot = (nSlot + 1) & _nSetMask)
+    {
+        if(strcmp(_pNames + _pSet[nSlot] - 1, szExtension) == 0) return true;
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szName = name to add, it does not need to be null terminated
+/ /     nLen = length of the name in characters
+/ /
+/ / PURPOSE:
+/ /     Appends a name to the string pool, growing it as needed. A name that doesn't fit is dropped.
+/*/
+
+static void
+__addName (const char *szName, size_t nLen)
+{
+    if((_nNamesUsed + nLen + 1) > _nNamesSize)
+    {
+        size_t nSize = (_nNamesSize > 0) ? _nNamesSize : MIN_POOL_SIZE;
+        char *pNames = NULL;
+
+        while(nSize < (_nNamesUsed + nLen + 1)) nSize *= 2;
+        if((pNames = (char *)realloc(_pNames, nSize)) == NULL) return;
+
+        _pNames = pNames;
+        _nNamesSize = nSize;
+    }
+
+    memcpy(_pNames + _nNamesUsed, szName, nLen);
+    _pNames[_nNamesUsed + nLen] = '\0';
+    _nNamesUsed += nLen + 1;
+    _nNames++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szList = list of names separated by spaces (or a single name), may be NULL
+/ /
+/ / PURPOSE:
+/ /     Adds every name in the list to the string pool.
+/*/
+
+static void
+__addNames (const char *szList)
+{
+    const char *szEnd = NULL;
+
+    if(szList == NULL) return;
+
+    while(*szList != '\0')
+    {
+        while(*szList == ' ') szList++;
+        for(szEnd = szList; (*szEnd != ' ') && (*szEnd != '\0'); szEnd++);
+
+        if(szEnd > szList) __addName(szList, szEnd - szList);
+        szList = szEnd;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Builds the hash set over every name in the string pool. Returns false if it could not be allocated.
+/ /
+/ / NOTES:
+/ /     The set is kept at most half full, so a lookup that misses ends after a probe or two.
+/*/
+
+static bool
+__buildSet (void)
+{
+    unsigned int nSize = MIN_SET_SIZE, nSlot = 0;
+    size_t nOffset = 0, nLen = 0;
+
+    while(nSize < (_nNames * 2)) nSize *= 2;
+    if((_pSet = (DWORD *)calloc(nSize, sizeof(DWORD))) == NULL) return false;
+    _nSetMask = nSize - 1;
+
+    for(nOffset = 0; nOffset < _nNamesUsed; nOffset += nLen + 1)
+    {
+        const char *szName = _pNames + nOffset;
+
+        nLen = strlen(szName);
+
+        // probe linearly, a name reported twice (drivers often list WGL extensions with the GL ones) is kept once
+        for(nSlot = __hashName(szName, nLen) & _nSetMask; _pSet[nSlot] != 0; nSlot = (nSlot + 1) & _nSetMask)
+        {
+            if(strcmp(_pNames + _pSet[nSlot] - 1, szName) == 0) break;
+        }
+
+        _pSet[nSlot] = (DWORD)(nOffset + 1);
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szName = name of the entry point
+/ /
+/ / PURPOSE:
+/ /     Returns the address of a GL or WGL entry point, or NULL if the driver doesn't have it.
+/ /
+/ / NOTES:
+/ /     Some drivers hand back small values rather than NULL for names they don't know, those are treated as NULL.
+/*/
+
+static PROC
+__getProc (const char *szName)
+{
+    PROC pProc = wglGetProcAddress(szName);
+
+    if(((INT_PTR)pProc >= -1) && ((INT_PTR)pProc <= 3)) return NULL;
+    return pProc;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szName = name to hash, it does not need to be null terminated
+/ /     nLen = length of the name in characters
+/ /
+/ / PURPOSE:
+/ /     Returns the 32-bit FNV-1a hash of a name.
+/*/
+
+static unsigned int
+__hashName (const char *szName, size_t nLen)
+{
+    unsigned int nHash = 2166136261U;
+    size_t i = 0;
+
+    for(i = 0; i < nLen; i++)
+    {
+        nHash ^= (BYTE)szName[i];
+        nHash *= 16777619U;
+    }
+
+    return nHash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
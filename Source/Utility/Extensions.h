@@ -0,0 +1,251 @@
+#if !defined (EXTENSIONS_H_5D0B7C2E_94A1_4F36_B8E7_2A61C3F09D85_)
+#define EXTENSIONS_H_5D0B7C2E_94A1_4F36_B8E7_2A61C3F09D85_
+
+#pragma once  // in case the compiler supports it
+
+// definitions from GL versions past 1.1 and their extensions, these are not in the Windows SDK headers
+#define GL_NUM_EXTENSIONS                   0x821D
+#define GL_ARRAY_BUFFER                     0x8892
+#define GL_ELEMENT_ARRAY_BUFFER             0x8893
+#define GL_STREAM_DRAW                      0x88E0
+#define GL_STATIC_DRAW                      0x88E4
+#define GL_WRITE_ONLY                       0x88B9
+#define GL_PIXEL_UNPACK_BUFFER              0x88EC
+#define GL_FRAMEBUFFER                      0x8D40
+#define GL_READ_FRAMEBUFFER                 0x8CA8
+#define GL_DRAW_FRAMEBUFFER                 0x8CA9
+#define GL_RENDERBUFFER                     0x8D41
+#define GL_COLOR_ATTACHMENT0                0x8CE0
+#define GL_DEPTH_ATTACHMENT                 0x8D00
+#define GL_FRAMEBUFFER_COMPLETE             0x8CD5
+#define GL_DEPTH_COMPONENT24                0x81A6
+#define GL_FRAGMENT_SHADER                  0x8B30
+#define GL_VERTEX_SHADER                    0x8B31
+#define GL_COMPILE_STATUS                   0x8B81
+#define GL_LINK_STATUS                      0x8B82
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#define GL_QUERY_RESULT                     0x8866
+#define GL_QUERY_RESULT_AVAILABLE           0x8867
+#define GL_TIMESTAMP                        0x8E28
+#define GL_MAP_WRITE_BIT                    0x0002
+#define GL_MAP_PERSISTENT_BIT               0x0040
+#define GL_MAP_COHERENT_BIT                 0x0080
+#define GL_SYNC_GPU_COMMANDS_COMPLETE       0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT          0x0001
+#define GL_ALREADY_SIGNALED                 0x911A
+#define GL_TIMEOUT_EXPIRED                  0x911B
+#define GL_CONDITION_SATISFIED              0x911C
+#define GL_WAIT_FAILED                      0x911D
+
+typedef char      GLchar;
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef struct __GLsync *GLsync;
+
+// entry point types, grouped by the capability that needs them
+typedef const GLubyte * (APIENTRY *PFNGLGETSTRINGIPROC) (GLenum name, GLuint index);
+
+typedef void   (APIENTRY *PFNGLGENBUFFERSPROC)               (GLsizei n, GLuint *buffers);
+typedef void   (APIENTRY *PFNGLDELETEBUFFERSPROC)            (GLsizei n, const GLuint *buffers);
+typedef void   (APIENTRY *PFNGLBINDBUFFERPROC)               (GLenum target, GLuint buffer);
+typedef void   (APIENTRY *PFNGLBUFFERDATAPROC)               (GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage);
+typedef void   (APIENTRY *PFNGLBUFFERSUBDATAPROC)            (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data);
+typedef void * (APIENTRY *PFNGLMAPBUFFERPROC)                (GLenum target, GLenum access);
+typedef GLboolean (APIENTRY *PFNGLUNMAPBUFFERPROC)          (GLenum target);
+
+typedef void   (APIENTRY *PFNGLGENFRAMEBUFFERSPROC)          (GLsizei n, GLuint *framebuffers);
+typedef void   (APIENTRY *PFNGLDELETEFRAMEBUFFERSPROC)       (GLsizei n, const GLuint *framebuffers);
+typedef void   (APIENTRY *PFNGLBINDFRAMEBUFFERPROC)          (GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRY *PFNGLCHECKFRAMEBUFFERSTATUSPROC)   (GLenum target);
+typedef void   (APIENTRY *PFNGLGENRENDERBUFFERSPROC)         (GLsizei n, GLuint *renderbuffers);
+typedef void   (APIENTRY *PFNGLDELETERENDERBUFFERSPROC)      (GLsizei n, const GLuint *renderbuffers);
+typedef void   (APIENTRY *PFNGLBINDRENDERBUFFERPROC)         (GLenum target, GLuint renderbuffer);
+typedef void   (APIENTRY *PFNGLRENDERBUFFERSTORAGEPROC)      (GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void   (APIENTRY *PFNGLFRAMEBUFFERRENDERBUFFERPROC)  (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+
+typedef void   (APIENTRY *PFNGLBLITFRAMEBUFFERPROC)          (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+
+typedef GLuint (APIENTRY *PFNGLCREATESHADERPROC)             (GLenum type);
+typedef void   (APIENTRY *PFNGLDELETESHADERPROC)             (GLuint shader);
+typedef void   (APIENTRY *PFNGLSHADERSOURCEPROC)             (GLuint shader, GLsizei count, const GLchar **string, const GLint *length);
+typedef void   (APIENTRY *PFNGLCOMPILESHADERPROC)            (GLuint shader);
+typedef void   (APIENTRY *PFNGLGETSHADERIVPROC)              (GLuint shader, GLenum pname, GLint *params);
+typedef GLuint (APIENTRY *PFNGLCREATEPROGRAMPROC)            (void);
+typedef void   (APIENTRY *PFNGLDELETEPROGRAMPROC)            (GLuint program);
+typedef void   (APIENTRY *PFNGLATTACHSHADERPROC)             (GLuint program, GLuint shader);
+typedef void   (APIENTRY *PFNGLBINDATTRIBLOCATIONPROC)       (GLuint program, GLuint index, const GLchar *name);
+typedef void   (APIENTRY *PFNGLLINKPROGRAMPROC)              (GLuint program);
+typedef void   (APIENTRY *PFNGLGETPROGRAMIVPROC)             (GLuint program, GLenum pname, GLint *params);
+typedef void   (APIENTRY *PFNGLUSEPROGRAMPROC)               (GLuint program);
+typedef void   (APIENTRY *PFNGLENABLEVERTEXATTRIBARRAYPROC)  (GLuint index);
+typedef void   (APIENTRY *PFNGLDISABLEVERTEXATTRIBARRAYPROC) (GLuint index);
+typedef void   (APIENTRY *PFNGLVERTEXATTRIBPOINTERPROC)      (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *pointer);
+
+typedef void   (APIENTRY *PFNGLVERTEXATTRIBDIVISORPROC)      (GLuint index, GLuint divisor);
+typedef void   (APIENTRY *PFNGLDRAWELEMENTSINSTANCEDPROC)    (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount);
+
+typedef void   (APIENTRY *PFNGLGENQUERIESPROC)               (GLsizei n, GLuint *ids);
+typedef void   (APIENTRY *PFNGLDELETEQUERIESPROC)            (GLsizei n, const GLuint *ids);
+typedef void   (APIENTRY *PFNGLGETQUERYOBJECTIVPROC)         (GLuint id, GLenum pname, GLint *params);
+typedef void   (APIENTRY *PFNGLQUERYCOUNTERPROC)             (GLuint id, GLenum target);
+typedef void   (APIENTRY *PFNGLGETQUERYOBJECTUI64VPROC)      (GLuint id, GLenum pname, ULONGLONG *params);
+
+typedef void   (APIENTRY *PFNGLPROGRAMPARAMETERIPROC)        (GLuint program, GLenum pname, GLint value);
+typedef void   (APIENTRY *PFNGLGETPROGRAMBINARYPROC)         (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, GLvoid *binary);
+typedef void   (APIENTRY *PFNGLPROGRAMBINARYPROC)            (GLuint program, GLenum binaryFormat, const GLvoid *binary, GLsizei length);
+
+typedef GLsync (APIENTRY *PFNGLFENCESYNCPROC)                (GLenum condition, GLbitfield flags);
+typedef void   (APIENTRY *PFNGLDELETESYNCPROC)               (GLsync sync);
+typedef GLenum (APIENTRY *PFNGLCLIENTWAITSYNCPROC)           (GLsync sync, GLbitfield flags, ULONGLONG timeout);
+
+typedef void   (APIENTRY *PFNGLBUFFERSTORAGEPROC)            (GLenum target, GLsizeiptr size, const GLvoid *data, GLbitfield flags);
+typedef void * (APIENTRY *PFNGLMAPBUFFERRANGEPROC)           (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+
+typedef BOOL   (APIENTRY *PFNWGLSWAPINTERVALEXTPROC)         (int interval);
+
+// features that need more than GL 1.1, each one is only reported if every entry point it needs was resolved
+typedef enum
+{
+    CAP_VERTEX_BUFFERS = 0,         // buffer objects (GL 1.5 or ARB_vertex_buffer_object)
+    CAP_FRAMEBUFFERS,               // framebuffer objects (GL 3.0, ARB_framebuffer_object or EXT_framebuffer_object)
+    CAP_SHADERS,                    // GLSL programs (GL 2.0 or the ARB shader extensions)
+    CAP_INSTANCING,                 // instanced arrays and draws (GL 3.3 or the ARB instancing extensions)
+    CAP_TIMER_QUERIES,              // timestamp queries (GL 3.3 or ARB_timer_query)
+    CAP_PROGRAM_BINARIES,           // retrievable program binaries (GL 4.1 or ARB_get_program_binary)
+    CAP_SWAP_CONTROL,               // swap interval (WGL_EXT_swap_control)
+    CAP_PIXEL_BUFFERS,              // buffer objects as the source of pixel uploads (GL 2.1 or ARB/EXT_pixel_buffer_object)
+    CAP_SYNC,                       // fence sync objects (GL 3.2 or ARB_sync)
+    CAP_BUFFER_STORAGE,             // immutable, persistently mapped buffer objects (GL 4.4 or ARB_buffer_storage)
+    CAP_FRAMEBUFFER_BLIT,           // copying and stretching between framebuffers (GL 3.0, ARB_framebuffer_object or EXT_framebuffer_blit)
+    CAP_COUNT
+
+}  GLCAP;
+
+// every entry point the application uses past GL 1.1, filled in once by InitExtensions()
+typedef struct
+{
+    PFNGLGETSTRINGIPROC               GetStringi;
+
+    PFNGLGENBUFFERSPROC               GenBuffers;
+    PFNGLDELETEBUFFERSPROC            DeleteBuffers;
+    PFNGLBINDBUFFERPROC               BindBuffer;
+    PFNGLBUFFERDATAPROC               BufferData;
+    PFNGLBUFFERSUBDATAPROC            BufferSubData;
+    PFNGLMAPBUFFERPROC                MapBuffer;
+    PFNGLUNMAPBUFFERPROC              UnmapBuffer;
+
+    PFNGLGENFRAMEBUFFERSPROC          GenFramebuffers;
+    PFNGLDELETEFRAMEBUFFERSPROC       DeleteFramebuffers;
+    PFNGLBINDFRAMEBUFFERPROC          BindFramebuffer;
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC   CheckFramebufferStatus;
+    PFNGLGENRENDERBUFFERSPROC         GenRenderbuffers;
+    PFNGLDELETERENDERBUFFERSPROC      DeleteRenderbuffers;
+    PFNGLBINDRENDERBUFFERPROC         BindRenderbuffer;
+    PFNGLRENDERBUFFERSTORAGEPROC      RenderbufferStorage;
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC  FramebufferRenderbuffer;
+
+    PFNGLBLITFRAMEBUFFERPROC          BlitFramebuffer;
+
+    PFNGLCREATESHADERPROC             CreateShader;
+    PFNGLDELETESHADERPROC             DeleteShader;
+    PFNGLSHADERSOURCEPROC             ShaderSource;
+    PFNGLCOMPILESHADERPROC            CompileShader;
+    PFNGLGETSHADERIVPROC              GetShaderiv;
+    PFNGLCREATEPROGRAMPROC            CreateProgram;
+    PFNGLDELETEPROGRAMPROC            DeleteProgram;
+    PFNGLATTACHSHADERPROC             AttachShader;
+    PFNGLBINDATTRIBLOCATIONPROC       BindAttribLocation;
+    PFNGLLINKPROGRAMPROC              LinkProgram;
+    PFNGLGETPROGRAMIVPROC             GetProgramiv;
+    PFNGLUSEPROGRAMPROC               UseProgram;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC  EnableVertexAttribArray;
+    PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+    PFNGLVERTEXATTRIBPOINTERPROC      VertexAttribPointer;
+
+    PFNGLVERTEXATTRIBDIVISORPROC      VertexAttribDivisor;
+    PFNGLDRAWELEMENTSINSTANCEDPROC    DrawElementsInstanced;
+
+    PFNGLGENQUERIESPROC               GenQueries;
+    PFNGLDELETEQUERIESPROC            DeleteQueries;
+    PFNGLGETQUERYOBJECTIVPROC         GetQueryObjectiv;
+    PFNGLQUERYCOUNTERPROC             QueryCounter;
+    PFNGLGETQUERYOBJECTUI64VPROC      GetQueryObjectui64v;
+
+    PFNGLPROGRAMPARAMETERIPROC        ProgramParameteri;
+    PFNGLGETPROGRAMBINARYPROC         GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC            ProgramBinary;
+
+    PFNGLFENCESYNCPROC                FenceSync;
+    PFNGLDELETESYNCPROC               DeleteSync;
+    PFNGLCLIENTWAITSYNCPROC           ClientWaitSync;
+
+    PFNGLBUFFERSTORAGEPROC            BufferStorage;
+    PFNGLMAPBUFFERRANGEPROC           MapBufferRange;
+
+    PFNWGLSWAPINTERVALEXTPROC         SwapIntervalEXT;
+
+}  GLFUNCTIONS;
+
+// the table itself (each render thread has its own), the names below let the code call through it as if the
+// entry points were exported
+extern __declspec(thread) GLFUNCTIONS GLFunctions;
+
+#define glGetStringi                GLFunctions.GetStringi
+#define glGenBuffers                GLFunctions.GenBuffers
+#define glDeleteBuffers             GLFunctions.DeleteBuffers
+#define glBindBuffer                GLFunctions.BindBuffer
+#define glBufferData                GLFunctions.BufferData
+#define glBufferSubData             GLFunctions.BufferSubData
+#define glMapBuffer                 GLFunctions.MapBuffer
+#define glUnmapBuffer               GLFunctions.UnmapBuffer
+#define glGenFramebuffers           GLFunctions.GenFramebuffers
+#define glDeleteFramebuffers        GLFunctions.DeleteFramebuffers
+#define glBindFramebuffer           GLFunctions.BindFramebuffer
+#define glCheckFramebufferStatus    GLFunctions.CheckFramebufferStatus
+#define glGenRenderbuffers          GLFunctions.GenRenderbuffers
+#define glDeleteRenderbuffers       GLFunctions.DeleteRenderbuffers
+#define glBindRenderbuffer          GLFunctions.BindRenderbuffer
+#define glRenderbufferStorage       GLFunctions.RenderbufferStorage
+#define glFramebufferRenderbuffer   GLFunctions.FramebufferRenderbuffer
+#define glBlitFramebuffer           GLFunctions.BlitFramebuffer
+#define glCreateShader              GLFunctions.CreateShader
+#define glDeleteShader              GLFunctions.DeleteShader
+#define glShaderSource              GLFunctions.ShaderSource
+#define glCompileShader             GLFunctions.CompileShader
+#define glGetShaderiv               GLFunctions.GetShaderiv
+#define glCreateProgram             GLFunctions.CreateProgram
+#define glDeleteProgram             GLFunctions.DeleteProgram
+#define glAttachShader              GLFunctions.AttachShader
+#define glBindAttribLocation        GLFunctions.BindAttribLocation
+#define glLinkProgram               GLFunctions.LinkProgram
+#define glGetProgramiv              GLFunctions.GetProgramiv
+#define glUseProgram                GLFunctions.UseProgram
+#define glEnableVertexAttribArray   GLFunctions.EnableVertexAttribArray
+#define glDisableVertexAttribArray  GLFunctions.DisableVertexAttribArray
+#define glVertexAttribPointer       GLFunctions.VertexAttribPointer
+#define glVertexAttribDivisor       GLFunctions.VertexAttribDivisor
+#define glDrawElementsInstanced     GLFunctions.DrawElementsInstanced
+#define glGenQueries                GLFunctions.GenQueries
+#define glDeleteQueries             GLFunctions.DeleteQueries
+#define glGetQueryObjectiv          GLFunctions.GetQueryObjectiv
+#define glQueryCounter              GLFunctions.QueryCounter
+#define glGetQueryObjectui64v       GLFunctions.GetQueryObjectui64v
+#define glProgramParameteri         GLFunctions.ProgramParameteri
+#define glGetProgramBinary          GLFunctions.GetProgramBinary
+#define glProgramBinary             GLFunctions.ProgramBinary
+#define glFenceSync                 GLFunctions.FenceSync
+#define glDeleteSync                GLFunctions.DeleteSync
+#define glClientWaitSync            GLFunctions.ClientWaitSync
+#define glBufferStorage             GLFunctions.BufferStorage
+#define glMapBufferRange            GLFunctions.MapBufferRange
+#define wglSwapIntervalEXT          GLFunctions.SwapIntervalEXT
+
+bool   InitExtensions       (void);
+void   DestroyExtensions    (void);
+double GetGLVersion         (void);
+bool   HasCapability        (GLCAP nCap);
+bool   IsExtensionSupported (const char *szExtension);
+
+#endif  // EXTENSIONS_H
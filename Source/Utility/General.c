@@ -271,54 +271,61 @@ GetCmdLineValue (const LPTSTR szArg, LPTSTR szDest, size_t nLen)
     // validate our data before continuing
     if(((szArg != NULL) && (_tcslen(szArg) > 0)) && ((szCmd != NULL) && (_tcslen(szCmd) > 0)))
     {
-        // look for the / or - delimiters and move back on char in the buffer, this is because we must test
-        // for a space before the argument so we can safely assume it's real and not contained in another string
-        szTest = _tcspbrk(szCmd, _T("/-"));
-
-        // validate and also make sure this isn't the last char in the string
-        if(szTest != NULL && _tcslen(szTest) != 0)
+        // look for the / or - delimiters, every one of them is a possible argument so keep
+        // going until we find a match or run out of delimiters to test the command line with
+        szTest = szCmd;
+        while(!bRetVal && ((szTest = _tcspbrk(szTest, _T("/-"))) != NULL))
         {
             // if we have a space before the delimiter, then we have an argument, so test it
-            szTest = _tcsdec(szCmd, szTest);
-            if(STRING_NMATCH(szTest, _T(" "), 1))
+            // this is because we must test for a space before the argument so we can
+            // safely assume it's real and not contained in another string
+            if((szTest > szCmd) && STRING_NMATCH(_tcsdec(szCmd, szTest), _T(" "), 1))
             {
-                // pass up the space and delimiter to test the argument name
-                szTest = _tcsinc(szTest);
+                // pass up the delimiter to test the argument name
                 szTest = _tcsinc(szTest);
 
                 if(STRING_NMATCH(szArg, szTest, _tcslen(szArg)))
                 {
-                    // we have a match, now we need to also check to see to see if the argument has a
-                    // value associated with it, so check to see if there is an = after it
+                    // the name must end where the argument does, otherwise /frame would match /frames
                     szTest = _tcsninc(szTest, _tcslen(szArg));
-                    if(szTest != NULL && STRING_NMATCH(szTest, _T("="), 1))
+                    if((*szTest == _T('\0')) || (*szTest == _T(' ')) || (*szTest == _T('=')))
                     {
-                        // we have one, see what data (until the next space) is there
-                        szTest = _tcsinc(szTest);
-                        if(szTest != NULL)
+                        // we have a match, now we need to also check to see to see if the argument has a
+                        // value associated with it, so check to see if there is an = after it
+                        if(STRING_NMATCH(szTest, _T("="), 1))
                         {
-                            LPTSTR szTemp = NULL;
-
-                            szTemp = (LPTSTR)_tcschr(szTest, _T(' '));
-                            if(szTemp != NULL)
+                            // we have one, see what data (until the next space) is there
+                            szTest = _tcsinc(szTest);
+                            if(szTest != NULL)
                             {
-                                // take everything the buffer will hold, up until the space
-                                if(nLen > (size_t)(szTemp - szTest))
-                                    _tcsncpy_s(szDest, nLen, szTest, szTemp - szTest);
+                                LPTSTR szTemp = NULL;
+
+                                szTemp = (LPTSTR)_tcschr(szTest, _T(' '));
+                                if(szTemp != NULL)
+                                {
+                                    // take everything the buffer will hold, up until the space
+                                    if(nLen > (size_t)(szTemp - szTest))
+                                        _tcsncpy_s(szDest, nLen, szTest, szTemp - szTest);
+                                    else
+                                        _tcsncpy_s(szDest, nLen, szTest, nLen);
+                                }
                                 else
+                                {
+                                    // take everything the buffer will hold
                                     _tcsncpy_s(szDest, nLen, szTest, nLen);
-                            }
-                            else
-                            {
-                                // take everything the buffer will hold
-                                _tcsncpy_s(szDest, nLen, szTest, nLen);
+                                }
                             }
                         }
-                    }
 
-                    bRetVal = true;
+                        bRetVal = true;
+                    }
                 }
             }
+            else
+            {
+                // not an argument, move past this delimiter and keep looking
+                szTest = _tcsinc(szTest);
+            }
         }
     }
 
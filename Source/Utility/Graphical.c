@@ -1,4 +1,5 @@
 #include "Main\Application.h"   // standard application include
+#include "Utility\Extensions.h" // GL extension routines
 #include "Utility\General.h"    // general utility routines
 #include "Utility\Graphical.h"  // include for this file
 
@@ -8,37 +9,84 @@
 
 /*/
 / / PARAMETERS:
-/ /     none
+/ /     pTarget = pointer to the structure that receives the names of the created GL objects
+/ /     nWidth = width of the offscreen render target in pixels
+/ /     nHeight = height of the offscreen render target in pixels
 / /
 / / PURPOSE:
-/ /     Returns the number of successive CPU cycles in hertz (aka, per second) since the last
-/ /     time this routine was called. Typically used for timing animations.
+/ /     Creates a framebuffer object with a color and depth renderbuffer of the requested size and binds it, so all
+/ /     rendering that follows goes into it rather than the window. Returns false if the GL cannot provide one.
 / /
-/ / CREDITS:
-/ /        This routine was based on the work of Jeffry J. Brickley.
+/ / NOTE:
+/ /     This needs to be called after there's a valid RC (Render Context). It works with the core entry points
+/ /     or the EXT extension, so software implementations such as Mesa's llvmpipe opengl32.dll can be used.
 /*/
 
-double
-GetCPUTicks (void)
+bool
+CreateOffscreen (POFFSCREEN pTarget, unsigned int nWidth, unsigned int nHeight)
 {
-    static LARGE_INTEGER nFreq = {0}, nCount = {0};
-    static double dReturn = 0.0, dCheckTime = 5.0;
+    GLenum glStatus = 0;
 
-    // check for a new frequency once every 5 seconds
-    // this is in case ACPI, etc. alters it
-    if((nFreq.QuadPart == 0) || (dCheckTime < dReturn))
-    {
-        dCheckTime = dReturn + 5.0;
+    if((pTarget == NULL) || (nWidth == 0) || (nHeight == 0)) return false;
+
+    // the entry points come from either the core/ARB or the EXT names, InitExtensions() settled which
+    if(!HasCapability(CAP_FRAMEBUFFERS)) return false;
+
+    memset(pTarget, 0, sizeof(OFFSCREEN));
+    pTarget->nWidth = nWidth;
+    pTarget->nHeight = nHeight;
+
+    // the color and depth storage both live in renderbuffers, we never sample from them
+    glGenRenderbuffers(1, &pTarget->nColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, pTarget->nColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, nWidth, nHeight);
+
+    glGenRenderbuffers(1, &pTarget->nDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, pTarget->nDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, nWidth, nHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // attach both to the framebuffer and leave it bound so it replaces the window as the draw target
+    glGenFramebuffers(1, &pTarget->nFrameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, pTarget->nFrameBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, pTarget->nColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, pTarget->nDepthBuffer);
 
-        // avoid a division by zero by returning zero on error
-        if(!QueryPerformanceFrequency(&nFreq)) return 0.0;
+    glStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(glStatus != GL_FRAMEBUFFER_COMPLETE)
+    {
+        DestroyOffscreen(pTarget);
+        return false;
     }
 
-    // use the ratio of tick amount divided by frequency to find the hertz
-    QueryPerformanceCounter(&nCount);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pTarget = pointer to an offscreen render target previously filled in by CreateOffscreen()
+/ /
+/ / PURPOSE:
+/ /     Unbinds and deletes the GL objects of an offscreen render target, rendering goes back to the window.
+/ /
+/ / NOTE:
+/ /     This must be called in the context of the thread that created the render target.
+/*/
+
+void
+DestroyOffscreen (POFFSCREEN pTarget)
+{
+    if((pTarget == NULL) || !HasCapability(CAP_FRAMEBUFFERS)) return;
 
-    dReturn = ((double)nCount.QuadPart / (double)nFreq.QuadPart);
-    return dReturn;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if(pTarget->nFrameBuffer != 0) glDeleteFramebuffers(1, &pTarget->nFrameBuffer);
+    if(pTarget->nColorBuffer != 0) glDeleteRenderbuffers(1, &pTarget->nColorBuffer);
+    if(pTarget->nDepthBuffer != 0) glDeleteRenderbuffers(1, &pTarget->nDepthBuffer);
+
+    memset(pTarget, 0, sizeof(OFFSCREEN));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -127,21 +175,8 @@ OnGLError (LPCTSTR szProcedure)
 void
 SetVerticalSync (bool bSync)
 {
-    // this does not support Unicode, but that's ok because the user
-    // will never see the string data that we test with
-    const char *szExt = (char *)glGetString(GL_EXTENSIONS);
-
-    // only attempt this if the extension is supported
-    if((szExt != NULL) && (strstr(szExt, "WGL_EXT_swap_control") != NULL))
-    {
-        typedef bool (APIENTRY *PFNWGLSWAPINTERVALFARPROC) (int);
-        PFNWGLSWAPINTERVALFARPROC wglSwapIntervalEXT = NULL;
-
-        // this accepts one parameter, 0 = off and 1 = on
-        wglSwapIntervalEXT = (PFNWGLSWAPINTERVALFARPROC)wglGetProcAddress("wglSwapIntervalEXT");
-
-        if(wglSwapIntervalEXT != NULL) wglSwapIntervalEXT(bSync);
-    }
+    // only attempt this if the extension is supported, this accepts one parameter, 0 = off and 1 = on
+    if(HasCapability(CAP_SWAP_CONTROL)) wglSwapIntervalEXT(bSync);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,8 +1,20 @@
 #if !defined (GRAPHICAL_H_0E27CE88_B088_4DD3_AB1C_D28C05189A82_)
 #define GRAPHICAL_H_0E27CE88_B088_4DD3_AB1C_D28C05189A82_
 
-double GetCPUTicks     (void);
-void   SetVerticalSync (bool bSync);
+// describes an offscreen render target (framebuffer object) used for headless rendering
+typedef struct
+{
+    GLuint       nFrameBuffer;      // name of the framebuffer object
+    GLuint       nColorBuffer;      // name of the color renderbuffer attached to the framebuffer
+    GLuint       nDepthBuffer;      // name of the depth renderbuffer attached to the framebuffer
+    unsigned int nWidth;            // width of the render target in pixels
+    unsigned int nHeight;           // height of the render target in pixels
+
+}  OFFSCREEN, *POFFSCREEN;
+
+bool CreateOffscreen  (POFFSCREEN pTarget, unsigned int nWidth, unsigned int nHeight);
+void DestroyOffscreen (POFFSCREEN pTarget);
+void SetVerticalSync  (bool bSync);
 
 #ifdef _DEBUG
     // helper function(s) for OGL error reporting
@@ -0,0 +1,206 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\Graphical.h"      // graphical utility routines
+#include "Utility\Instancing.h"     // include for this file
+#include "Utility\Shader.h"         // shader program routines
+#include "Utility\State.h"          // render state routines
+#include "Utility\Stream.h"         // streaming buffer routines
+#include <stddef.h>                 // offsetof()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// INSTANCED RENDERING ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// generic attribute slots of the per-instance data, the transform takes four consecutive slots
+// note: slot zero is avoided as some drivers alias it with gl_Vertex
+#define ATTRIB_TRANSFORM    1
+#define ATTRIB_COLOR        5
+
+// the vertex shader emulates what __initRender() sets up for the fixed-function pipeline: a single
+// positional light (GL_LIGHT0) lighting the diffuse color, which comes from the vertex color
+static const char *_szVertexShader =
+    "#version 120\n"
+    "attribute mat4 InstanceTransform;\n"
+    "attribute vec4 InstanceColor;\n"
+    "varying vec4 Color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vEye = gl_ModelViewMatrix * (InstanceTransform * gl_Vertex);\n"
+    "    vec3 vNormal = normalize(gl_NormalMatrix * (mat3(InstanceTransform) * gl_Normal));\n"
+    "    vec3 vLight = normalize(gl_LightSource[0].position.xyz - (vEye.xyz * gl_LightSource[0].position.w));\n"
+    "    vec4 vDiffuse = gl_Color * InstanceColor;\n"
+    "    Color = gl_FrontLightModelProduct.sceneColor + (gl_LightSource[0].diffuse * vDiffuse * max(dot(vNormal, vLight), 0.0));\n"
+    "    Color.a = vDiffuse.a;\n"
+    "    gl_Position = gl_ProjectionMatrix * vEye;\n"
+    "}\n";
+
+static const char *_szFragmentShader =
+    "#version 120\n"
+    "varying vec4 Color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = Color;\n"
+    "}\n";
+
+// the slots must be fixed before linking so DrawInstanced() knows where to feed the data
+static const ATTRIBSLOT _Slots[] = {{"InstanceTransform", ATTRIB_TRANSFORM}, {"InstanceColor", ATTRIB_COLOR}};
+
+// local variables (kept per render thread, the names belong to its RC)
+static __declspec(thread) GLuint _nProgram        = 0;     // name of the linked instancing program (zero if not available)
+static __declspec(thread) GLuint _nInstanceBuffer = 0;     // name of the buffer object the per-instance data is streamed into
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases the program and buffer object created by InitInstancing() (if any).
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, before the RC is destroyed.
+/*/
+
+void
+DestroyInstancing (void)
+{
+    if(_nProgram != 0)
+    {
+        UseProgram(0);
+        FreeProgram(_nProgram);
+        SetBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &_nInstanceBuffer);
+
+        _nProgram = _nInstanceBuffer = 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nIndices = number of indices that make up one instance of the mesh
+/ /     eType = type of the indices in the bound element buffer (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, etc.)
+/ /     pInstances = array of per-instance transforms and colors
+/ /     nInstances = number of elements in the array, and thus the number of copies drawn
+/ /
+/ / PURPOSE:
+/ /     Draws many copies of the mesh currently set up in the vertex (gl_Vertex, gl_Normal and gl_Color)
+/ /     and element arrays with a single instanced draw call. The per-instance data is streamed into
+/ /     the streaming ring every call (or a buffer object of its own if it doesn't fit), so the instances
+/ /     are free to change from one frame to the next.
+/ /
+/ / NOTES:
+/ /     If instancing is not available, every instance is drawn with its own matrix and draw call instead
+/ /     (the instance colors are ignored then). This must be called in the context of the render thread.
+/*/
+
+void
+DrawInstanced (GLsizei nIndices, GLenum eType, const INSTANCE *pInstances, GLsizei nInstances)
+{
+    GLintptr nOffset = 0;
+    void *pStream = NULL;
+    GLuint i = 0;
+
+    if((pInstances == NULL) || (nInstances <= 0)) return;
+
+    if(_nProgram == 0)
+    {
+        // the fallback, which is the same matrix stack path we are trying to avoid
+        for(i = 0; i < (GLuint)nInstances; i++)
+        {
+            glPushMatrix();
+                glMultMatrixf(pInstances[i].afTransform);
+                glDrawElements(GL_TRIANGLES, nIndices, eType, NULL);
+            glPopMatrix();
+        }
+        return;
+    }
+
+    if((pStream = MapStream(nInstances * sizeof(INSTANCE), &nOffset)) != NULL)
+    {
+        // copied in order into the ring, the GL reads it from there without the driver copying it again
+        memcpy(pStream, pInstances, nInstances * sizeof(INSTANCE));
+        UnmapStream(nInstances * sizeof(INSTANCE));
+        SetBuffer(GL_ARRAY_BUFFER, GetStreamBuffer());
+    }
+    else
+    {
+        // respecify the whole store every call so the driver can orphan the old one rather than wait on it
+        SetBuffer(GL_ARRAY_BUFFER, _nInstanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, nInstances * sizeof(INSTANCE), pInstances, GL_STREAM_DRAW);
+    }
+
+    // a matrix attribute is fed one column per slot, each advancing once per instance rather than per vertex
+    for(i = 0; i < 4; i++)
+    {
+        glVertexAttribPointer(ATTRIB_TRANSFORM + i, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE),
+            (const GLvoid *)(nOffset + offsetof(INSTANCE, afTransform) + (i * 4 * sizeof(GLfloat))));
+        glVertexAttribDivisor(ATTRIB_TRANSFORM + i, 1);
+        glEnableVertexAttribArray(ATTRIB_TRANSFORM + i);
+    }
+
+    glVertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(INSTANCE), (const GLvoid *)(nOffset + offsetof(INSTANCE, acColor)));
+    glVertexAttribDivisor(ATTRIB_COLOR, 1);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+
+    UseProgram(_nProgram);
+    glDrawElementsInstanced(GL_TRIANGLES, nIndices, eType, NULL, nInstances);
+    UseProgram(0);
+
+    // leave the generic arrays disabled so they can't leak into later fixed-function draws
+    for(i = 0; i < 5; i++) glDisableVertexAttribArray(ATTRIB_TRANSFORM + i);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Loads the program used to draw instances (from the program binary cache if it's there) and creates the
+/ /     buffer the instances are streamed into. Returns true if instanced drawing is available, otherwise
+/ /     DrawInstanced() falls back to drawing every instance separately.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, after InitShaders() has been.
+/ /     This requires GL 2.0 shaders along with ARB_draw_instanced and ARB_instanced_arrays (or GL 3.3).
+/*/
+
+bool
+InitInstancing (void)
+{
+    if(_nProgram != 0) return true;
+
+    // only attempt this if the extensions are supported (instanced arrays came in with 3.3)
+    if(!HasCapability(CAP_INSTANCING) || !HasCapability(CAP_VERTEX_BUFFERS)) return false;
+
+    // the program is built by the shader routines, so they have to be up already
+    if(!IsShadingReady()) return false;
+
+    _nProgram = LoadProgram(_szVertexShader, _szFragmentShader, _Slots, sizeof(_Slots) / sizeof(_Slots[0]));
+    if(_nProgram != 0) glGenBuffers(1, &_nInstanceBuffer);
+
+    return (_nProgram != 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns true if DrawInstanced() issues real instanced draw calls rather than the fallback.
+/*/
+
+bool
+IsInstancingReady (void)
+{
+    return (_nProgram != 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,20 @@
+#if !defined (INSTANCING_H_5B1D7E42_93A6_4C1F_B8E0_2F6A4D9C1E37_)
+#define INSTANCING_H_5B1D7E42_93A6_4C1F_B8E0_2F6A4D9C1E37_
+
+#pragma once  // in case the compiler supports it
+
+// per-instance data, the transform is applied before the current modelview matrix and the color
+// modulates the color of every vertex of the mesh drawn for that instance
+typedef struct
+{
+    GLfloat afTransform[16];        // column major 4x4 object to world transform (same layout as glMultMatrixf)
+    GLubyte acColor[4];             // RGBA tint multiplied with the vertex color
+
+}  INSTANCE, *PINSTANCE;
+
+bool InitInstancing    (void);
+void DestroyInstancing (void);
+void DrawInstanced     (GLsizei nIndices, GLenum eType, const INSTANCE *pInstances, GLsizei nInstances);
+bool IsInstancingReady (void);
+
+#endif  // INSTANCING_H
@@ -0,0 +1,460 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Jobs.h"       // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////// JOB ROUTINES /////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / Every thread that runs jobs (the thread that called InitJobs() plus the workers) owns a deque of jobs. A thread
+/ / pushes and pops jobs at the bottom of its own deque without contention, and when it runs dry it steals from
+/ / the top of someone else's, so the work spreads itself out to whichever threads are free. These are Chase-Lev
+/ / deques: the owner and the thieves only ever race for the last job, and an interlocked compare-exchange on the
+/ / top index settles who gets it. The indices only ever grow and are compared by their difference, so they are
+/ / free to wrap around. Workers that find nothing to do for a while go to sleep on a semaphore, so an idle job
+/ / system costs no CPU.
+/*/
+
+#define MAX_WORKERS     63          // most worker threads, one less than WaitForMultipleObjects() can wait on
+#define DEQUE_SIZE      1024        // jobs a deque can hold (must be a power of two)
+#define IDLE_SPINS      2000        // times a worker looks for work before it goes to sleep
+
+typedef struct
+{
+    JobDelegate    pJob;            // function that does the work
+    void          *pData;           // data passed to the function
+    unsigned int   nBegin;          // first item of the range
+    unsigned int   nEnd;            // one past the last item of the range
+    volatile LONG *pPending;        // counter decremented once the job is done
+
+}  JOB, *PJOB;
+
+typedef struct
+{
+    volatile LONG nTop;             // next job to steal (thieves advance this)
+    BYTE          acPadTop[60];     // keeps the indices on separate cache lines
+    volatile LONG nBottom;          // next free slot (only the owner writes this)
+    BYTE          acPadBottom[60];  // keeps the indices on separate cache lines
+    JOB           aJobs[DEQUE_SIZE];
+
+}  DEQUE, *PDEQUE;
+
+// local function prototypes
+static bool                  __popJob     (PDEQUE pDeque, PJOB pJob);
+static bool                  __pushJob    (PDEQUE pDeque, const JOB *pJob);
+static void                  __runJob     (const JOB *pJob);
+static bool                  __stealJob   (unsigned int nThief, PJOB pJob);
+static bool                  __findJob    (unsigned int nThread, PJOB pJob);
+static unsigned int __stdcall __workerMain (void *pArg);
+
+// local variables
+static PDEQUE        _pDeques = NULL;                   // one deque per thread, the first belongs to the thread that called InitJobs()
+static unsigned int  _nThreads = 0;                     // number of deques (workers plus one)
+static HANDLE        _ahWorkers[MAX_WORKERS];           // handles of the worker threads
+static HANDLE        _hWakeWorkers = NULL;              // semaphore sleeping workers wait on
+static volatile bool _bStopWorkers = false;             // flag to indicate the workers should exit
+
+// index of the deque the current thread owns (anything other than a job thread runs jobs inline), and
+// the deque it last tried to steal from
+static __declspec(thread) int _nThread = -1;
+static __declspec(thread) unsigned int _nVictim = 0;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nWorkers = number of worker threads to start (zero means one less than the number of processors)
+/ /
+/ / PURPOSE:
+/ /     Starts the worker threads. The calling thread becomes a job thread as well, it takes part in running
+/ /     the jobs it hands out with ParallelFor(). Returns false if the workers could not be started, in which
+/ /     case ParallelFor() still works but runs everything on the calling thread.
+/ /
+/ / NOTES:
+/ /     This should only be called once, from the thread that is going to call ParallelFor().
+/*/
+
+bool
+InitJobs (unsigned int nWorkers)
+{
+    SYSTEM_INFO Info = {0};
+    unsigned int i = 0;
+
+    if(_pDeques != NULL) return true;
+
+    if(nWorkers == 0)
+    {
+        GetSystemInfo(&Info);
+        nWorkers = (Info.dwNumberOfProcessors > 1) ? Info.dwNumberOfProcessors - 1 : 0;
+    }
+
+    if(nWorkers > MAX_WORKERS) nWorkers = MAX_WORKERS;
+
+    // the deques are big and the indices must be kept apart, so they get their own (page aligned) memory
+    _pDeques = (PDEQUE)VirtualAlloc(NULL, (nWorkers + 1) * sizeof(DEQUE), MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+    if(_pDeques == NULL) return false;
+
+    _nThreads = 1;
+    _nThread = 0;
+    _bStopWorkers = false;
+
+    if(nWorkers > 0)
+    {
+        _hWakeWorkers = CreateSemaphore(NULL, 0, nWorkers, NULL);
+        if(_hWakeWorkers == NULL) return false;
+
+        for(i = 0; i < nWorkers; i++)
+        {
+            // do not use CreateThread() to avoid leaks caused by the CRT
+            _ahWorkers[i] = (HANDLE)_beginthreadex(NULL, 0, __workerMain, (void *)(UINT_PTR)(i + 1), 0, NULL);
+            if(_ahWorkers[i] == NULL) break;
+
+            _nThreads++;
+        }
+    }
+
+    return (_nThreads == (nWorkers + 1));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Stops the worker threads and releases the deques.
+/ /
+/ / NOTES:
+/ /     This must be called by the same thread that called InitJobs(), while no ParallelFor() is running.
+/*/
+
+void
+DestroyJobs (void)
+{
+    unsigned int nWorkers = 0;
+
+    if(_pDeques == NULL) return;
+
+    nWorkers = _nThreads - 1;
+    _bStopWorkers = true;
+
+    if(nWorkers > 0)
+    {
+        // counts left over from ParallelFor() may already fill the semaphore, and it refuses a release that would
+        // go past its maximum as a whole, so it's given one count at a time until every worker has seen the flag
+        do
+        {
+            ReleaseSemaphore(_hWakeWorkers, 1, NULL);
+
+        } while(WaitForMultipleObjects(nWorkers, _ahWorkers, TRUE, 1) == WAIT_TIMEOUT);
+
+        while(nWorkers > 0) CloseHandle(_ahWorkers[--nWorkers]);
+    }
+
+    if(_hWakeWorkers != NULL) CloseHandle(_hWakeWorkers);
+    VirtualFree(_pDeques, 0, MEM_RELEASE);
+
+    _hWakeWorkers = NULL;
+    _pDeques = NULL;
+    _nThreads = 0;
+    _nThread = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the number of threads that run jobs, including the one that called InitJobs(). This is
+/ /     one if InitJobs() hasn't been called, so it's always safe to divide work by it.
+/*/
+
+unsigned int
+GetJobThreads (void)
+{
+    return (_nThreads > 0) ? _nThreads : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns which job thread the calling thread is, zero for the one that called InitJobs() and one up for the
+/ /     workers, or -1 if it doesn't run jobs. Anything kept per thread can be indexed by this.
+/*/
+
+int
+GetJobThread (void)
+{
+    return _nThread;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nCount = number of items to process
+/ /     nGrain = number of items per job (zero picks a size that gives every thread a few jobs)
+/ /     pJob = function that processes a range of items
+/ /     pData = data passed to the function
+/ /
+/ / PURPOSE:
+/ /     Splits the items into ranges of nGrain and runs pJob on every range, spread across all the job
+/ /     threads, then returns once they are all done. The calling thread runs jobs too while it waits.
+/ /
+/ / NOTES:
+/ /     This may be called from within a job, the inner ranges are then stolen like any other. If it's
+/ /     called from a thread that doesn't run jobs, or the job system isn't running, the items are simply
+/ /     processed on the calling thread.
+/*/
+
+void
+ParallelFor (unsigned int nCount, unsigned int nGrain, JobDelegate pJob, void *pData)
+{
+    volatile LONG nPending = 0;
+    unsigned int nBegin = 0, nWake = 0;
+    JOB Job = {0};
+
+    if((pJob == NULL) || (nCount == 0)) return;
+
+    if(nGrain == 0) nGrain = (nCount / (GetJobThreads() * 4)) + 1;
+
+    // nothing to spread out, or nobody to spread it to, so just do it here
+    if((_pDeques == NULL) || (_nThread < 0) || (nCount <= nGrain) || (_nThreads < 2))
+    {
+        pJob(pData, 0, nCount);
+        return;
+    }
+
+    Job.pJob = pJob;
+    Job.pData = pData;
+    Job.pPending = &nPending;
+
+    for(nBegin = 0; nBegin < nCount; nBegin += nGrain)
+    {
+        Job.nBegin = nBegin;
+        Job.nEnd = ((nCount - nBegin) > nGrain) ? nBegin + nGrain : nCount;
+
+        // count the job before it's visible, a thief may finish it before we get to the next line
+        InterlockedIncrement(&nPending);
+
+        if(__pushJob(&_pDeques[_nThread], &Job))
+        {
+            nWake++;
+        }
+        else
+        {
+            // our deque is full, so this one we do ourselves
+            __runJob(&Job);
+        }
+    }
+
+    // wake up as many sleeping workers as there are jobs for, the semaphore refuses counts past its maximum
+    if(nWake > (_nThreads - 1)) nWake = _nThreads - 1;
+    while((nWake-- > 0) && ReleaseSemaphore(_hWakeWorkers, 1, NULL));
+
+    // help out until every range is done, this may run jobs of other ParallelFor() calls as well
+    while(nPending > 0)
+    {
+        if(__findJob((unsigned int)_nThread, &Job))
+            __runJob(&Job);
+        else
+            YieldProcessor();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pDeque = deque owned by the calling thread
+/ /     pJob = receives a copy of the job
+/ /
+/ / PURPOSE:
+/ /     Takes the newest job off the bottom of the caller's own deque. Returns false if it's empty.
+/*/
+
+static bool
+__popJob (PDEQUE pDeque, PJOB pJob)
+{
+    LONG nBottom = pDeque->nBottom - 1, nTop = 0;
+    bool bReturn = true;
+
+    // the exchange is a full barrier, so thieves see the smaller bottom before we look at the top
+    InterlockedExchange(&pDeque->nBottom, nBottom);
+    nTop = pDeque->nTop;
+
+    if((nBottom - nTop) < 0)
+    {
+        // it was already empty
+        pDeque->nBottom = nBottom + 1;
+        return false;
+    }
+
+    *pJob = pDeque->aJobs[nBottom & (DEQUE_SIZE - 1)];
+
+    if(nBottom == nTop)
+    {
+        // this is the last job, so we race the thieves for it
+        bReturn = (InterlockedCompareExchange(&pDeque->nTop, nTop + 1, nTop) == nTop);
+        pDeque->nBottom = nBottom + 1;
+    }
+
+    return bReturn;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pDeque = deque owned by the calling thread
+/ /     pJob = job to copy into the deque
+/ /
+/ / PURPOSE:
+/ /     Adds a job to the bottom of the caller's own deque. Returns false if it's full.
+/*/
+
+static bool
+__pushJob (PDEQUE pDeque, const JOB *pJob)
+{
+    LONG nBottom = pDeque->nBottom;
+
+    if((nBottom - pDeque->nTop) >= DEQUE_SIZE) return false;
+
+    pDeque->aJobs[nBottom & (DEQUE_SIZE - 1)] = *pJob;
+
+    // publish the job only after it's been written
+    InterlockedExchange(&pDeque->nBottom, nBottom + 1);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pJob = job to run
+/ /
+/ / PURPOSE:
+/ /     Runs a job and lets whoever handed it out know it's done.
+/*/
+
+static void
+__runJob (const JOB *pJob)
+{
+    pJob->pJob(pJob->pData, pJob->nBegin, pJob->nEnd);
+    InterlockedDecrement(pJob->pPending);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nThief = index of the deque owned by the calling thread (it's skipped)
+/ /     pJob = receives a copy of the job
+/ /
+/ / PURPOSE:
+/ /     Takes the oldest job off the top of another thread's deque, every thread goes round the victims
+/ /     from where it left off last time so the thieves don't all pile onto the same deque. Returns false
+/ /     if every other deque is empty (or every attempt lost a race).
+/*/
+
+static bool
+__stealJob (unsigned int nThief, PJOB pJob)
+{
+    unsigned int i = 0;
+    PDEQUE pDeque = NULL;
+    LONG nTop = 0, nBottom = 0;
+
+    for(i = 0; i < _nThreads; i++)
+    {
+        _nVictim = (_nVictim + 1) % _nThreads;
+        if(_nVictim == nThief) continue;
+
+        pDeque = &_pDeques[_nVictim];
+
+        nTop = pDeque->nTop;
+        MemoryBarrier();
+        nBottom = pDeque->nBottom;
+
+        if((nBottom - nTop) > 0)
+        {
+            // copy the job out before claiming it, the owner can't reuse the slot while the top still points at it
+            *pJob = pDeque->aJobs[nTop & (DEQUE_SIZE - 1)];
+            if(InterlockedCompareExchange(&pDeque->nTop, nTop + 1, nTop) == nTop) return true;
+        }
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nThread = index of the deque owned by the calling thread
+/ /     pJob = receives a copy of the job
+/ /
+/ / PURPOSE:
+/ /     Looks for a job, first in the caller's own deque and then in everyone else's.
+/*/
+
+static bool
+__findJob (unsigned int nThread, PJOB pJob)
+{
+    return __popJob(&_pDeques[nThread], pJob) || __stealJob(nThread, pJob);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArg = index of the deque the worker owns
+/ /
+/ / PURPOSE:
+/ /     Main loop of a worker thread, it runs jobs for as long as it finds any, and sleeps otherwise.
+/ /
+/ / NOTES:
+/ /     The function must be declared as __stdcall.
+/*/
+
+static unsigned int __stdcall
+__workerMain (void *pArg)
+{
+    unsigned int nSpins = 0;
+    JOB Job = {0};
+
+    _nThread = (int)(UINT_PTR)pArg;
+
+    while(!_bStopWorkers)
+    {
+        if(__findJob((unsigned int)_nThread, &Job))
+        {
+            __runJob(&Job);
+            nSpins = 0;
+        }
+        else if(++nSpins < IDLE_SPINS)
+        {
+            // jobs tend to come in bursts (one ParallelFor() after another), so look again shortly
+            YieldProcessor();
+        }
+        else
+        {
+            // nothing has come along for a while, so sleep until ParallelFor() has work again
+            WaitForSingleObject(_hWakeWorkers, INFINITE);
+            nSpins = 0;
+        }
+    }
+
+    _endthreadex(0);
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,16 @@
+#if !defined (JOBS_H_6A2E9F13_D85C_4B70_8E31_0C7B4A95E2D6_)
+#define JOBS_H_6A2E9F13_D85C_4B70_8E31_0C7B4A95E2D6_
+
+#pragma once  // in case the compiler supports it
+
+// delegate function that does the work of one job, it's handed the items from nBegin up to (but not including) nEnd
+// it may be called on any thread at the same time as other parts of the range, so it must not touch the GL
+typedef void (*JobDelegate) (void *pData, unsigned int nBegin, unsigned int nEnd);
+
+bool         InitJobs       (unsigned int nWorkers);
+void         DestroyJobs    (void);
+unsigned int GetJobThreads  (void);
+int          GetJobThread   (void);
+void         ParallelFor    (unsigned int nCount, unsigned int nGrain, JobDelegate pJob, void *pData);
+
+#endif  // JOBS_H
@@ -0,0 +1,663 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\Loader.h"         // include for this file
+#include "Utility\Queue.h"          // single producer queue routines
+#include "Utility\State.h"          // render state routines
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// ASSET LOADER ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / Only the render thread has the RC, but nothing about reading or decoding a file needs it. So the render thread
+/ / queues the files it wants, a loader thread of its own reads and decodes them, and queues the results back. The
+/ / render thread then uploads them with UpdateLoader() once a frame, never more than the budget it's given, so a
+/ / big file is spread over several frames instead of stalling one. Texture rows go through a pixel buffer object
+/ / when there is one: the slice is copied into the orphaned buffer and glTexSubImage2D() reads it from there, so
+/ / the driver can schedule the transfer instead of copying the rows before it returns. Once the last slice is in,
+/ / the delegate that asked for the file gets its texture or buffer object.
+/*/
+
+#define MAX_LOADS       16              // loads that can be outstanding at once (must be a power of two)
+#define STAGING_SIZE    (1024 * 1024)   // most bytes staged through the pixel buffer object at once
+#define MIN_SLICE       4096            // fewest bytes of a buffer uploaded in a frame, however small the budget
+
+// a file the render thread wants, on its way to the loader thread
+typedef struct
+{
+    DWORD    nLoad;                 // id handed out by RequestLoad()
+    LOADTYPE nType;                 // what to decode the file into
+    TCHAR    szFile[MAX_PATH];      // path of the file
+
+}  LOADREQUEST;
+
+// a decoded file, on its way back to the render thread
+typedef struct
+{
+    DWORD    nLoad;                 // id handed out by RequestLoad()
+    LOADTYPE nType;                 // what the file was decoded into
+    BYTE    *pData;                 // decoded data (NULL if the file couldn't be read or decoded)
+    size_t   nSize;                 // bytes of decoded data
+    UINT     nWidth;                // width of the texture in pixels (LOAD_TEXTURE only)
+    UINT     nHeight;               // height of the texture in pixels (LOAD_TEXTURE only)
+
+}  LOADDATA;
+
+// a load that hasn't been handed to its delegate yet, only the render thread sees these
+typedef struct
+{
+    DWORD        nLoad;             // id handed out by RequestLoad()
+    LoadDelegate pDone;             // function to call once the load is done
+    void        *pContext;          // data passed to the function
+
+}  PENDINGLOAD;
+
+// local function prototypes
+static bool                  __beginUpload  (void);
+static bool                  __decodeBitmap (const BYTE *pFile, size_t nFile, LOADDATA *pData);
+static void                  __finishUpload (bool bSuccess);
+static int                   __findPending  (DWORD nLoad);
+static unsigned int __stdcall __loaderMain   (void *pArg);
+static BYTE                 *__readFile     (LPCTSTR szFile, size_t *pSize);
+static size_t                __uploadSlice  (size_t nBudget);
+
+// local variables
+static LOADREQUEST   _aRequests[MAX_LOADS];             // storage for the files asked for
+static QUEUE         _Requests = QUEUE_INIT(_aRequests);
+static LOADDATA      _aDecoded[MAX_LOADS];              // storage for the decoded files
+static QUEUE         _Decoded = QUEUE_INIT(_aDecoded);
+
+static PENDINGLOAD   _aPending[MAX_LOADS];              // loads asked for and not yet done
+static unsigned int  _nPending = 0;                     // number of loads asked for and not yet done
+static DWORD         _nLastLoad = 0;                    // id of the last load asked for
+
+static LOADDATA      _Current = {0};                    // decoded file being uploaded
+static bool          _bUploading = false;               // flag to indicate _Current is being uploaded
+static GLuint        _nUploadName = 0;                  // texture or buffer object _Current is uploaded into
+static size_t        _nUploaded = 0;                    // bytes of _Current uploaded so far
+static GLuint        _nStaging = 0;                     // pixel buffer object texture rows are staged through
+
+static HANDLE        _hThread = NULL;                   // handle of the loader thread
+static HANDLE        _hWake = NULL;                     // signaled whenever a file is asked for
+static volatile bool _bStopLoader = false;              // flag to indicate the loader thread should exit
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Starts the loader thread. Returns false if it could not be started, RequestLoad() fails then.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, after InitExtensions().
+/*/
+
+bool
+InitLoader (void)
+{
+    if(_hThread != NULL) return true;
+
+    _bStopLoader = false;
+    if((_hWake = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL) return false;
+
+    // do not use CreateThread() to avoid leaks caused by the CRT
+    _hThread = (HANDLE)_beginthreadex(NULL, 0, __loaderMain, NULL, 0, NULL);
+    if(_hThread == NULL)
+    {
+        CloseHandle(_hWake);
+        _hWake = NULL;
+        return false;
+    }
+
+    // reading files shouldn't take time away from drawing them
+    SetThreadPriority(_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+
+    // texture rows are staged through a buffer of our own, if the GL can take pixels from one
+    if(HasCapability(CAP_VERTEX_BUFFERS) && HasCapability(CAP_PIXEL_BUFFERS)) glGenBuffers(1, &_nStaging);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Stops the loader thread and drops every load that hasn't finished, their delegates are not called.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+void
+DestroyLoader (void)
+{
+    LOADREQUEST Request;
+    LOADDATA Data;
+
+    if(_hThread == NULL) return;
+
+    _bStopLoader = true;
+    SetEvent(_hWake);
+    WaitForSingleObject(_hThread, INFINITE);
+
+    CloseHandle(_hThread);
+    CloseHandle(_hWake);
+    _hThread = _hWake = NULL;
+
+    // the loader thread is gone, so whatever it left in either queue can be emptied from here
+    while(PopQueueItem(&_Requests, &Request));
+    while(PopQueueItem(&_Decoded, &Data)) free(Data.pData);
+
+    _nPending = 0;
+    if(_bUploading) __finishUpload(false);
+
+    if(_nStaging != 0)
+    {
+        SetBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &_nStaging);
+        _nStaging = 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szFile = path of the file to load
+/ /     nType = what to load it into
+/ /     pDone = function to call once it's loaded (or has failed to)
+/ /     pContext = data passed to the function
+/ /
+/ / PURPOSE:
+/ /     Asks for a file to be loaded in the background. Returns an id for CancelLoad(), or zero if too many
+/ /     loads are outstanding already or the loader isn't running, the delegate is never called then.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread.
+/*/
+
+DWORD
+RequestLoad (LPCTSTR szFile, LOADTYPE nType, LoadDelegate pDone, void *pContext)
+{
+    LOADREQUEST Request = {0};
+
+    if((_hThread == NULL) || (szFile == NULL) || (_nPending == MAX_LOADS)) return 0;
+
+    // zero is never handed out
+    if(++_nLastLoad == 0) ++_nLastLoad;
+
+    Request.nLoad = _nLastLoad;
+    Request.nType = nType;
+    _tcsncpy_s(Request.szFile, STRING_SIZE(Request.szFile), szFile, _TRUNCATE);
+
+    // the queue holds as many requests as there can be loads outstanding, so this can only fail if the
+    // loader thread hasn't yet taken some that were canceled
+    if(!PushQueueItem(&_Requests, &Request)) return 0;
+
+    _aPending[_nPending].nLoad = Request.nLoad;
+    _aPending[_nPending].pDone = pDone;
+    _aPending[_nPending].pContext = pContext;
+    _nPending++;
+
+    SetEvent(_hWake);
+    return Request.nLoad;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nLoad = id returned by RequestLoad()
+/ /
+/ / PURPOSE:
+/ /     Drops a load that hasn't finished, its delegate is not called. Nothing happens if it has finished already.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread. The file may still be read, it's thrown away
+/ /     once it comes back.
+/*/
+
+void
+CancelLoad (DWORD nLoad)
+{
+    int nIndex = __findPending(nLoad);
+
+    if(nIndex < 0) return;
+
+    // the load is forgotten first, so if it's being uploaded the partial upload is released without a delegate to tell
+    _aPending[nIndex] = _aPending[--_nPending];
+    if(_bUploading && (_Current.nLoad == nLoad)) __finishUpload(false);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nBudget = most bytes to upload before returning
+/ /
+/ / PURPOSE:
+/ /     Uploads whatever the loader thread has decoded, up to the budget, and calls the delegate of every load
+/ /     that finished. A file bigger than the budget is carried on with by the next call.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once a frame. At least one texture row (or a few
+/ /     KB of a buffer) is uploaded per call however small the budget is, so every load finishes eventually.
+/*/
+
+void
+UpdateLoader (size_t nBudget)
+{
+    if(_hThread == NULL) return;
+
+    while(nBudget > 0)
+    {
+        size_t nSlice = 0;
+
+        if(!_bUploading)
+        {
+            if(!PopQueueItem(&_Decoded, &_Current)) break;
+            if(!__beginUpload()) continue;
+        }
+
+        nSlice = __uploadSlice(nBudget);
+        nBudget = (nSlice < nBudget) ? (nBudget - nSlice) : 0;
+
+        if(_nUploaded >= _Current.nSize) __finishUpload(true);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Creates the object _Current is uploaded into. Returns false if there's nothing to upload, because the load
+/ /     was canceled or it failed (its delegate has been called then).
+/*/
+
+static bool
+__beginUpload (void)
+{
+    GLint nMaxSize = 0;
+
+    _bUploading = true;
+    _nUploadName = 0;
+    _nUploaded = 0;
+
+    if(__findPending(_Current.nLoad) < 0)
+    {
+        // canceled while it was being read
+        free(_Current.pData);
+        _bUploading = false;
+        return false;
+    }
+
+    if(_Current.pData == NULL)
+    {
+        __finishUpload(false);
+        return false;
+    }
+
+    if(_Current.nType == LOAD_TEXTURE)
+    {
+        // before GL 2.0 a texture must be a power of two on each side, unless an extension says otherwise
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &nMaxSize);
+
+        if(((_Current.nWidth > (UINT)nMaxSize) || (_Current.nHeight > (UINT)nMaxSize)) ||
+           ((GetGLVersion() < 2.0) && !IsExtensionSupported("GL_ARB_texture_non_power_of_two") &&
+            (((_Current.nWidth & (_Current.nWidth - 1)) != 0) || ((_Current.nHeight & (_Current.nHeight - 1)) != 0))))
+        {
+            __finishUpload(false);
+            return false;
+        }
+
+        // the storage is allocated now and filled a slice at a time
+        glGenTextures(1, &_nUploadName);
+        SetTexture(GL_TEXTURE_2D, _nUploadName);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _Current.nWidth, _Current.nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    else
+    {
+        if(!HasCapability(CAP_VERTEX_BUFFERS))
+        {
+            __finishUpload(false);
+            return false;
+        }
+
+        glGenBuffers(1, &_nUploadName);
+        SetBuffer(GL_ARRAY_BUFFER, _nUploadName);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)_Current.nSize, NULL, GL_STATIC_DRAW);
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     bSuccess = flag to indicate the whole of _Current was uploaded
+/ /
+/ / PURPOSE:
+/ /     Ends the upload of _Current and hands the object to the delegate of the load, if it wasn't canceled.
+/ /     If the upload failed the object is deleted and the delegate gets a name of zero.
+/*/
+
+static void
+__finishUpload (bool bSuccess)
+{
+    LOADRESULT Result = {0};
+    PENDINGLOAD Pending = {0};
+    int nIndex = __findPending(_Current.nLoad);
+
+    if(!bSuccess && (_nUploadName != 0))
+    {
+        if(_Current.nType == LOAD_TEXTURE)
+        {
+            SetTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &_nUploadName);
+        }
+        else
+        {
+            SetBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &_nUploadName);
+        }
+
+        _nUploadName = 0;
+    }
+
+    Result.nType = _Current.nType;
+    Result.nName = _nUploadName;
+    Result.nWidth = _Current.nWidth;
+    Result.nHeight = _Current.nHeight;
+    Result.nSize = bSuccess ? _Current.nSize : 0;
+
+    free(_Current.pData);
+    memset(&_Current, 0, sizeof(_Current));
+    _bUploading = false;
+    _nUploadName = 0;
+    _nUploaded = 0;
+
+    // the load is forgotten before its delegate runs, so the delegate is free to ask for another
+    if(nIndex >= 0)
+    {
+        Pending = _aPending[nIndex];
+        _aPending[nIndex] = _aPending[--_nPending];
+
+        if(Pending.pDone != NULL) Pending.pDone(&Result, Pending.pContext);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nBudget = most bytes to upload
+/ /
+/ / PURPOSE:
+/ /     Uploads the next slice of _Current and returns how many bytes it was.
+/*/
+
+static size_t
+__uploadSlice (size_t nBudget)
+{
+    size_t nSlice = 0;
+
+    if(_Current.nType == LOAD_TEXTURE)
+    {
+        size_t nRowSize = _Current.nWidth * 4;
+        UINT nRow = (UINT)(_nUploaded / nRowSize), nRows = (UINT)(nBudget / nRowSize);
+        void *pStaging = NULL;
+
+        // whole rows only, at least one, and no more than fit in the staging buffer
+        if(nRows == 0) nRows = 1;
+        if((_nStaging != 0) && ((nRows * nRowSize) > STAGING_SIZE)) nRows = (UINT)((STAGING_SIZE > nRowSize) ? (STAGING_SIZE / nRowSize) : 1);
+        if(nRows > (_Current.nHeight - nRow)) nRows = _Current.nHeight - nRow;
+        nSlice = nRows * nRowSize;
+
+        SetTexture(GL_TEXTURE_2D, _nUploadName);
+
+        if(_nStaging != 0)
+        {
+            // orphan the last slice's storage rather than wait for the GL to be done reading it
+            SetBuffer(GL_PIXEL_UNPACK_BUFFER, _nStaging);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)nSlice, NULL, GL_STREAM_DRAW);
+            pStaging = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        }
+
+        if(pStaging != NULL)
+        {
+            memcpy(pStaging, _Current.pData + _nUploaded, nSlice);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+            // with a buffer bound the last argument is an offset into it
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nRow, _Current.nWidth, nRows, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        else
+        {
+            if(_nStaging != 0) SetBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nRow, _Current.nWidth, nRows, GL_RGBA, GL_UNSIGNED_BYTE, _Current.pData + _nUploaded);
+        }
+
+        // nothing else expects pixels to come from a buffer
+        if(_nStaging != 0) SetBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+    {
+        nSlice = (nBudget > MIN_SLICE) ? nBudget : MIN_SLICE;
+        if(nSlice > (_Current.nSize - _nUploaded)) nSlice = _Current.nSize - _nUploaded;
+
+        SetBuffer(GL_ARRAY_BUFFER, _nUploadName);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)_nUploaded, (GLsizeiptr)nSlice, _Current.pData + _nUploaded);
+    }
+
+    _nUploaded += nSlice;
+    return nSlice;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nLoad = id returned by RequestLoad()
+/ /
+/ / PURPOSE:
+/ /     Returns where a load is in the list of outstanding loads, or -1 if it isn't.
+/*/
+
+static int
+__findPending (DWORD nLoad)
+{
+    unsigned int i = 0;
+
+    for(i = 0; i < _nPending; i++)
+        if(_aPending[i].nLoad == nLoad) return (int)i;
+
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pFile = contents of a bitmap file
+/ /     nFile = size of the file in bytes
+/ /     pData = pointer to the structure that receives the pixels and the size
+/ /
+/ / PURPOSE:
+/ /     Decodes an uncompressed bitmap of 24 or 32 bits per pixel into RGBA rows, bottom row first as the GL
+/ /     expects them. Returns false if the file isn't such a bitmap or the memory couldn't be allocated.
+/*/
+
+static bool
+__decodeBitmap (const BYTE *pFile, size_t nFile, LOADDATA *pData)
+{
+    BITMAPFILEHEADER FileHeader;
+    BITMAPINFOHEADER InfoHeader;
+    size_t nStride = 0;
+    UINT x = 0, y = 0, nBytes = 0;
+    bool bTopDown = false;
+    BYTE *pOut = NULL;
+
+    if(nFile < (sizeof(FileHeader) + sizeof(InfoHeader))) return false;
+
+    memcpy(&FileHeader, pFile, sizeof(FileHeader));
+    memcpy(&InfoHeader, pFile + sizeof(FileHeader), sizeof(InfoHeader));
+
+    if((FileHeader.bfType != 0x4D42) || (InfoHeader.biCompression != BI_RGB) || (InfoHeader.biPlanes != 1) ||
+       ((InfoHeader.biBitCount != 24) && (InfoHeader.biBitCount != 32)) || (InfoHeader.biWidth <= 0) || (InfoHeader.biHeight == 0))
+        return false;
+
+    // a negative height marks a bitmap stored top row first
+    bTopDown = (InfoHeader.biHeight < 0);
+    pData->nWidth = (UINT)InfoHeader.biWidth;
+    pData->nHeight = (UINT)(bTopDown ? -InfoHeader.biHeight : InfoHeader.biHeight);
+
+    // every row is padded to a multiple of four bytes
+    nBytes = InfoHeader.biBitCount / 8;
+    nStride = (((size_t)pData->nWidth * nBytes) + 3) & ~(size_t)3;
+
+    if((FileHeader.bfOffBits > nFile) || ((nFile - FileHeader.bfOffBits) / nStride < pData->nHeight)) return false;
+
+    pData->nSize = (size_t)pData->nWidth * pData->nHeight * 4;
+    if((pOut = (BYTE *)malloc(pData->nSize)) == NULL) return false;
+
+    for(y = 0; y < pData->nHeight; y++)
+    {
+        const BYTE *pIn = pFile + FileHeader.bfOffBits + (nStride * (bTopDown ? (pData->nHeight - 1 - y) : y));
+        BYTE *pRow = pOut + ((size_t)y * pData->nWidth * 4);
+
+        // the pixels are stored blue first, and the fourth byte of a 32 bit pixel isn't used
+        for(x = 0; x < pData->nWidth; x++, pIn += nBytes, pRow += 4)
+        {
+            pRow[0] = pIn[2];
+            pRow[1] = pIn[1];
+            pRow[2] = pIn[0];
+            pRow[3] = 255;
+        }
+    }
+
+    pData->pData = pOut;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szFile = path of the file to read
+/ /     pSize = pointer to the variable that receives the size of the file in bytes
+/ /
+/ / PURPOSE:
+/ /     Reads a whole file into memory the caller must free(). Returns NULL if it couldn't be read.
+/*/
+
+static BYTE *
+__readFile (LPCTSTR szFile, size_t *pSize)
+{
+    FILE *pFile = NULL;
+    BYTE *pData = NULL;
+    long nSize = 0;
+
+    *pSize = 0;
+    if(_tfopen_s(&pFile, szFile, _T("rb")) != 0) return NULL;
+
+    if((fseek(pFile, 0, SEEK_END) == 0) && ((nSize = ftell(pFile)) > 0) && (fseek(pFile, 0, SEEK_SET) == 0))
+    {
+        if((pData = (BYTE *)malloc(nSize)) != NULL)
+        {
+            if(fread(pData, nSize, 1, pFile) == 1)
+            {
+                *pSize = (size_t)nSize;
+            }
+            else
+            {
+                free(pData);
+                pData = NULL;
+            }
+        }
+    }
+
+    fclose(pFile);
+    return pData;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pArg = not used
+/ /
+/ / PURPOSE:
+/ /     Main routine of the loader thread, it reads and decodes every file asked for in turn and queues the
+/ /     results for the render thread. It sleeps while there's nothing to load.
+/ /
+/ / NOTES:
+/ /     The function must be declared as __stdcall.
+/*/
+
+static unsigned int __stdcall
+__loaderMain (void *pArg)
+{
+    LOADREQUEST Request;
+
+    while(!_bStopLoader)
+    {
+        LOADDATA Data = {0};
+        BYTE *pFile = NULL;
+        size_t nFile = 0;
+
+        if(!PopQueueItem(&_Requests, &Request))
+        {
+            WaitForSingleObject(_hWake, INFINITE);
+            continue;
+        }
+
+        Data.nLoad = Request.nLoad;
+        Data.nType = Request.nType;
+
+        if((pFile = __readFile(Request.szFile, &nFile)) != NULL)
+        {
+            if(Request.nType == LOAD_TEXTURE)
+            {
+                __decodeBitmap(pFile, nFile, &Data);
+                free(pFile);
+            }
+            else
+            {
+                Data.pData = pFile;
+                Data.nSize = nFile;
+            }
+        }
+
+        // the render thread takes the decoded files a budget at a time, so wait for it to make room
+        while(!PushQueueItem(&_Decoded, &Data))
+        {
+            if(_bStopLoader)
+            {
+                free(Data.pData);
+                break;
+            }
+
+            Sleep(1);
+        }
+    }
+
+    _endthreadex(0);
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
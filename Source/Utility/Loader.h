@@ -0,0 +1,31 @@
+#if !defined (LOADER_H_2C6F8A51_E93D_4B07_A5C2_7D18B0F4E963_)
+#define LOADER_H_2C6F8A51_E93D_4B07_A5C2_7D18B0F4E963_
+
+#pragma once  // in case the compiler supports it
+
+// what a file is loaded into, a texture is decoded from a bitmap (24 or 32 bits per pixel, uncompressed) and
+// a buffer object gets the bytes of the file as they are
+typedef enum {LOAD_TEXTURE = 0, LOAD_BUFFER} LOADTYPE;
+
+// what a load came to, the texture or buffer object belongs to the delegate it's handed to
+typedef struct
+{
+    LOADTYPE nType;                 // what was asked for
+    GLuint   nName;                 // name of the texture or buffer object (zero if the load failed)
+    UINT     nWidth;                // width of the texture in pixels (LOAD_TEXTURE only)
+    UINT     nHeight;               // height of the texture in pixels (LOAD_TEXTURE only)
+    size_t   nSize;                 // number of bytes uploaded
+
+}  LOADRESULT;
+
+// delegate function to be called once a load has finished uploading (or has failed)
+// it will be called in the context of the render thread, from within UpdateLoader()
+typedef void (*LoadDelegate) (const LOADRESULT *pResult, void *pContext);
+
+bool  InitLoader    (void);
+void  DestroyLoader (void);
+DWORD RequestLoad   (LPCTSTR szFile, LOADTYPE nType, LoadDelegate pDone, void *pContext);
+void  CancelLoad    (DWORD nLoad);
+void  UpdateLoader  (size_t nBudget);
+
+#endif  // LOADER_H
@@ -0,0 +1,858 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\Mesh.h"           // include for this file
+#include "Utility\State.h"          // render state routines
+#include <ctype.h>                  // isspace()
+#include <math.h>                   // sqrt()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////// BINARY MESH ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / A text format like OBJ has to be parsed, deduplicated and laid out every time it's loaded, which takes far longer
+/ / than reading it. So that's done once, ahead of time, by ConvertMesh(), and the result is written in the layout
+/ / the GL draws from: interleaved vertices, a triangle list of indices, and a table of the index ranges drawn with
+/ / each material. Loading one is then just mapping the file and checking the header, the vertices and indices are
+/ / handed to glBufferData() (or to the array pointers if there are no buffer objects) straight from the view, the
+/ / pages are only read as the driver copies them. Nothing in the file is byte swapped, it's written and read on
+/ / little endian machines only.
+/*/
+
+#define MESH_PAD(n)     (((n) + (MESH_ALIGN - 1)) & ~(MESH_ALIGN - 1))
+#define MAX_LINE        4096            // longest line of a source file that can be converted
+
+// a vertex of the source file, the position, texture coordinate and normal it was given (-1 if it wasn't)
+typedef struct
+{
+    long anIndex[3];                // position, texture coordinate and normal, in that order
+
+}  OBJCORNER;
+
+// a triangle of the source file, the corners index the distinct vertices found so far
+typedef struct
+{
+    DWORD anCorners[3];             // vertices of the triangle
+    DWORD nMaterial;                // material the triangle is drawn with
+
+}  OBJTRIANGLE;
+
+// everything read from the source file so far, each array grows as needed
+typedef struct
+{
+    float       *pPositions;        // x, y and z of every position
+    float       *pNormals;          // x, y and z of every normal
+    float       *pTexCoords;        // s and t of every texture coordinate
+    long         anCount[3];        // number of positions, texture coordinates and normals
+    size_t       anCapacity[3];     // number each array can hold
+
+    OBJCORNER   *pCorners;          // distinct vertices, these are the vertices of the mesh
+    DWORD        nCorners;          // number of distinct vertices
+    size_t       nCornerCapacity;   // number the array can hold
+
+    DWORD       *pHash;             // open addressed table of vertex numbers plus one (zero if empty)
+    DWORD        nHashSize;         // number of slots, a power of two at least twice the number of vertices
+
+    OBJTRIANGLE *pTriangles;        // triangles in the order they were read
+    DWORD        nTriangles;        // number of triangles
+    size_t       nTriangleCapacity; // number the array can hold
+
+    char        (*pMaterials)[MESH_NAME_SIZE]; // names of the materials in the order they were first used
+    DWORD        nMaterials;        // number of materials
+    size_t       nMaterialCapacity; // number the array can hold
+    char         szMaterial[MESH_NAME_SIZE]; // material named by the last usemtl
+    long         nMaterial;         // index of that material (-1 until a face uses it)
+
+}  OBJREADER;
+
+// local function prototypes
+static DWORD __addCorner   (OBJREADER *pReader, const long anIndex[3]);
+static bool  __checkMesh   (const BYTE *pView, DWORD nSize);
+static bool  __grow        (void **ppArray, size_t *pCapacity, size_t nNeeded, size_t nSize);
+static bool  __readFace    (OBJREADER *pReader, const char *pText);
+static bool  __readFloats  (OBJREADER *pReader, int nArray, const char *pText);
+static bool  __writeMesh   (const OBJREADER *pReader, LPCTSTR szMesh);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szFile = path of the binary mesh file
+/ /     pMesh = pointer to the mesh to set up
+/ /
+/ / PURPOSE:
+/ /     Maps a binary mesh file into memory and points the mesh at its sections. Returns false if the file couldn't
+/ /     be mapped, or if it isn't a mesh file of this version or any section doesn't fit in it.
+/ /
+/ / NOTES:
+/ /     Nothing is read but the header and the two tables, the indices are trusted to be in range since only
+/ /     ConvertMesh() writes these files. This can be called from any thread, the GL isn't used.
+/*/
+
+bool
+OpenMesh (LPCTSTR szFile, PMESH pMesh)
+{
+    HANDLE hFile = INVALID_HANDLE_VALUE, hMapping = NULL;
+    LARGE_INTEGER nSize = {0};
+    const BYTE *pView = NULL;
+
+    if(pMesh == NULL) return false;
+    memset(pMesh, 0, sizeof(MESH));
+
+    if((szFile == NULL) || (szFile[0] == _T('\0'))) return false;
+
+    hFile = CreateFile(szFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(hFile == INVALID_HANDLE_VALUE) return false;
+
+    // the view keeps the file open by itself, so neither handle is needed once it's mapped
+    if(GetFileSizeEx(hFile, &nSize) && (nSize.QuadPart >= (LONGLONG)sizeof(MESHHEADER)) && (nSize.QuadPart <= (LONGLONG)MAXDWORD))
+    {
+        if((hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+        {
+            pView = (const BYTE *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(hMapping);
+        }
+    }
+
+    CloseHandle(hFile);
+    if(pView == NULL) return false;
+
+    if(!__checkMesh(pView, (DWORD)nSize.QuadPart))
+    {
+        UnmapViewOfFile(pView);
+        return false;
+    }
+
+    pMesh->pHeader = (const MESHHEADER *)pView;
+    pMesh->pAttributes = (const MESHATTRIBUTE *)(pView + pMesh->pHeader->nAttribOffset);
+    pMesh->pSubmeshes = (const MESHSUBMESH *)(pView + pMesh->pHeader->nSubmeshOffset);
+    pMesh->pVertices = pView + pMesh->pHeader->nVertexOffset;
+    pMesh->pIndices = pView + pMesh->pHeader->nIndexOffset;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pMesh = pointer to the mesh to close
+/ /
+/ / PURPOSE:
+/ /     Releases the buffer objects of a mesh (if it was uploaded) and unmaps its file.
+/ /
+/ / NOTES:
+/ /     If the mesh was uploaded, this must be called in the context of the render thread.
+/*/
+
+void
+CloseMesh (PMESH pMesh)
+{
+    if((pMesh == NULL) || (pMesh->pHeader == NULL)) return;
+
+    if(pMesh->nVertexBuffer != 0)
+    {
+        SetBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &pMesh->nVertexBuffer);
+    }
+
+    if(pMesh->nIndexBuffer != 0)
+    {
+        SetBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &pMesh->nIndexBuffer);
+    }
+
+    UnmapViewOfFile(pMesh->pHeader);
+    memset(pMesh, 0, sizeof(MESH));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pMesh = pointer to the mesh to upload
+/ /
+/ / PURPOSE:
+/ /     Copies the vertices and indices of a mesh into buffer objects of their own, straight from the mapped file.
+/ /     Returns false if there are no buffer objects, the mesh is then drawn from the view itself.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, after InitExtensions().
+/*/
+
+bool
+UploadMesh (PMESH pMesh)
+{
+    const MESHHEADER *pHeader = NULL;
+    GLsizeiptr nIndexSize = 0;
+
+    if((pMesh == NULL) || ((pHeader = pMesh->pHeader) == NULL) || !HasCapability(CAP_VERTEX_BUFFERS)) return false;
+    if(pMesh->nVertexBuffer != 0) return true;
+
+    nIndexSize = (pHeader->nIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+
+    // the data never changes, and the driver reads it from the file's pages as it copies, no copy of our own is made
+    glGenBuffers(1, &pMesh->nVertexBuffer);
+    SetBuffer(GL_ARRAY_BUFFER, pMesh->nVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)pHeader->nVertices * pHeader->nVertexSize, pMesh->pVertices, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &pMesh->nIndexBuffer);
+    SetBuffer(GL_ELEMENT_ARRAY_BUFFER, pMesh->nIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)pHeader->nIndices * nIndexSize, pMesh->pIndices, GL_STATIC_DRAW);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pMesh = pointer to the mesh to draw from
+/ /     bBind = flag to indicate if the arrays of the mesh are set up (true) or taken down (false)
+/ /
+/ / PURPOSE:
+/ /     Points the client arrays at the attributes of the mesh, in its buffer objects if it was uploaded or in the
+/ /     mapped file if it wasn't, and enables them. Unbinding disables the arrays the mesh had enabled.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+BindMesh (const MESH *pMesh, bool bBind)
+{
+    static const GLenum eArrays[MESH_ATTRIBUTES] = {GL_VERTEX_ARRAY, GL_NORMAL_ARRAY, GL_TEXTURE_COORD_ARRAY, GL_COLOR_ARRAY};
+    UINT_PTR nBase = 0;
+    DWORD i = 0;
+
+    if((pMesh == NULL) || (pMesh->pHeader == NULL)) return;
+
+    // with buffer objects the pointers are offsets into the bound buffer, without them they're addresses in the view
+    if(HasCapability(CAP_VERTEX_BUFFERS))
+    {
+        SetBuffer(GL_ARRAY_BUFFER, bBind ? pMesh->nVertexBuffer : 0);
+        SetBuffer(GL_ELEMENT_ARRAY_BUFFER, bBind ? pMesh->nIndexBuffer : 0);
+    }
+
+    if(pMesh->nVertexBuffer == 0) nBase = (UINT_PTR)pMesh->pVertices;
+
+    for(i = 0; i < pMesh->pHeader->nAttributes; i++)
+    {
+        const MESHATTRIBUTE *pAttribute = &pMesh->pAttributes[i];
+        const GLvoid *pPointer = (const GLvoid *)(nBase + pAttribute->nOffset);
+        GLsizei nStride = (GLsizei)pMesh->pHeader->nVertexSize;
+
+        SetClientArray(eArrays[pAttribute->nAttribute], bBind);
+        if(!bBind) continue;
+
+        switch(pAttribute->nAttribute)
+        {
+            case MESH_POSITION: glVertexPointer((GLint)pAttribute->nComponents, pAttribute->nType, nStride, pPointer); break;
+            case MESH_NORMAL:   glNormalPointer(pAttribute->nType, nStride, pPointer); break;
+            case MESH_TEXCOORD: glTexCoordPointer((GLint)pAttribute->nComponents, pAttribute->nType, nStride, pPointer); break;
+            case MESH_COLOR:    glColorPointer((GLint)pAttribute->nComponents, pAttribute->nType, nStride, pPointer); break;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pMesh = pointer to the mesh to draw from
+/ /     nSubmesh = which submesh to draw
+/ /
+/ / PURPOSE:
+/ /     Draws the triangles of one submesh, the arrays must have been set up with BindMesh() first.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+DrawSubmesh (const MESH *pMesh, unsigned int nSubmesh)
+{
+    const MESHSUBMESH *pSubmesh = NULL;
+    UINT_PTR nFirst = 0;
+
+    if((pMesh == NULL) || (pMesh->pHeader == NULL) || (nSubmesh >= pMesh->pHeader->nSubmeshes)) return;
+
+    pSubmesh = &pMesh->pSubmeshes[nSubmesh];
+    nFirst = pSubmesh->nFirst * ((pMesh->pHeader->nIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint));
+    if(pMesh->nIndexBuffer == 0) nFirst += (UINT_PTR)pMesh->pIndices;
+
+    glDrawElements(GL_TRIANGLES, (GLsizei)pSubmesh->nCount, pMesh->pHeader->nIndexType, (const GLvoid *)nFirst);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szSource = path of the Wavefront OBJ file to convert
+/ /     szMesh = path of the binary mesh file to write
+/ /
+/ / PURPOSE:
+/ /     Reads the positions, texture coordinates, normals and faces of an OBJ file and writes them as a binary mesh
+/ /     that OpenMesh() can map. Faces with more than three corners are split into fans, corners that share all of
+/ /     their indices become one vertex, and the faces of each material become a submesh in the order the materials
+/ /     were first used. Returns false if the file couldn't be read or written, or had no faces.
+/ /
+/ / NOTES:
+/ /     Vertices without a normal get the average of the normals of the faces around them, weighted by their area.
+/ /     Anything other than v, vt, vn, f and usemtl (groups, smoothing groups, lines, the material library) is
+/ /     ignored, the material names are kept but not their colors.
+/*/
+
+bool
+ConvertMesh (LPCTSTR szSource, LPCTSTR szMesh)
+{
+    OBJREADER Reader = {0};
+    FILE *pFile = NULL;
+    char szLine[MAX_LINE];
+    bool bReturn = true;
+
+    if((szSource == NULL) || (szMesh == NULL) || (_tfopen_s(&pFile, szSource, _T("r")) != 0)) return false;
+
+    Reader.nMaterial = -1;
+
+    while(bReturn && (fgets(szLine, sizeof(szLine), pFile) != NULL))
+    {
+        const char *pText = szLine;
+        size_t nLength = strlen(szLine);
+
+        // a line that didn't fit would be read as two, which could turn the rest of it into something else
+        if((nLength == (sizeof(szLine) - 1)) && (szLine[nLength - 1] != '\n') && !feof(pFile))
+        {
+            bReturn = false;
+            break;
+        }
+
+        while(isspace((unsigned char)*pText)) pText++;
+
+        if((pText[0] == 'v') && isspace((unsigned char)pText[1]))
+            bReturn = __readFloats(&Reader, 0, pText + 2);
+
+        else if((pText[0] == 'v') && (pText[1] == 't') && isspace((unsigned char)pText[2]))
+            bReturn = __readFloats(&Reader, 1, pText + 3);
+
+        else if((pText[0] == 'v') && (pText[1] == 'n') && isspace((unsigned char)pText[2]))
+            bReturn = __readFloats(&Reader, 2, pText + 3);
+
+        else if((pText[0] == 'f') && isspace((unsigned char)pText[1]))
+            bReturn = __readFace(&Reader, pText + 2);
+
+        else if((strncmp(pText, "usemtl", 6) == 0) && isspace((unsigned char)pText[6]))
+        {
+            size_t nName = 0;
+
+            // the material is only added once a face uses it, so a usemtl with no faces after it adds nothing
+            for(pText += 7; isspace((unsigned char)*pText); pText++);
+            while((pText[nName] != '\0') && !isspace((unsigned char)pText[nName]) && (nName < (MESH_NAME_SIZE - 1))) nName++;
+
+            memcpy(Reader.szMaterial, pText, nName);
+            Reader.szMaterial[nName] = '\0';
+            Reader.nMaterial = -1;
+        }
+    }
+
+    if(ferror(pFile)) bReturn = false;
+    fclose(pFile);
+
+    if(bReturn) bReturn = (Reader.nTriangles > 0) && __writeMesh(&Reader, szMesh);
+
+    // free() doesn't mind NULL, so whatever did get allocated is released
+    free(Reader.pPositions);
+    free(Reader.pNormals);
+    free(Reader.pTexCoords);
+    free(Reader.pCorners);
+    free(Reader.pHash);
+    free(Reader.pTriangles);
+    free(Reader.pMaterials);
+
+    return bReturn;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pReader = pointer to what has been read of the source file
+/ /     anIndex = zero based position, texture coordinate and normal of the corner (-1 if it has none)
+/ /
+/ / PURPOSE:
+/ /     Returns the vertex a corner of a face is, adding it if no corner before it had the same indices. Returns
+/ /     MAXDWORD if there wasn't enough memory for it.
+/*/
+
+static DWORD
+__addCorner (OBJREADER *pReader, const long anIndex[3])
+{
+    DWORD nMask = 0, nSlot = 0;
+
+    // keep the table at most half full, growing it means placing every vertex again
+    if(((pReader->nCorners + 1) * 2) > pReader->nHashSize)
+    {
+        DWORD nSize = (pReader->nHashSize == 0) ? 1024 : (pReader->nHashSize * 2);
+        DWORD *pHash = (DWORD *)calloc(nSize, sizeof(DWORD));
+        DWORD i = 0;
+
+        if(pHash == NULL) return MAXDWORD;
+
+        free(pReader->pHash);
+        pReader->pHash = pHash;
+        pReader->nHashSize = nSize;
+
+        for(i = 0; i < pReader->nCorners; i++)
+        {
+            const long *pKey = pReader->pCorners[i].anIndex;
+
+            nSlot = ((DWORD)pKey[0] * 73856093u) ^ ((DWORD)pKey[1] * 19349663u) ^ ((DWORD)pKey[2] * 83492791u);
+            for(nSlot &= (nSize - 1); pHash[nSlot] != 0; nSlot = (nSlot + 1) & (nSize - 1));
+            pHash[nSlot] = i + 1;
+        }
+    }
+
+    nMask = pReader->nHashSize - 1;
+    nSlot = ((DWORD)anIndex[0] * 73856093u) ^ ((DWORD)anIndex[1] * 19349663u) ^ ((DWORD)anIndex[2] * 83492791u);
+
+    for(nSlot &= nMask; pReader->pHash[nSlot] != 0; nSlot = (nSlot + 1) & nMask)
+    {
+        const OBJCORNER *pCorner = &pReader->pCorners[pReader->pHash[nSlot] - 1];
+
+        if((pCorner->anIndex[0] == anIndex[0]) && (pCorner->anIndex[1] == anIndex[1]) && (pCorner->anIndex[2] == anIndex[2]))
+            return pReader->pHash[nSlot] - 1;
+    }
+
+    if(!__grow((void **)&pReader->pCorners, &pReader->nCornerCapacity, pReader->nCorners + 1, sizeof(OBJCORNER))) return MAXDWORD;
+
+    memcpy(pReader->pCorners[pReader->nCorners].anIndex, anIndex, sizeof(pReader->pCorners[0].anIndex));
+    pReader->pHash[nSlot] = ++pReader->nCorners;
+
+    return pReader->nCorners - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pView = start of the mapped file
+/ /     nSize = size of the file in bytes
+/ /
+/ / PURPOSE:
+/ /     Returns true if the header of a mapped file is one of ours and every section it describes lies within the
+/ /     file, starts aligned, and can be drawn from. The sizes are worked out in 64 bits so no count can wrap.
+/*/
+
+static bool
+__checkMesh (const BYTE *pView, DWORD nSize)
+{
+    const MESHHEADER *pHeader = (const MESHHEADER *)pView;
+    DWORD anOffsets[4] = {0};
+    ULONGLONG anSizes[4] = {0};
+    DWORD nFound = 0, i = 0;
+
+    if((pHeader->nMagic != MESH_MAGIC) || (pHeader->nVersion != MESH_VERSION) || (pHeader->nFileSize != nSize)) return false;
+    if((pHeader->nIndexType != GL_UNSIGNED_SHORT) && (pHeader->nIndexType != GL_UNSIGNED_INT)) return false;
+    if((pHeader->nAttributes == 0) || (pHeader->nAttributes > MESH_ATTRIBUTES) || (pHeader->nVertexSize == 0)) return false;
+    if((pHeader->nVertices == 0) || (pHeader->nIndices == 0) || ((pHeader->nIndices % 3) != 0)) return false;
+
+    anOffsets[0] = pHeader->nAttribOffset;
+    anOffsets[1] = pHeader->nSubmeshOffset;
+    anOffsets[2] = pHeader->nVertexOffset;
+    anOffsets[3] = pHeader->nIndexOffset;
+
+    anSizes[0] = (ULONGLONG)pHeader->nAttributes * sizeof(MESHATTRIBUTE);
+    anSizes[1] = (ULONGLONG)pHeader->nSubmeshes * sizeof(MESHSUBMESH);
+    anSizes[2] = (ULONGLONG)pHeader->nVertices * pHeader->nVertexSize;
+    anSizes[3] = (ULONGLONG)pHeader->nIndices * ((pHeader->nIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint));
+
+    for(i = 0; i < 4; i++)
+    {
+        if((anOffsets[i] < sizeof(MESHHEADER)) || ((anOffsets[i] % MESH_ALIGN) != 0)) return false;
+        if(((ULONGLONG)anOffsets[i] + anSizes[i]) > nSize) return false;
+    }
+
+    // every attribute has to feed an array of its own, in a form the matching gl*Pointer() call accepts
+    for(i = 0; i < pHeader->nAttributes; i++)
+    {
+        const MESHATTRIBUTE *pAttribute = (const MESHATTRIBUTE *)(pView + pHeader->nAttribOffset) + i;
+        DWORD nBytes = (pAttribute->nType == GL_FLOAT) ? sizeof(GLfloat) : sizeof(GLubyte);
+
+        if((pAttribute->nAttribute >= MESH_ATTRIBUTES) || ((nFound & (1 << pAttribute->nAttribute)) != 0)) return false;
+        if((pAttribute->nType != GL_FLOAT) && (pAttribute->nType != GL_UNSIGNED_BYTE)) return false;
+        if((pAttribute->nComponents == 0) || (pAttribute->nComponents > 4)) return false;
+        if(((ULONGLONG)pAttribute->nOffset + (pAttribute->nComponents * nBytes)) > pHeader->nVertexSize) return false;
+
+        switch(pAttribute->nAttribute)
+        {
+            case MESH_POSITION: if((pAttribute->nType != GL_FLOAT) || (pAttribute->nComponents < 2)) return false; break;
+            case MESH_NORMAL:   if((pAttribute->nType != GL_FLOAT) || (pAttribute->nComponents != 3)) return false; break;
+            case MESH_TEXCOORD: if(pAttribute->nType != GL_FLOAT) return false; break;
+            case MESH_COLOR:    if(pAttribute->nComponents < 3) return false; break;
+        }
+
+        nFound |= (1 << pAttribute->nAttribute);
+    }
+
+    if((nFound & (1 << MESH_POSITION)) == 0) return false;
+
+    for(i = 0; i < pHeader->nSubmeshes; i++)
+    {
+        const MESHSUBMESH *pSubmesh = (const MESHSUBMESH *)(pView + pHeader->nSubmeshOffset) + i;
+        if(((ULONGLONG)pSubmesh->nFirst + pSubmesh->nCount) > pHeader->nIndices) return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     ppArray = pointer to the array to grow
+/ /     pCapacity = pointer to the number of elements the array can hold
+/ /     nNeeded = number of elements the array has to hold
+/ /     nSize = size of an element in bytes
+/ /
+/ / PURPOSE:
+/ /     Makes sure an array can hold a number of elements, doubling it if it can't. Returns false if there
+/ /     wasn't enough memory, the array is left as it was.
+/*/
+
+static bool
+__grow (void **ppArray, size_t *pCapacity, size_t nNeeded, size_t nSize)
+{
+    size_t nCapacity = (*pCapacity == 0) ? 256 : *pCapacity;
+    void *pArray = NULL;
+
+    if(nNeeded <= *pCapacity) return true;
+
+    while(nCapacity < nNeeded) nCapacity *= 2;
+    if((nCapacity > (MAXDWORD / 2)) || (nCapacity > ((size_t)-1 / nSize)) || ((pArray = realloc(*ppArray, nCapacity * nSize)) == NULL)) return false;
+
+    *ppArray = pArray;
+    *pCapacity = nCapacity;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pReader = pointer to what has been read of the source file
+/ /     pText = rest of the line after the f
+/ /
+/ / PURPOSE:
+/ /     Reads the corners of a face, as v, v/vt, v//vn or v/vt/vn (negative numbers count back from the last one
+/ /     read), and adds the face as a fan of triangles. Returns false if a corner is malformed or out of range.
+/*/
+
+static bool
+__readFace (OBJREADER *pReader, const char *pText)
+{
+    DWORD anFirst[2] = {0}, nCorners = 0;
+
+    // the material is only counted once a face uses it
+    if(pReader->nMaterial < 0)
+    {
+        for(pReader->nMaterial = 0; (DWORD)pReader->nMaterial < pReader->nMaterials; pReader->nMaterial++)
+            if(strcmp(pReader->pMaterials[pReader->nMaterial], pReader->szMaterial) == 0) break;
+
+        if((DWORD)pReader->nMaterial == pReader->nMaterials)
+        {
+            if(!__grow((void **)&pReader->pMaterials, &pReader->nMaterialCapacity, pReader->nMaterials + 1, MESH_NAME_SIZE)) return false;
+            memcpy(pReader->pMaterials[pReader->nMaterials++], pReader->szMaterial, MESH_NAME_SIZE);
+        }
+    }
+
+    for(;;)
+    {
+        long anIndex[3] = {-1, -1, -1};
+        DWORD nCorner = 0;
+        int i = 0;
+
+        while(isspace((unsigned char)*pText)) pText++;
+        if(*pText == '\0') break;
+
+        // positions are required, the other two may be left out
+        for(i = 0; i < 3; i++)
+        {
+            char *pEnd = NULL;
+            long nIndex = strtol(pText, &pEnd, 10);
+
+            if(pEnd != pText)
+            {
+                if(nIndex < 0) nIndex += pReader->anCount[i] + 1;
+                if((nIndex < 1) || (nIndex > pReader->anCount[i])) return false;
+
+                anIndex[i] = nIndex - 1;
+                pText = pEnd;
+            }
+            else if(i == 0)
+            {
+                return false;
+            }
+
+            if(*pText != '/') break;
+            pText++;
+        }
+
+        if((nCorner = __addCorner(pReader, anIndex)) == MAXDWORD) return false;
+
+        // a polygon becomes a fan around its first corner
+        if(nCorners >= 2)
+        {
+            OBJTRIANGLE *pTriangle = NULL;
+
+            if(!__grow((void **)&pReader->pTriangles, &pReader->nTriangleCapacity, pReader->nTriangles + 1, sizeof(OBJTRIANGLE))) return false;
+
+            pTriangle = &pReader->pTriangles[pReader->nTriangles++];
+            pTriangle->anCorners[0] = anFirst[0];
+            pTriangle->anCorners[1] = anFirst[1];
+            pTriangle->anCorners[2] = nCorner;
+            pTriangle->nMaterial = (DWORD)pReader->nMaterial;
+
+            anFirst[1] = nCorner;
+        }
+        else
+        {
+            anFirst[nCorners] = nCorner;
+        }
+
+        nCorners++;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pReader = pointer to what has been read of the source file
+/ /     nArray = array to add to, 0 for positions, 1 for texture coordinates or 2 for normals
+/ /     pText = rest of the line after the v, vt or vn
+/ /
+/ / PURPOSE:
+/ /     Reads the three (or two, for texture coordinates) numbers of a line and adds them to an array. A missing
+/ /     number is zero, a fourth (or third) one is ignored. Returns false if there wasn't enough memory.
+/*/
+
+static bool
+__readFloats (OBJREADER *pReader, int nArray, const char *pText)
+{
+    float **ppArray = (nArray == 0) ? &pReader->pPositions : ((nArray == 1) ? &pReader->pTexCoords : &pReader->pNormals);
+    size_t nFloats = (nArray == 1) ? 2 : 3, i = 0;
+    float *pValues = NULL;
+
+    if(!__grow((void **)ppArray, &pReader->anCapacity[nArray], (pReader->anCount[nArray] + 1) * nFloats, sizeof(float))) return false;
+
+    pValues = *ppArray + (pReader->anCount[nArray]++ * nFloats);
+
+    for(i = 0; i < nFloats; i++)
+    {
+        char *pEnd = NULL;
+
+        pValues[i] = (float)strtod(pText, &pEnd);
+        pText = pEnd;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pReader = pointer to what has been read of the source file
+/ /     szMesh = path of the binary mesh file to write
+/ /
+/ / PURPOSE:
+/ /     Lays out the vertices and triangles read from the source file as a binary mesh and writes it. The
+/ /     triangles are grouped by material with a counting sort, so each material's indices are one range.
+/ /     Returns false if there wasn't enough memory, the mesh is too big or the file couldn't be written.
+/*/
+
+static bool
+__writeMesh (const OBJREADER *pReader, LPCTSTR szMesh)
+{
+    MESHHEADER Header = {0};
+    MESHATTRIBUTE *pAttributes = NULL;
+    MESHSUBMESH *pSubmeshes = NULL;
+    DWORD *pStarts = NULL;
+    BYTE *pData = NULL;
+    FILE *pFile = NULL;
+    ULONGLONG nSize = 0;
+    bool bTexCoords = false, bReturn = false;
+    DWORD i = 0, j = 0;
+
+    // texture coordinates are only stored if some corner has one, normals always are since the scene is lit
+    for(i = 0; (i < pReader->nCorners) && !bTexCoords; i++) bTexCoords = (pReader->pCorners[i].anIndex[1] >= 0);
+
+    Header.nMagic = MESH_MAGIC;
+    Header.nVersion = MESH_VERSION;
+    Header.nAttributes = bTexCoords ? 3 : 2;
+    Header.nVertexSize = (bTexCoords ? 8 : 6) * sizeof(float);
+    Header.nVertices = pReader->nCorners;
+    Header.nIndexType = (pReader->nCorners <= 65536) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    Header.nIndices = pReader->nTriangles * 3;
+    Header.nSubmeshes = pReader->nMaterials;
+
+    // lay the sections out one after the other, each aligned, and make sure it all fits in a 32 bit size
+    nSize = MESH_PAD(sizeof(MESHHEADER));
+    Header.nAttribOffset = (DWORD)nSize;
+    nSize = MESH_PAD(nSize + (ULONGLONG)Header.nAttributes * sizeof(MESHATTRIBUTE));
+    Header.nSubmeshOffset = (DWORD)nSize;
+    nSize = MESH_PAD(nSize + (ULONGLONG)Header.nSubmeshes * sizeof(MESHSUBMESH));
+    Header.nVertexOffset = (DWORD)nSize;
+    nSize = MESH_PAD(nSize + (ULONGLONG)Header.nVertices * Header.nVertexSize);
+    Header.nIndexOffset = (DWORD)nSize;
+    nSize += (ULONGLONG)Header.nIndices * ((Header.nIndexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint));
+
+    if((nSize > MAXDWORD) || (nSize > (size_t)-1)) return false;
+    Header.nFileSize = (DWORD)nSize;
+
+    if(((pData = (BYTE *)calloc((size_t)nSize, 1)) == NULL) || ((pStarts = (DWORD *)calloc(pReader->nMaterials + 1, sizeof(DWORD))) == NULL))
+    {
+        free(pData);
+        return false;
+    }
+
+    pAttributes = (MESHATTRIBUTE *)(pData + Header.nAttribOffset);
+    pSubmeshes = (MESHSUBMESH *)(pData + Header.nSubmeshOffset);
+
+    pAttributes[0].nAttribute = MESH_POSITION;
+    pAttributes[0].nComponents = 3;
+    pAttributes[0].nType = GL_FLOAT;
+    pAttributes[0].nOffset = 0;
+
+    pAttributes[1].nAttribute = MESH_NORMAL;
+    pAttributes[1].nComponents = 3;
+    pAttributes[1].nType = GL_FLOAT;
+    pAttributes[1].nOffset = 3 * sizeof(float);
+
+    if(bTexCoords)
+    {
+        pAttributes[2].nAttribute = MESH_TEXCOORD;
+        pAttributes[2].nComponents = 2;
+        pAttributes[2].nType = GL_FLOAT;
+        pAttributes[2].nOffset = 6 * sizeof(float);
+    }
+
+    // the vertices, whatever a corner wasn't given is zero, the missing normals are summed up below
+    for(i = 0; i < pReader->nCorners; i++)
+    {
+        const long *pIndex = pReader->pCorners[i].anIndex;
+        float *pVertex = (float *)(pData + Header.nVertexOffset + (i * Header.nVertexSize));
+
+        memcpy(&pVertex[0], &pReader->pPositions[pIndex[0] * 3], 3 * sizeof(float));
+        if(pIndex[2] >= 0) memcpy(&pVertex[3], &pReader->pNormals[pIndex[2] * 3], 3 * sizeof(float));
+        if(bTexCoords && (pIndex[1] >= 0)) memcpy(&pVertex[6], &pReader->pTexCoords[pIndex[1] * 2], 2 * sizeof(float));
+
+        for(j = 0; j < 3; j++)
+        {
+            if((i == 0) || (pVertex[j] < Header.afMin[j])) Header.afMin[j] = pVertex[j];
+            if((i == 0) || (pVertex[j] > Header.afMax[j])) Header.afMax[j] = pVertex[j];
+        }
+    }
+
+    // the cross product of two edges is twice the area of the triangle long, so bigger faces count for more
+    for(i = 0; i < pReader->nTriangles; i++)
+    {
+        const DWORD *pCorners = pReader->pTriangles[i].anCorners;
+        float *pA = (float *)(pData + Header.nVertexOffset + (pCorners[0] * Header.nVertexSize));
+        float *pB = (float *)(pData + Header.nVertexOffset + (pCorners[1] * Header.nVertexSize));
+        float *pC = (float *)(pData + Header.nVertexOffset + (pCorners[2] * Header.nVertexSize));
+        float afU[3], afV[3], afNormal[3];
+
+        for(j = 0; j < 3; j++)
+        {
+            afU[j] = pB[j] - pA[j];
+            afV[j] = pC[j] - pA[j];
+        }
+
+        afNormal[0] = (afU[1] * afV[2]) - (afU[2] * afV[1]);
+        afNormal[1] = (afU[2] * afV[0]) - (afU[0] * afV[2]);
+        afNormal[2] = (afU[0] * afV[1]) - (afU[1] * afV[0]);
+
+        for(j = 0; j < 3; j++)
+        {
+            float *pVertex = (float *)(pData + Header.nVertexOffset + (pCorners[j] * Header.nVertexSize));
+
+            if(pReader->pCorners[pCorners[j]].anIndex[2] >= 0) continue;
+
+            pVertex[3] += afNormal[0];
+            pVertex[4] += afNormal[1];
+            pVertex[5] += afNormal[2];
+        }
+    }
+
+    for(i = 0; i < pReader->nCorners; i++)
+    {
+        float *pVertex = (float *)(pData + Header.nVertexOffset + (i * Header.nVertexSize));
+        float fLength = 0.0f;
+
+        if(pReader->pCorners[i].anIndex[2] >= 0) continue;
+
+        fLength = (float)sqrt((pVertex[3] * pVertex[3]) + (pVertex[4] * pVertex[4]) + (pVertex[5] * pVertex[5]));
+        if(fLength > 0.0f)
+        {
+            pVertex[3] /= fLength;
+            pVertex[4] /= fLength;
+            pVertex[5] /= fLength;
+        }
+    }
+
+    // count the triangles of each material, turn the counts into where each material starts, then place them
+    for(i = 0; i < pReader->nTriangles; i++) pStarts[pReader->pTriangles[i].nMaterial + 1]++;
+    for(i = 0; i < pReader->nMaterials; i++)
+    {
+        pSubmeshes[i].nFirst = pStarts[i] * 3;
+        pSubmeshes[i].nCount = pStarts[i + 1] * 3;
+        memcpy(pSubmeshes[i].szMaterial, pReader->pMaterials[i], MESH_NAME_SIZE);
+
+        pStarts[i + 1] += pStarts[i];
+    }
+
+    for(i = 0; i < pReader->nTriangles; i++)
+    {
+        const OBJTRIANGLE *pTriangle = &pReader->pTriangles[i];
+        MESHSUBMESH *pSubmesh = &pSubmeshes[pTriangle->nMaterial];
+        DWORD nIndex = pStarts[pTriangle->nMaterial]++ * 3;
+
+        for(j = 0; j < 3; j++)
+        {
+            const float *pVertex = (const float *)(pData + Header.nVertexOffset + (pTriangle->anCorners[j] * Header.nVertexSize));
+            int k = 0;
+
+            if(Header.nIndexType == GL_UNSIGNED_SHORT)
+                ((GLushort *)(pData + Header.nIndexOffset))[nIndex + j] = (GLushort)pTriangle->anCorners[j];
+            else
+                ((GLuint *)(pData + Header.nIndexOffset))[nIndex + j] = (GLuint)pTriangle->anCorners[j];
+
+            // the first corner placed in a submesh starts its bounds
+            for(k = 0; k < 3; k++)
+            {
+                if(((nIndex + j) == pSubmesh->nFirst) || (pVertex[k] < pSubmesh->afMin[k])) pSubmesh->afMin[k] = pVertex[k];
+                if(((nIndex + j) == pSubmesh->nFirst) || (pVertex[k] > pSubmesh->afMax[k])) pSubmesh->afMax[k] = pVertex[k];
+            }
+        }
+    }
+
+    memcpy(pData, &Header, sizeof(Header));
+
+    if(_tfopen_s(&pFile, szMesh, _T("wb")) == 0)
+    {
+        bReturn = (fwrite(pData, (size_t)nSize, 1, pFile) == 1);
+        if(fclose(pFile) != 0) bReturn = false;
+    }
+
+    free(pStarts);
+    free(pData);
+
+    return bReturn;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
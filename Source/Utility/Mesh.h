@@ -0,0 +1,81 @@
+#if !defined (MESH_H_5B9E2D74_1C83_4A6F_B0D2_E47A93C5168F_)
+#define MESH_H_5B9E2D74_1C83_4A6F_B0D2_E47A93C5168F_
+
+#pragma once  // in case the compiler supports it
+
+// a binary mesh file is a header, the vertex attributes, the submeshes, the vertices and the indices in that
+// order, each section starts on a MESH_ALIGN boundary so the mapped file can be handed to the GL as it is
+#define MESH_MAGIC      0x4853454D  // "MESH" in the first four bytes of the file
+#define MESH_VERSION    1           // bumped whenever the layout below changes
+#define MESH_ALIGN      16          // alignment of every section in the file
+#define MESH_NAME_SIZE  32          // bytes of a material name, including the terminator
+
+// arrays a vertex attribute can feed, a file has at most one of each
+typedef enum {MESH_POSITION = 0, MESH_NORMAL, MESH_TEXCOORD, MESH_COLOR, MESH_ATTRIBUTES} MESHATTRIB;
+
+// where one attribute sits in the interleaved vertex
+typedef struct
+{
+    DWORD nAttribute;               // array the attribute feeds (MESHATTRIB)
+    DWORD nComponents;              // number of components (1 to 4)
+    DWORD nType;                    // GL type of each component (GL_FLOAT or GL_UNSIGNED_BYTE)
+    DWORD nOffset;                  // byte offset of the attribute in the vertex
+
+}  MESHATTRIBUTE;
+
+// a range of indices drawn with one material
+typedef struct
+{
+    DWORD nFirst;                   // first index of the range
+    DWORD nCount;                   // number of indices in the range (a multiple of three)
+    float afMin[3];                 // smallest corner of the box around the range
+    float afMax[3];                 // largest corner of the box around the range
+    char  szMaterial[MESH_NAME_SIZE]; // name of the material the range is drawn with (may be empty)
+
+}  MESHSUBMESH;
+
+// first bytes of the file, offsets are from the start of the file
+typedef struct
+{
+    DWORD nMagic;                   // MESH_MAGIC
+    DWORD nVersion;                 // MESH_VERSION
+    DWORD nFileSize;                // size of the whole file, a shorter file is truncated
+    DWORD nAttributes;              // number of vertex attributes
+    DWORD nVertexSize;              // bytes of one vertex (the stride of every attribute)
+    DWORD nVertices;                // number of vertices
+    DWORD nIndexType;               // GL type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+    DWORD nIndices;                 // number of indices (a multiple of three, every three are a triangle)
+    DWORD nSubmeshes;               // number of submeshes
+    DWORD nAttribOffset;            // where the vertex attributes start
+    DWORD nSubmeshOffset;           // where the submeshes start
+    DWORD nVertexOffset;            // where the vertices start
+    DWORD nIndexOffset;             // where the indices start
+    float afMin[3];                 // smallest corner of the box around the mesh
+    float afMax[3];                 // largest corner of the box around the mesh
+    DWORD nReserved;                // zero, pads the header to a multiple of MESH_ALIGN
+
+}  MESHHEADER;
+
+// a mesh file mapped into memory, the pointers are into the view and are never copied
+typedef struct
+{
+    const MESHHEADER    *pHeader;       // start of the view
+    const MESHATTRIBUTE *pAttributes;   // vertex attributes
+    const MESHSUBMESH   *pSubmeshes;    // submeshes
+    const BYTE          *pVertices;     // interleaved vertices
+    const BYTE          *pIndices;      // indices
+    GLuint               nVertexBuffer; // buffer object the vertices were uploaded into (zero if none)
+    GLuint               nIndexBuffer;  // buffer object the indices were uploaded into (zero if none)
+
+}  MESH, *PMESH;
+
+bool OpenMesh    (LPCTSTR szFile, PMESH pMesh);
+void CloseMesh   (PMESH pMesh);
+bool UploadMesh  (PMESH pMesh);
+void BindMesh    (const MESH *pMesh, bool bBind);
+void DrawSubmesh (const MESH *pMesh, unsigned int nSubmesh);
+
+// converts a Wavefront OBJ file into a binary mesh file, the materials become submeshes
+bool ConvertMesh (LPCTSTR szSource, LPCTSTR szMesh);
+
+#endif  // MESH_H
@@ -0,0 +1,440 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Extensions.h" // GL extension routines
+#include "Utility\General.h"    // general utility routines
+#include "Utility\Graphical.h"  // graphical utility routines
+#include "Utility\Profile.h"    // include for this file
+#include <intrin.h>             // compiler intrinsics
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// FRAME TIMING ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / The histograms are log-linear and count microseconds: every value below HISTOGRAM_LINEAR has its own bucket,
+/ / above that every power of two is split into HISTOGRAM_SUB buckets. That keeps the error of any percentile
+/ / under about 3% over a range of a microsecond to over an hour, in a fixed amount of memory that never grows.
+/ / Samples are added with interlocked operations only, so any thread may record at any time without a lock.
+/*/
+
+#define HISTOGRAM_LINEAR    64                                                  // values that get a bucket each
+#define HISTOGRAM_SUB       32                                                  // buckets per power of two above that
+#define HISTOGRAM_POWERS    26                                                  // powers of two covered above that
+#define HISTOGRAM_BUCKETS   (HISTOGRAM_LINEAR + (HISTOGRAM_SUB * HISTOGRAM_POWERS))
+
+typedef struct
+{
+    volatile LONG     anBuckets[HISTOGRAM_BUCKETS];     // number of samples that fell in each bucket
+    volatile LONGLONG nCount;                           // number of samples recorded
+    volatile LONGLONG nTotal;                           // sum of all the samples (in microseconds)
+    volatile LONG     nMax;                             // longest sample recorded (in microseconds)
+
+}  HISTOGRAM;
+
+// local function prototypes
+static unsigned int  __bucketOf    (unsigned long nMicro);
+static unsigned long __bucketFloor (unsigned int nBucket);
+static double        __percentile  (const HISTOGRAM *pHist, LONGLONG nCount, double dFraction);
+
+// local variables
+static HISTOGRAM _Histograms[PROFILE_COUNT];
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nChannel = which histogram to summarize
+/ /     pStats = pointer to the structure that receives the summary
+/ /
+/ / PURPOSE:
+/ /     Computes the count, mean, median, 95th and 99th percentiles and maximum of a channel.
+/ /     Returns false if nothing has been recorded in that channel yet.
+/ /
+/ / NOTES:
+/ /     This may be called while other threads are recording, the summary is then only approximate.
+/*/
+
+bool
+GetFrameStats (PROFILE nChannel, PFRAMESTATS pStats)
+{
+    const HISTOGRAM *pHist = NULL;
+    LONGLONG nCount = 0;
+
+    if((pStats == NULL) || (nChannel >= PROFILE_COUNT)) return false;
+
+    memset(pStats, 0, sizeof(FRAMESTATS));
+    pHist = &_Histograms[nChannel];
+
+    if((nCount = pHist->nCount) <= 0) return false;
+
+    pStats->nCount = nCount;
+    pStats->dMean  = ((double)pHist->nTotal / (double)nCount) / 1000.0;
+    pStats->dMax   = pHist->nMax / 1000.0;
+    pStats->dP50   = __percentile(pHist, nCount, 0.50);
+    pStats->dP95   = __percentile(pHist, nCount, 0.95);
+    pStats->dP99   = __percentile(pHist, nCount, 0.99);
+
+    // the percentiles are estimated from the buckets, so never let them go past what was really seen
+    if(pStats->dP50 > pStats->dMax) pStats->dP50 = pStats->dMax;
+    if(pStats->dP95 > pStats->dMax) pStats->dP95 = pStats->dMax;
+    if(pStats->dP99 > pStats->dMax) pStats->dP99 = pStats->dMax;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nChannel = which histogram to add the sample to
+/ /     dSeconds = the time being recorded, in seconds (as returned by GetClockSeconds() differences)
+/ /
+/ / PURPOSE:
+/ /     Adds one sample to a histogram. This is cheap enough to call several times every frame.
+/ /
+/ / NOTES:
+/ /     This is safe to call from any thread, it never locks or allocates.
+/*/
+
+void
+RecordFrameTime (PROFILE nChannel, double dSeconds)
+{
+    HISTOGRAM *pHist = NULL;
+    unsigned long nMicro = 0;
+    LONG nMax = 0;
+
+    if((nChannel >= PROFILE_COUNT) || (dSeconds < 0.0)) return;
+
+    pHist = &_Histograms[nChannel];
+
+    // anything past what a LONG holds is clamped, that's over half an hour for a single sample
+    nMicro = (dSeconds >= 2147.0) ? 0x7FFFFFFF : (unsigned long)((dSeconds * 1000000.0) + 0.5);
+
+    InterlockedIncrement(&pHist->anBuckets[__bucketOf(nMicro)]);
+    InterlockedIncrement64(&pHist->nCount);
+    InterlockedExchangeAdd64(&pHist->nTotal, nMicro);
+
+    // only replace the maximum if nobody else raised it past ours in the meantime
+    while((LONG)nMicro > (nMax = pHist->nMax))
+    {
+        if(InterlockedCompareExchange(&pHist->nMax, (LONG)nMicro, nMax) == nMax) break;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Empties every histogram.
+/ /
+/ / NOTES:
+/ /     This should only be called when nothing is recording, i.e. before the render loop starts or in
+/ /     between two frames (once the warm-up of a benchmark is over).
+/*/
+
+void
+ResetFrameTimes (void)
+{
+    memset((void *)_Histograms, 0, sizeof(_Histograms));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szBaseName = path and name of the files to write, without an extension
+/ /
+/ / PURPOSE:
+/ /     Writes the summary of every channel to <szBaseName>.json and every non-empty bucket of every
+/ /     channel to <szBaseName>.csv, so the full distribution can be plotted. Returns false if either
+/ /     file could not be written.
+/*/
+
+bool
+WriteFrameStats (LPCTSTR szBaseName)
+{
+    static const LPCTSTR szChannels[] = PROFILE_NAMES;
+    TCHAR szPath[MAX_PATH] = {0};
+    FILE *pFile = NULL;
+    FRAMESTATS Stats = {0};
+    bool bReturn = true;
+    unsigned int i = 0, j = 0;
+
+    if((szBaseName == NULL) || (szBaseName[0] == _T('\0'))) return false;
+
+    // the summary, one object per channel
+    _stprintf_s(szPath, STRING_SIZE(szPath), _T("%s.json"), szBaseName);
+    if(_tfopen_s(&pFile, szPath, _T("w")) == 0)
+    {
+        _ftprintf(pFile, _T("{\n"));
+
+        for(i = 0; i < PROFILE_COUNT; i++)
+        {
+            GetFrameStats((PROFILE)i, &Stats);
+            _ftprintf(pFile, _T("    \"%s\": {\"count\": %I64u, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}%s\n"),
+                szChannels[i], Stats.nCount, Stats.dMean, Stats.dP50, Stats.dP95, Stats.dP99, Stats.dMax, (i < (PROFILE_COUNT - 1)) ? _T(",") : _T(""));
+        }
+
+        _ftprintf(pFile, _T("}\n"));
+        fclose(pFile);
+    }
+    else
+        bReturn = false;
+
+    // the distributions, one row per bucket that has anything in it
+    _stprintf_s(szPath, STRING_SIZE(szPath), _T("%s.csv"), szBaseName);
+    if(_tfopen_s(&pFile, szPath, _T("w")) == 0)
+    {
+        _ftprintf(pFile, _T("channel,from_us,to_us,count\n"));
+
+        for(i = 0; i < PROFILE_COUNT; i++)
+        {
+            for(j = 0; j < HISTOGRAM_BUCKETS; j++)
+            {
+                if(_Histograms[i].anBuckets[j] > 0)
+                {
+                    _ftprintf(pFile, _T("%s,%lu,%lu,%ld\n"), szChannels[i], __bucketFloor(j),
+                        (j < (HISTOGRAM_BUCKETS - 1)) ? __bucketFloor(j + 1) - 1 : 0xFFFFFFFF, _Histograms[i].anBuckets[j]);
+                }
+            }
+        }
+
+        fclose(pFile);
+    }
+    else
+        bReturn = false;
+
+    return bReturn;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nMicro = sample in microseconds
+/ /
+/ / PURPOSE:
+/ /     Returns the index of the bucket a sample falls in.
+/*/
+
+static unsigned int
+__bucketOf (unsigned long nMicro)
+{
+    unsigned long nBit = 0, nShift = 0;
+
+    if(nMicro < HISTOGRAM_LINEAR) return nMicro;
+
+    // the highest bit set picks the power of two, the next five bits pick the sub-bucket within it
+    _BitScanReverse(&nBit, nMicro);
+    nShift = nBit - 5;
+
+    return HISTOGRAM_LINEAR + ((nBit - 6) * HISTOGRAM_SUB) + ((nMicro >> nShift) - HISTOGRAM_SUB);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nBucket = index of the bucket
+/ /
+/ / PURPOSE:
+/ /     Returns the smallest sample (in microseconds) that falls in a bucket, the opposite of __bucketOf().
+/*/
+
+static unsigned long
+__bucketFloor (unsigned int nBucket)
+{
+    unsigned long nPower = 0;
+
+    if(nBucket < HISTOGRAM_LINEAR) return nBucket;
+
+    nPower = (nBucket - HISTOGRAM_LINEAR) / HISTOGRAM_SUB;
+    return ((unsigned long)HISTOGRAM_SUB + ((nBucket - HISTOGRAM_LINEAR) % HISTOGRAM_SUB)) << (nPower + 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pHist = histogram to look in
+/ /     nCount = number of samples in the histogram
+/ /     dFraction = which percentile to find, from 0.0 to 1.0
+/ /
+/ / PURPOSE:
+/ /     Returns the middle of the bucket the percentile falls in, in milliseconds.
+/*/
+
+static double
+__percentile (const HISTOGRAM *pHist, LONGLONG nCount, double dFraction)
+{
+    LONGLONG nRank = (LONGLONG)((nCount * dFraction) + 0.5), nSeen = 0;
+    unsigned int i = 0;
+
+    if(nRank < 1) nRank = 1;
+
+    for(i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        nSeen += pHist->anBuckets[i];
+        if(nSeen >= nRank)
+        {
+            // the last bucket has no upper edge, so just use its floor
+            if(i == (HISTOGRAM_BUCKETS - 1)) return __bucketFloor(i) / 1000.0;
+            return ((__bucketFloor(i) + __bucketFloor(i + 1)) / 2.0) / 1000.0;
+        }
+    }
+
+    return pHist->nMax / 1000.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////// GPU TIMING ROUTINES /////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / The GPU runs behind the CPU, so its timestamps are only known a few frames after they were asked for. Every
+/ / frame gets its own set of timestamp queries from a ring of GPU_FRAMES sets; when a set comes around again its
+/ / results are read only if the GPU has already written them, otherwise that frame is simply not recorded. This
+/ / never waits on the GPU, so measuring it doesn't change what is being measured.
+/*/
+
+#define GPU_FRAMES  4                   // frames in flight before a set of queries is reused
+
+// local variables (the ring of queries, one set per frame in flight, and one ring per render thread)
+static __declspec(thread) GLuint _anQueries[GPU_FRAMES][GPU_MARKS];    // query object names
+static __declspec(thread) bool   _abPending[GPU_FRAMES];               // flags to indicate a set has every timestamp issued but not yet read
+static __declspec(thread) UINT   _nGPUFrame = 0;                       // set of queries the current frame is using
+static __declspec(thread) bool   _bGPUTimers = false;                  // flag to indicate the queries have been created
+static __declspec(thread) double _dGPUDrawn = 0.0;                     // seconds the GPU took to clear and draw the last frame read back
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Creates the ring of timestamp queries. Returns false if the GL has no timer queries, in which case
+/ /     MarkGPUTime() does nothing and the GPU channels stay empty.
+/ /
+/ / NOTE:
+/ /     This needs to be called after there's a valid RC (Render Context). Mesa's llvmpipe has timer queries
+/ /     too, so the GPU channels can be recorded on machines without a GPU.
+/*/
+
+bool
+InitGPUTimers (void)
+{
+    if(_bGPUTimers) return true;
+    if(!HasCapability(CAP_TIMER_QUERIES)) return false;
+
+    glGenQueries(GPU_FRAMES * GPU_MARKS, &_anQueries[0][0]);
+    memset(_abPending, 0, sizeof(_abPending));
+    _nGPUFrame = 0;
+    _dGPUDrawn = 0.0;
+    _bGPUTimers = true;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Deletes the queries InitGPUTimers() created. Results still in flight are thrown away.
+/ /
+/ / NOTE:
+/ /     This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+void
+DestroyGPUTimers (void)
+{
+    if(!_bGPUTimers) return;
+
+    glDeleteQueries(GPU_FRAMES * GPU_MARKS, &_anQueries[0][0]);
+    memset(_anQueries, 0, sizeof(_anQueries));
+    _bGPUTimers = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nMark = which point of the frame has just been reached
+/ /
+/ / PURPOSE:
+/ /     Asks the GPU to write down the time it reaches this point of the command stream. Every frame must
+/ /     mark all the points in order, starting with GPU_BEGIN, which is also when the results of the frame
+/ /     that used the same set of queries GPU_FRAMES ago are recorded (if they are ready by then).
+/ /
+/ / NOTE:
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+MarkGPUTime (GPUMARK nMark)
+{
+    GLuint *pQueries = NULL;
+    ULONGLONG anTimes[GPU_MARKS] = {0};
+    GLint nReady = 0;
+    UINT i = 0;
+
+    if(!_bGPUTimers || (nMark >= GPU_MARKS)) return;
+
+    if(nMark == GPU_BEGIN)
+    {
+        _nGPUFrame = (_nGPUFrame + 1) % GPU_FRAMES;
+        pQueries = _anQueries[_nGPUFrame];
+
+        // the last timestamp of a frame is the last one the GPU writes, so if it's there they all are
+        if(_abPending[_nGPUFrame])
+        {
+            glGetQueryObjectiv(pQueries[GPU_SHOWN], GL_QUERY_RESULT_AVAILABLE, &nReady);
+            if(nReady)
+            {
+                for(i = 0; i < GPU_MARKS; i++) glGetQueryObjectui64v(pQueries[i], GL_QUERY_RESULT, &anTimes[i]);
+
+                // the timestamps are in nanoseconds
+                RecordFrameTime(PROFILE_GPU_CLEAR, (anTimes[GPU_CLEARED] - anTimes[GPU_BEGIN]) / 1000000000.0);
+                RecordFrameTime(PROFILE_GPU_DELEGATE, (anTimes[GPU_DRAWN] - anTimes[GPU_CLEARED]) / 1000000000.0);
+                RecordFrameTime(PROFILE_GPU_SWAP, (anTimes[GPU_SHOWN] - anTimes[GPU_DRAWN]) / 1000000000.0);
+                _dGPUDrawn = (anTimes[GPU_DRAWN] - anTimes[GPU_BEGIN]) / 1000000000.0;
+            }
+
+            _abPending[_nGPUFrame] = false;
+        }
+    }
+
+    glQueryCounter(_anQueries[_nGPUFrame][nMark], GL_TIMESTAMP);
+    if(nMark == GPU_SHOWN) _abPending[_nGPUFrame] = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns how long the GPU took to clear and draw the most recent frame whose timestamps have come back,
+/ /     in seconds, or zero if none have (or there are no timer queries).
+/ /
+/ / NOTE:
+/ /     This must be called in the context of the render thread. The frame it's about is a few frames old.
+/*/
+
+double
+GetGPUFrameTime (void)
+{
+    return _bGPUTimers ? _dGPUDrawn : 0.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
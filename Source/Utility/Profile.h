@@ -0,0 +1,35 @@
+#if !defined (PROFILE_H_8E4C2A71_0B3D_4F59_A6E2_7D1C93B5F048_)
+#define PROFILE_H_8E4C2A71_0B3D_4F59_A6E2_7D1C93B5F048_
+
+#pragma once  // in case the compiler supports it
+
+// what is being timed, every channel gets its own histogram, the names are used when writing them out
+typedef enum {PROFILE_FRAME = 0, PROFILE_UPDATE, PROFILE_DELEGATE, PROFILE_SWAP, PROFILE_RASTER, PROFILE_GPU_CLEAR, PROFILE_GPU_DELEGATE, PROFILE_GPU_SWAP, PROFILE_COUNT} PROFILE;
+#define PROFILE_NAMES {_T("frame"), _T("update"), _T("delegate"), _T("swap"), _T("raster"), _T("gpu_clear"), _T("gpu_delegate"), _T("gpu_swap")}
+
+// points in a frame the GPU timestamps are taken at, the GPU channels above are the time between two of them
+typedef enum {GPU_BEGIN = 0, GPU_CLEARED, GPU_DRAWN, GPU_SHOWN, GPU_MARKS} GPUMARK;
+
+// summary of one channel, all times are in milliseconds
+typedef struct
+{
+    ULONGLONG nCount;               // number of samples recorded
+    double    dMean;                // average of all the samples
+    double    dP50;                 // median
+    double    dP95;                 // 95th percentile
+    double    dP99;                 // 99th percentile
+    double    dMax;                 // longest sample recorded
+
+}  FRAMESTATS, *PFRAMESTATS;
+
+bool GetFrameStats   (PROFILE nChannel, PFRAMESTATS pStats);
+void RecordFrameTime (PROFILE nChannel, double dSeconds);
+void ResetFrameTimes (void);
+bool WriteFrameStats (LPCTSTR szBaseName);
+
+bool   InitGPUTimers    (void);
+void   DestroyGPUTimers (void);
+void   MarkGPUTime      (GPUMARK nMark);
+double GetGPUFrameTime  (void);
+
+#endif  // PROFILE_H
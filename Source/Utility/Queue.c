@@ -0,0 +1,78 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Queue.h"      // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////// SINGLE PRODUCER QUEUE ROUTINES //////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / The counters only ever grow (wrapping around is harmless since the capacity is a power of two) and each is
+/ / written by one thread only, so no lock is needed. An item is copied into its slot before the producer
+/ / publishes the new write count, and copied out of it before the consumer publishes the new read count; the
+/ / interlocked exchange used to publish a count is a full barrier, so the other thread never sees a count
+/ / before the slot it covers is ready.
+/*/
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to take the oldest item from
+/ /     pItem = buffer that receives a copy of the item (must be at least as big as one item)
+/ /
+/ / PURPOSE:
+/ /     Removes the oldest item from the queue. Returns false if the queue is empty.
+/ /
+/ / NOTES:
+/ /     Only one thread may pop items from a queue.
+/*/
+
+bool
+PopQueueItem (PQUEUE pQueue, void *pItem)
+{
+    LONG nRead = 0;
+
+    if((pQueue == NULL) || (pItem == NULL)) return false;
+
+    nRead = pQueue->nRead;
+    if(nRead == pQueue->nWrite) return false;
+
+    memcpy(pItem, pQueue->pItems + ((nRead & (pQueue->nCapacity - 1)) * pQueue->nItemSize), pQueue->nItemSize);
+    InterlockedExchange(&pQueue->nRead, nRead + 1);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pQueue = queue to add the item to
+/ /     pItem = item to copy into the queue
+/ /
+/ / PURPOSE:
+/ /     Adds an item to the end of the queue. Returns false if the queue is full, in which case the
+/ /     item is not added.
+/ /
+/ / NOTES:
+/ /     Only one thread may push items into a queue.
+/*/
+
+bool
+PushQueueItem (PQUEUE pQueue, const void *pItem)
+{
+    LONG nWrite = 0;
+
+    if((pQueue == NULL) || (pItem == NULL)) return false;
+
+    nWrite = pQueue->nWrite;
+    if((nWrite - pQueue->nRead) >= pQueue->nCapacity) return false;
+
+    memcpy(pQueue->pItems + ((nWrite & (pQueue->nCapacity - 1)) * pQueue->nItemSize), pItem, pQueue->nItemSize);
+    InterlockedExchange(&pQueue->nWrite, nWrite + 1);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
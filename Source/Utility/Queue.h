@@ -0,0 +1,27 @@
+#if !defined (QUEUE_H_3F7A0C5D_61E2_4B8D_9C14_A5E0D2B7F6C9_)
+#define QUEUE_H_3F7A0C5D_61E2_4B8D_9C14_A5E0D2B7F6C9_
+
+#pragma once  // in case the compiler supports it
+
+// bounded queue for exactly one thread pushing and one (other) thread popping, the two counters are kept
+// on separate cache lines so the threads don't fight over one while they each update their own
+typedef struct
+{
+    volatile LONG nRead;            // number of items popped so far (only the consumer writes this)
+    BYTE          acPadRead[60];    // keeps the counters on separate cache lines
+    volatile LONG nWrite;           // number of items pushed so far (only the producer writes this)
+    BYTE          acPadWrite[60];   // keeps the counters on separate cache lines
+    LONG          nCapacity;        // number of items the queue can hold (must be a power of two)
+    size_t        nItemSize;        // size of one item in bytes
+    BYTE         *pItems;           // storage for the items, nCapacity * nItemSize bytes
+
+}  QUEUE, *PQUEUE;
+
+// initializes a queue with a fixed size array as its storage, e.g. static QUEUE q = QUEUE_INIT(aItems);
+// the number of elements in the array must be a power of two
+#define QUEUE_INIT(aItems) {0, {0}, 0, {0}, (LONG)(sizeof(aItems) / sizeof((aItems)[0])), sizeof((aItems)[0]), (BYTE *)(aItems)}
+
+bool PopQueueItem  (PQUEUE pQueue, void *pItem);
+bool PushQueueItem (PQUEUE pQueue, const void *pItem);
+
+#endif  // QUEUE_H
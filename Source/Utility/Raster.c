@@ -0,0 +1,778 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Arena.h"      // frame arena routines
+#include "Utility\Jobs.h"       // job routines
+#include "Utility\State.h"      // render state routines
+#include "Utility\VecMath.h"    // vector math routines
+#include "Utility\Raster.h"     // include for this file
+#include <malloc.h>             // _aligned_malloc()
+#include <math.h>               // sqrt(), floor(), ceil()
+
+#ifdef MATH_SIMD
+    #include <emmintrin.h>      // SSE2 intrinsics
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////// SOFTWARE RASTERIZATION ROUTINES ///////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / A frame is drawn in three steps. DrawRaster() transforms and lights the vertices of a mesh the way the fixed-function
+/ / pipeline set up by __initRender() would (one white point light at the eye, smooth shading), culls the triangles
+/ / facing away (the fronts are clockwise) and turns each of the others into three edge functions and a plane for its
+/ / depth and each color channel. EndRaster() then bins the triangles into square tiles of the screen, and the tiles
+/ / are handed to the job threads, each clears its own part of the color and depth buffers and fills the triangles
+/ / binned to it in the order they were drawn, so no two threads ever write the same pixel. The SSE kernel tests and
+/ / shades four pixels of a row at once. Finally the image is handed to the GL with glDrawPixels(), which every GL has.
+/ /
+/ / The edge functions of a shared edge are computed from its two vertices in the same order by both triangles, and
+/ / only negated for one of them, so they are exact opposites and a pixel centered on the edge belongs to exactly one
+/ / of them (the one it's the top or left edge of). Triangles that reach past the near plane are dropped rather than
+/ / clipped, none of the scenes come anywhere near it.
+/*/
+
+// width and height of a tile in pixels, the buffers are padded to a whole number of tiles (it must be a multiple of four)
+#define TILE_SIZE       64
+
+// light the fixed-function pipeline adds whatever the normal, the GL's default global ambient (0.2) times the
+// default ambient of a material (0.2), GL_COLOR_MATERIAL only replaces the diffuse color
+#define LIGHT_AMBIENT   0.04f
+
+// a vertex once it has been transformed and lit
+typedef struct
+{
+    float afWindow[3];              // window coordinates (0,0 is the bottom left corner), and depth from 0.0 to 1.0
+    float afColor[3];               // lit color from 0.0 to 255.0
+    bool  bVisible;                 // false if the vertex is behind the near plane
+
+}  RASTERPOINT;
+
+// a triangle ready to be filled, everything about it is a function of the pixel's center (Ax + By + C)
+typedef struct
+{
+    float afEdges[3][3];            // A, B and C of each edge, positive inside
+    int   anTopLeft[3];             // all bits set if a pixel centered on the edge is inside (a top or left edge)
+    float afDepth[3];               // plane of the depth
+    float afColor[3][3];            // plane of each color channel (red, green, blue)
+    int   nMinX, nMinY;             // first pixel the triangle may cover along each axis
+    int   nMaxX, nMaxY;             // one past the last pixel it may cover
+
+}  RASTERTRIANGLE, *PRASTERTRIANGLE;
+
+// what every job that fills a part of the tiles shares
+typedef struct
+{
+    const RASTERTRIANGLE *pTriangles;   // triangles of the frame, in the order they were drawn
+    const unsigned int   *pBins;        // the triangles binned to each tile, one tile after the other
+    const unsigned int   *pFirst;       // where each tile's triangles start in pBins (plus one past the last tile)
+    DWORD                *pColor;       // color buffer, one RGBA pixel per DWORD, the bottom row first
+    float                *pDepth;       // depth buffer
+    unsigned int          nStride;      // pixels per row of the buffers
+    unsigned int          nTilesX;      // tiles per row of the screen
+    bool                  bSIMD;        // flag to indicate the SSE kernel is used
+
+}  RASTERJOB;
+
+// local function prototypes
+static void __fillTiles    (void *pData, unsigned int nBegin, unsigned int nEnd);
+static void __fillTriangle (const RASTERJOB *pJob, const RASTERTRIANGLE *pTriangle, int x0, int y0, int x1, int y1);
+static bool __growRaster   (unsigned int nWidth, unsigned int nHeight);
+static void __presentRaster (void);
+static bool __setupTriangle (PRASTERTRIANGLE pTriangle, const RASTERPOINT *p0, const RASTERPOINT *p1, const RASTERPOINT *p2);
+static bool __touchesTile  (const RASTERTRIANGLE *pTriangle, int x0, int y0, int x1, int y1);
+
+// local variables (each render thread draws a frame of its own, so they're kept per thread)
+static __declspec(thread) DWORD          *_pColor     = NULL;   // color buffer (aligned to 16 bytes)
+static __declspec(thread) float          *_pDepth     = NULL;   // depth buffer (aligned to 16 bytes)
+static __declspec(thread) unsigned int    _nStride    = 0;      // pixels per row of the buffers (a multiple of TILE_SIZE)
+static __declspec(thread) unsigned int    _nRows      = 0;      // rows of the buffers (a multiple of TILE_SIZE)
+static __declspec(thread) unsigned int    _nWidth     = 0;      // width of the frame being drawn
+static __declspec(thread) unsigned int    _nHeight    = 0;      // height of the frame being drawn
+static __declspec(thread) MAT4            _Projection = {0};    // projection of the frame being drawn
+
+static __declspec(thread) PRASTERTRIANGLE _pTriangles = NULL;   // triangles of the frame being drawn
+static __declspec(thread) unsigned int    _nTriangles = 0;      // number of them
+static __declspec(thread) unsigned int    _nCapacity  = 0;      // number of them the array can hold
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Gets the rasterizer ready to draw. The buffers are only allocated once the first frame says how big it is.
+/ /     Returns false if the memory for the triangles couldn't be allocated.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once, before BeginRaster() is.
+/*/
+
+bool
+InitRaster (void)
+{
+    DestroyRaster();
+
+    _nCapacity = 256;
+    if((_pTriangles = (PRASTERTRIANGLE)malloc(_nCapacity * sizeof(RASTERTRIANGLE))) == NULL) _nCapacity = 0;
+
+    return (_pTriangles != NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Releases the buffers and the triangles of the rasterizer.
+/*/
+
+void
+DestroyRaster (void)
+{
+    if(_pColor != NULL) _aligned_free(_pColor);
+    if(_pDepth != NULL) _aligned_free(_pDepth);
+    _pColor = NULL;
+    _pDepth = NULL;
+    _nStride = _nRows = _nWidth = _nHeight = 0;
+
+    free(_pTriangles);
+    _pTriangles = NULL;
+    _nTriangles = _nCapacity = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nWidth = width of the frame in pixels
+/ /     nHeight = height of the frame in pixels
+/ /     pProjection = projection the meshes of the frame are drawn with
+/ /
+/ / PURPOSE:
+/ /     Starts a frame, the meshes drawn until EndRaster() is called are all part of it. Returns false if the
+/ /     buffers couldn't be made big enough, in which case nothing is drawn.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, the buffers only ever grow.
+/*/
+
+bool
+BeginRaster (unsigned int nWidth, unsigned int nHeight, const MAT4 *pProjection)
+{
+    _nWidth = _nHeight = _nTriangles = 0;
+
+    if((nWidth == 0) || (nHeight == 0) || (pProjection == NULL) || (_pTriangles == NULL)) return false;
+    if(!__growRaster(nWidth, nHeight)) return false;
+
+    _nWidth = nWidth;
+    _nHeight = nHeight;
+    _Projection = *pProjection;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pModelView = transform of the mesh, as it would be loaded into the modelview matrix
+/ /     pVertices = vertices of the mesh
+/ /     pIndices = three indices per triangle
+/ /     nIndices = number of indices
+/ /
+/ / PURPOSE:
+/ /     Transforms and lights the vertices of a mesh and adds the triangles of it that face the eye to the frame,
+/ /     as glDrawElements(GL_TRIANGLES, ...) would with the lighting, culling and depth test __initRender() sets up.
+/ /
+/ / NOTES:
+/ /     The normals are transformed by the upper 3x3 of pModelView and normalized, so the transform must not skew.
+/ /     The lit vertices of the mesh only live until the end of the frame, in the frame arena.
+/*/
+
+void
+DrawRaster (const MAT4 *pModelView, const RASTERVERTEX *pVertices, const BYTE *pIndices, unsigned int nIndices)
+{
+    const float *m = NULL, *p = _Projection.m;
+    RASTERPOINT *pPoints = NULL;
+    unsigned int i = 0, nVertices = 0;
+
+    if((_nWidth == 0) || (pModelView == NULL) || (pVertices == NULL) || (pIndices == NULL)) return;
+    m = pModelView->m;
+
+    // only the vertices the indices use are lit, and they can't go past the largest index
+    for(i = 0; i < nIndices; i++)
+        if(pIndices[i] >= nVertices) nVertices = pIndices[i] + 1;
+
+    if((pPoints = (RASTERPOINT *)FrameAlloc(nVertices * sizeof(RASTERPOINT))) == NULL) return;
+
+    for(i = 0; i < nVertices; i++)
+    {
+        const float *v = pVertices[i].afPosition, *n = pVertices[i].afNormal;
+        VEC3 Eye, Normal, Light;
+        float afClip[4], fDiffuse = 0.0f;
+        int c = 0;
+
+        // into eye space, where the light is (it sits at the eye)
+        Eye.x = (m[0] * v[0]) + (m[4] * v[1]) + (m[8] * v[2]) + m[12];
+        Eye.y = (m[1] * v[0]) + (m[5] * v[1]) + (m[9] * v[2]) + m[13];
+        Eye.z = (m[2] * v[0]) + (m[6] * v[1]) + (m[10] * v[2]) + m[14];
+
+        Normal.x = (m[0] * n[0]) + (m[4] * n[1]) + (m[8] * n[2]);
+        Normal.y = (m[1] * n[0]) + (m[5] * n[1]) + (m[9] * n[2]);
+        Normal.z = (m[2] * n[0]) + (m[6] * n[1]) + (m[10] * n[2]);
+        Normal = NormalizeVector3(&Normal);
+
+        Light.x = -Eye.x; Light.y = -Eye.y; Light.z = -Eye.z;
+        Light = NormalizeVector3(&Light);
+
+        fDiffuse = DotVector3(&Normal, &Light);
+        if(fDiffuse < 0.0f) fDiffuse = 0.0f;
+
+        for(c = 0; c < 3; c++)
+        {
+            pPoints[i].afColor[c] = (LIGHT_AMBIENT + (fDiffuse * (pVertices[i].acColor[c] / 255.0f))) * 255.0f;
+            if(pPoints[i].afColor[c] > 255.0f) pPoints[i].afColor[c] = 255.0f;
+        }
+
+        // then into clip space, and on to the window
+        afClip[0] = (p[0] * Eye.x) + (p[4] * Eye.y) + (p[8] * Eye.z) + p[12];
+        afClip[1] = (p[1] * Eye.x) + (p[5] * Eye.y) + (p[9] * Eye.z) + p[13];
+        afClip[2] = (p[2] * Eye.x) + (p[6] * Eye.y) + (p[10] * Eye.z) + p[14];
+        afClip[3] = (p[3] * Eye.x) + (p[7] * Eye.y) + (p[11] * Eye.z) + p[15];
+
+        pPoints[i].bVisible = (afClip[3] > 0.0f) && (afClip[2] >= -afClip[3]);
+        if(!pPoints[i].bVisible) continue;
+
+        pPoints[i].afWindow[0] = ((afClip[0] / afClip[3]) + 1.0f) * 0.5f * _nWidth;
+        pPoints[i].afWindow[1] = ((afClip[1] / afClip[3]) + 1.0f) * 0.5f * _nHeight;
+        pPoints[i].afWindow[2] = ((afClip[2] / afClip[3]) + 1.0f) * 0.5f;
+    }
+
+    for(i = 0; (i + 2) < nIndices; i += 3)
+    {
+        // the array grows if it has to, if it can't then the rest of the mesh is dropped
+        if(_nTriangles == _nCapacity)
+        {
+            PRASTERTRIANGLE pTriangles = (PRASTERTRIANGLE)realloc(_pTriangles, (_nCapacity * 2) * sizeof(RASTERTRIANGLE));
+
+            if(pTriangles == NULL) return;
+            _pTriangles = pTriangles;
+            _nCapacity *= 2;
+        }
+
+        if(__setupTriangle(&_pTriangles[_nTriangles], &pPoints[pIndices[i]], &pPoints[pIndices[i + 1]], &pPoints[pIndices[i + 2]]))
+            _nTriangles++;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Bins the triangles of the frame into tiles, fills the tiles on the job threads and hands the finished image
+/ /     to the GL, in place of whatever the GL drew of the frame so far. Pixels no triangle covered are left alone,
+/ /     so anything drawn behind the scene (like the backdrop) still shows.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once per BeginRaster() that returned true.
+/*/
+
+void
+EndRaster (void)
+{
+    RASTERJOB Job = {0};
+    unsigned int *pFirst = NULL, *pNext = NULL, *pBins = NULL;
+    unsigned int i = 0, nTilesX = 0, nTilesY = 0, nTiles = 0, nBinned = 0;
+    int x = 0, y = 0;
+
+    if(_nWidth == 0) return;
+
+    nTilesX = (_nWidth + TILE_SIZE - 1) / TILE_SIZE;
+    nTilesY = (_nHeight + TILE_SIZE - 1) / TILE_SIZE;
+    nTiles = nTilesX * nTilesY;
+
+    // the bins only matter for this frame, so they live in the frame arena
+    pFirst = (unsigned int *)FrameAlloc((nTiles + 1) * sizeof(unsigned int));
+    pNext = (unsigned int *)FrameAlloc(nTiles * sizeof(unsigned int));
+    if((pFirst == NULL) || (pNext == NULL)) return;
+
+    // count how many triangles each tile gets, so they can all go into one array
+    memset(pNext, 0, nTiles * sizeof(unsigned int));
+
+    for(i = 0; i < _nTriangles; i++)
+    {
+        const RASTERTRIANGLE *pTriangle = &_pTriangles[i];
+
+        for(y = pTriangle->nMinY / TILE_SIZE; y <= (pTriangle->nMaxY - 1) / TILE_SIZE; y++)
+            for(x = pTriangle->nMinX / TILE_SIZE; x <= (pTriangle->nMaxX - 1) / TILE_SIZE; x++)
+                if(__touchesTile(pTriangle, x * TILE_SIZE, y * TILE_SIZE, (x + 1) * TILE_SIZE, (y + 1) * TILE_SIZE))
+                    pNext[(y * nTilesX) + x]++;
+    }
+
+    for(i = 0; i < nTiles; i++)
+    {
+        pFirst[i] = nBinned;
+        nBinned += pNext[i];
+        pNext[i] = pFirst[i];
+    }
+
+    pFirst[nTiles] = nBinned;
+
+    // then bin them, in the order they were drawn so the depth test settles ties the same way the GL would
+    if((nBinned > 0) && ((pBins = (unsigned int *)FrameAlloc(nBinned * sizeof(unsigned int))) == NULL)) return;
+
+    for(i = 0; i < _nTriangles; i++)
+    {
+        const RASTERTRIANGLE *pTriangle = &_pTriangles[i];
+
+        for(y = pTriangle->nMinY / TILE_SIZE; y <= (pTriangle->nMaxY - 1) / TILE_SIZE; y++)
+            for(x = pTriangle->nMinX / TILE_SIZE; x <= (pTriangle->nMaxX - 1) / TILE_SIZE; x++)
+                if(__touchesTile(pTriangle, x * TILE_SIZE, y * TILE_SIZE, (x + 1) * TILE_SIZE, (y + 1) * TILE_SIZE))
+                    pBins[pNext[(y * nTilesX) + x]++] = i;
+    }
+
+    Job.pTriangles = _pTriangles;
+    Job.pBins = pBins;
+    Job.pFirst = pFirst;
+    Job.pColor = _pColor;
+    Job.pDepth = _pDepth;
+    Job.nStride = _nStride;
+    Job.nTilesX = nTilesX;
+    Job.bSIMD = false;
+
+    #ifdef MATH_SIMD
+        // the kernel also needs SSE2, which the x86 build already assumes and every x64 CPU has
+        Job.bSIMD = (GetMathPath() != MATH_SCALAR);
+    #endif
+
+    // a tile is a lot of work, so every one of them is a job of its own
+    ParallelFor(nTiles, 1, __fillTiles, &Job);
+
+    __presentRaster();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pData = pointer to the RASTERJOB shared by every job
+/ /     nBegin = first tile to fill
+/ /     nEnd = one past the last tile to fill
+/ /
+/ / PURPOSE:
+/ /     Clears a range of tiles and fills the triangles binned to each of them, this runs as a job.
+/*/
+
+static void
+__fillTiles (void *pData, unsigned int nBegin, unsigned int nEnd)
+{
+    const RASTERJOB *pJob = (const RASTERJOB *)pData;
+    unsigned int i = 0, j = 0;
+    int x0 = 0, y0 = 0, y = 0, x = 0;
+
+    for(i = nBegin; i < nEnd; i++)
+    {
+        x0 = (i % pJob->nTilesX) * TILE_SIZE;
+        y0 = (i / pJob->nTilesX) * TILE_SIZE;
+
+        // nothing covered is transparent black (the alpha marks what was drawn) and as far away as can be
+        for(y = y0; y < (y0 + TILE_SIZE); y++)
+        {
+            memset(pJob->pColor + (y * pJob->nStride) + x0, 0, TILE_SIZE * sizeof(DWORD));
+            for(x = x0; x < (x0 + TILE_SIZE); x++) pJob->pDepth[(y * pJob->nStride) + x] = 1.0f;
+        }
+
+        for(j = pJob->pFirst[i]; j < pJob->pFirst[i + 1]; j++)
+            __fillTriangle(pJob, &pJob->pTriangles[pJob->pBins[j]], x0, y0, x0 + TILE_SIZE, y0 + TILE_SIZE);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pJob = what every job shares
+/ /     pTriangle = triangle to fill
+/ /     x0, y0 = first pixel of the tile along each axis
+/ /     x1, y1 = one past the last pixel of the tile along each axis
+/ /
+/ / PURPOSE:
+/ /     Fills the part of a triangle that's inside a tile, every pixel whose center is inside the triangle and
+/ /     passes the depth test (GL_LEQUAL) gets the triangle's depth and interpolated color there.
+/ /
+/ / NOTES:
+/ /     The SSE kernel works on four pixels of a row at a time, starting on a multiple of four, the tiles are
+/ /     a multiple of four wide so it never leaves the tile. Both kernels work out the edge functions with the
+/ /     same operations in the same order, so they agree on which pixels a triangle covers.
+/*/
+
+static void
+__fillTriangle (const RASTERJOB *pJob, const RASTERTRIANGLE *pTriangle, int x0, int y0, int x1, int y1)
+{
+    const float (*e)[3] = pTriangle->afEdges;
+    const float (*c)[3] = pTriangle->afColor;
+    const float *z = pTriangle->afDepth;
+    int x = 0, y = 0, k = 0;
+
+    if(pTriangle->nMinX > x0) x0 = pTriangle->nMinX;
+    if(pTriangle->nMinY > y0) y0 = pTriangle->nMinY;
+    if(pTriangle->nMaxX < x1) x1 = pTriangle->nMaxX;
+    if(pTriangle->nMaxY < y1) y1 = pTriangle->nMaxY;
+
+    #ifdef MATH_SIMD
+
+        if(pJob->bSIMD)
+        {
+            const __m128 Offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f), Zero = _mm_setzero_ps(), Full = _mm_set1_ps(255.0f);
+            const __m128i Alpha = _mm_set1_epi32(0xFF000000);
+            __m128 A[3], TopLeft[3], Zx, Rx, Gx, Bx;
+
+            for(k = 0; k < 3; k++)
+            {
+                A[k] = _mm_set1_ps(e[k][0]);
+                TopLeft[k] = _mm_castsi128_ps(_mm_set1_epi32(pTriangle->anTopLeft[k]));
+            }
+
+            Zx = _mm_set1_ps(z[0]);
+            Rx = _mm_set1_ps(c[0][0]);
+            Gx = _mm_set1_ps(c[1][0]);
+            Bx = _mm_set1_ps(c[2][0]);
+
+            for(y = y0; y < y1; y++)
+            {
+                float fY = (float)y + 0.5f;
+                DWORD *pColor = pJob->pColor + (y * pJob->nStride);
+                float *pDepth = pJob->pDepth + (y * pJob->nStride);
+                __m128 Row[3], Zr, Rr, Gr, Br;
+
+                // what's the same all along the row is worked out once
+                for(k = 0; k < 3; k++) Row[k] = _mm_set1_ps((e[k][1] * fY) + e[k][2]);
+                Zr = _mm_set1_ps((z[1] * fY) + z[2]);
+                Rr = _mm_set1_ps((c[0][1] * fY) + c[0][2]);
+                Gr = _mm_set1_ps((c[1][1] * fY) + c[1][2]);
+                Br = _mm_set1_ps((c[2][1] * fY) + c[2][2]);
+
+                for(x = x0 & ~3; x < x1; x += 4)
+                {
+                    __m128 X = _mm_add_ps(_mm_set1_ps((float)x), Offsets), Mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                    __m128 Z, Depth, R, G, B;
+                    __m128i Pixels, Old;
+
+                    // a pixel is inside if it's inside all three edges, or on one that's a top or left edge
+                    for(k = 0; k < 3; k++)
+                    {
+                        __m128 E = _mm_add_ps(_mm_mul_ps(A[k], X), Row[k]);
+                        Mask = _mm_and_ps(Mask, _mm_or_ps(_mm_cmpgt_ps(E, Zero), _mm_and_ps(_mm_cmpeq_ps(E, Zero), TopLeft[k])));
+                    }
+
+                    if(_mm_movemask_ps(Mask) == 0) continue;
+
+                    Z = _mm_add_ps(_mm_mul_ps(Zx, X), Zr);
+                    Depth = _mm_load_ps(pDepth + x);
+                    Mask = _mm_and_ps(Mask, _mm_cmple_ps(Z, Depth));
+
+                    if(_mm_movemask_ps(Mask) == 0) continue;
+
+                    _mm_store_ps(pDepth + x, _mm_or_ps(_mm_and_ps(Mask, Z), _mm_andnot_ps(Mask, Depth)));
+
+                    R = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(Rx, X), Rr), Zero), Full);
+                    G = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(Gx, X), Gr), Zero), Full);
+                    B = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(Bx, X), Br), Zero), Full);
+
+                    // RGBA bytes in memory are ABGR in a little endian DWORD
+                    Pixels = _mm_or_si128(_mm_cvtps_epi32(R), _mm_slli_epi32(_mm_cvtps_epi32(G), 8));
+                    Pixels = _mm_or_si128(Pixels, _mm_or_si128(_mm_slli_epi32(_mm_cvtps_epi32(B), 16), Alpha));
+
+                    Old = _mm_load_si128((const __m128i *)(pColor + x));
+                    Pixels = _mm_or_si128(_mm_and_si128(_mm_castps_si128(Mask), Pixels), _mm_andnot_si128(_mm_castps_si128(Mask), Old));
+                    _mm_store_si128((__m128i *)(pColor + x), Pixels);
+                }
+            }
+
+            return;
+        }
+
+    #endif
+
+    for(y = y0; y < y1; y++)
+    {
+        float fY = (float)y + 0.5f;
+        DWORD *pColor = pJob->pColor + (y * pJob->nStride);
+        float *pDepth = pJob->pDepth + (y * pJob->nStride);
+        float afRow[3];
+
+        for(k = 0; k < 3; k++) afRow[k] = (e[k][1] * fY) + e[k][2];
+
+        for(x = x0; x < x1; x++)
+        {
+            float fX = (float)x + 0.5f, fZ = 0.0f, afPixel[3];
+            bool bInside = true;
+
+            for(k = 0; (k < 3) && bInside; k++)
+            {
+                float fE = (e[k][0] * fX) + afRow[k];
+                bInside = (fE > 0.0f) || ((fE == 0.0f) && (pTriangle->anTopLeft[k] != 0));
+            }
+
+            if(!bInside) continue;
+
+            fZ = (z[0] * fX) + ((z[1] * fY) + z[2]);
+            if(fZ > pDepth[x]) continue;
+
+            pDepth[x] = fZ;
+
+            for(k = 0; k < 3; k++)
+            {
+                afPixel[k] = (c[k][0] * fX) + ((c[k][1] * fY) + c[k][2]);
+                afPixel[k] = (afPixel[k] < 0.0f) ? 0.0f : ((afPixel[k] > 255.0f) ? 255.0f : afPixel[k]);
+            }
+
+            pColor[x] = 0xFF000000 | ((DWORD)(afPixel[2] + 0.5f) << 16) | ((DWORD)(afPixel[1] + 0.5f) << 8) | (DWORD)(afPixel[0] + 0.5f);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nWidth = width of the frame in pixels
+/ /     nHeight = height of the frame in pixels
+/ /
+/ / PURPOSE:
+/ /     Makes sure the color and depth buffers can hold a frame of the given size, rounded up to whole tiles.
+/ /     Returns false if they can't, the old buffers are gone by then.
+/*/
+
+static bool
+__growRaster (unsigned int nWidth, unsigned int nHeight)
+{
+    unsigned int nStride = ((nWidth + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE;
+    unsigned int nRows = ((nHeight + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE;
+
+    if((nStride <= _nStride) && (nRows <= _nRows) && (_pColor != NULL)) return true;
+
+    // never shrink along either axis, a window that's resized back and forth shouldn't reallocate every time
+    if(nStride < _nStride) nStride = _nStride;
+    if(nRows < _nRows) nRows = _nRows;
+
+    if(_pColor != NULL) _aligned_free(_pColor);
+    if(_pDepth != NULL) _aligned_free(_pDepth);
+    _nStride = _nRows = 0;
+
+    _pColor = (DWORD *)_aligned_malloc(nStride * nRows * sizeof(DWORD), 16);
+    _pDepth = (float *)_aligned_malloc(nStride * nRows * sizeof(float), 16);
+
+    if((_pColor == NULL) || (_pDepth == NULL))
+    {
+        if(_pColor != NULL) _aligned_free(_pColor);
+        if(_pDepth != NULL) _aligned_free(_pDepth);
+        _pColor = NULL;
+        _pDepth = NULL;
+        return false;
+    }
+
+    _nStride = nStride;
+    _nRows = nRows;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Draws the finished image over the whole viewport with glDrawPixels(), the alpha test keeps the pixels
+/ /     no triangle covered from being drawn.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, the GL's own depth buffer is left as it was.
+/*/
+
+static void
+__presentRaster (void)
+{
+    SetEnabled(GL_DEPTH_TEST, false);
+    SetEnabled(GL_LIGHTING, false);
+    SetEnabled(GL_ALPHA_TEST, true);
+    glAlphaFunc(GL_GREATER, 0.0f);
+
+    // the bottom left corner of the viewport is (-1, -1) once neither matrix changes anything
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glRasterPos2f(-1.0f, -1.0f);
+
+    // the rows of the buffers are longer than the frame is wide
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, _nStride);
+    glDrawPixels(_nWidth, _nHeight, GL_RGBA, GL_UNSIGNED_BYTE, _pColor);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    SetEnabled(GL_ALPHA_TEST, false);
+    SetEnabled(GL_LIGHTING, true);
+    SetEnabled(GL_DEPTH_TEST, true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pTriangle = receives the edge functions, planes and bounds of the triangle
+/ /     p0, p1, p2 = the triangle's vertices, in the order they were drawn
+/ /
+/ / PURPOSE:
+/ /     Gets a triangle ready to be filled. Returns false if there is nothing to fill, because it faces away from
+/ /     the eye (the fronts are clockwise on the screen), has no area, reaches past the near plane or is off screen.
+/*/
+
+static bool
+__setupTriangle (PRASTERTRIANGLE pTriangle, const RASTERPOINT *p0, const RASTERPOINT *p1, const RASTERPOINT *p2)
+{
+    const RASTERPOINT *apPoints[3];
+    float fArea = 0.0f, fMinX = 0.0f, fMinY = 0.0f, fMaxX = 0.0f, fMaxY = 0.0f;
+    int k = 0;
+
+    if(!p0->bVisible || !p1->bVisible || !p2->bVisible) return false;
+
+    // twice the signed area, positive if counterclockwise (the window's y axis points up)
+    fArea = ((p1->afWindow[0] - p0->afWindow[0]) * (p2->afWindow[1] - p0->afWindow[1])) -
+            ((p2->afWindow[0] - p0->afWindow[0]) * (p1->afWindow[1] - p0->afWindow[1]));
+
+    if(fArea >= 0.0f) return false;
+
+    // from here on the vertices go counterclockwise, so the inside is to the left of every edge
+    apPoints[0] = p0;
+    apPoints[1] = p2;
+    apPoints[2] = p1;
+    fArea = -fArea;
+
+    for(k = 0; k < 3; k++)
+    {
+        const float *a = apPoints[k]->afWindow, *b = apPoints[(k + 1) % 3]->afWindow;
+        float dx = b[0] - a[0], dy = b[1] - a[1];
+        bool bSwap = (a[0] > b[0]) || ((a[0] == b[0]) && (a[1] > b[1]));
+
+        // worked out from the lesser vertex to the greater whichever way the edge runs, so the triangle on the
+        // other side of it gets the exact same numbers, only negated
+        if(bSwap)
+        {
+            const float *t = a;
+            a = b;
+            b = t;
+        }
+
+        pTriangle->afEdges[k][0] = a[1] - b[1];
+        pTriangle->afEdges[k][1] = b[0] - a[0];
+        pTriangle->afEdges[k][2] = (a[0] * b[1]) - (a[1] * b[0]);
+
+        if(bSwap)
+        {
+            pTriangle->afEdges[k][0] = -pTriangle->afEdges[k][0];
+            pTriangle->afEdges[k][1] = -pTriangle->afEdges[k][1];
+            pTriangle->afEdges[k][2] = -pTriangle->afEdges[k][2];
+        }
+
+        // going counterclockwise, a left edge runs down the screen and a top edge runs right to left, of the two
+        // triangles sharing an edge it's only ever one of those for one of them
+        pTriangle->anTopLeft[k] = ((dy < 0.0f) || ((dy == 0.0f) && (dx < 0.0f))) ? -1 : 0;
+    }
+
+    // the depth and colors are planes through the values at the three vertices
+    {
+        const float *w0 = apPoints[0]->afWindow, *w1 = apPoints[1]->afWindow, *w2 = apPoints[2]->afWindow;
+        float ax = w1[0] - w0[0], ay = w1[1] - w0[1], bx = w2[0] - w0[0], by = w2[1] - w0[1];
+        float afValues[4][3];
+        int v = 0;
+
+        for(v = 0; v < 3; v++)
+        {
+            afValues[0][v] = apPoints[v]->afWindow[2];
+            afValues[1][v] = apPoints[v]->afColor[0];
+            afValues[2][v] = apPoints[v]->afColor[1];
+            afValues[3][v] = apPoints[v]->afColor[2];
+        }
+
+        for(k = 0; k < 4; k++)
+        {
+            float *pPlane = (k == 0) ? pTriangle->afDepth : pTriangle->afColor[k - 1];
+            float f1 = afValues[k][1] - afValues[k][0], f2 = afValues[k][2] - afValues[k][0];
+
+            pPlane[0] = ((f1 * by) - (f2 * ay)) / fArea;
+            pPlane[1] = ((f2 * ax) - (f1 * bx)) / fArea;
+            pPlane[2] = afValues[k][0] - (pPlane[0] * w0[0]) - (pPlane[1] * w0[1]);
+        }
+    }
+
+    // only pixels whose centers are inside the bounds can be covered, and only those on screen are filled
+    fMinX = fMaxX = p0->afWindow[0];
+    fMinY = fMaxY = p0->afWindow[1];
+
+    for(k = 1; k < 3; k++)
+    {
+        const float *w = apPoints[k]->afWindow;
+
+        if(w[0] < fMinX) fMinX = w[0];
+        if(w[0] > fMaxX) fMaxX = w[0];
+        if(w[1] < fMinY) fMinY = w[1];
+        if(w[1] > fMaxY) fMaxY = w[1];
+    }
+
+    if((fMaxX <= 0.0f) || (fMaxY <= 0.0f) || (fMinX >= (float)_nWidth) || (fMinY >= (float)_nHeight)) return false;
+
+    pTriangle->nMinX = (fMinX > 0.0f) ? (int)floor(fMinX) : 0;
+    pTriangle->nMinY = (fMinY > 0.0f) ? (int)floor(fMinY) : 0;
+    pTriangle->nMaxX = (fMaxX < (float)_nWidth) ? (int)ceil(fMaxX) : (int)_nWidth;
+    pTriangle->nMaxY = (fMaxY < (float)_nHeight) ? (int)ceil(fMaxY) : (int)_nHeight;
+
+    return (pTriangle->nMinX < pTriangle->nMaxX) && (pTriangle->nMinY < pTriangle->nMaxY);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pTriangle = triangle to test
+/ /     x0, y0 = first pixel of the tile along each axis
+/ /     x1, y1 = one past the last pixel of the tile along each axis
+/ /
+/ / PURPOSE:
+/ /     Returns false if the tile is entirely outside one of the triangle's edges, so it can't cover any of it.
+/ /
+/ / NOTES:
+/ /     Each edge is tested at the corner of the tile furthest inside it, a tile near a corner of the triangle may
+/ /     still be kept though it's outside, it only costs the time it takes to find nothing to fill.
+/*/
+
+static bool
+__touchesTile (const RASTERTRIANGLE *pTriangle, int x0, int y0, int x1, int y1)
+{
+    int k = 0;
+
+    for(k = 0; k < 3; k++)
+    {
+        const float *e = pTriangle->afEdges[k];
+        float x = (e[0] > 0.0f) ? (float)x1 : (float)x0, y = (e[1] > 0.0f) ? (float)y1 : (float)y0;
+
+        if(((e[0] * x) + (e[1] * y) + e[2]) < 0.0f) return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
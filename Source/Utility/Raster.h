@@ -0,0 +1,21 @@
+#if !defined (RASTER_H_5F0C2A86_B41D_4E37_9A6C_E82D17F349B0_)
+#define RASTER_H_5F0C2A86_B41D_4E37_9A6C_E82D17F349B0_
+
+#pragma once  // in case the compiler supports it
+
+// layout of a vertex the software rasterizer draws, the same as an interleaved vertex array fed to the GL
+typedef struct
+{
+    float afPosition[3];            // object space position
+    float afNormal[3];              // normal, it's lit by the light __initRender() sets up
+    BYTE  acColor[4];               // diffuse color (as GL_COLOR_MATERIAL would use it)
+
+}  RASTERVERTEX;
+
+bool InitRaster    (void);
+void DestroyRaster (void);
+bool BeginRaster   (unsigned int nWidth, unsigned int nHeight, const MAT4 *pProjection);
+void DrawRaster    (const MAT4 *pModelView, const RASTERVERTEX *pVertices, const BYTE *pIndices, unsigned int nIndices);
+void EndRaster     (void);
+
+#endif  // RASTER_H
@@ -0,0 +1,248 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\Graphical.h"      // graphical utility routines
+#include "Utility\State.h"          // render state routines
+#include "Utility\Scaling.h"        // include for this file
+#include <math.h>                   // sqrt()
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////// DYNAMIC RESOLUTION ROUTINES ////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / A frame's cost mostly grows with the number of pixels it fills, so when frames take longer than the budget they
+/ / are drawn into a framebuffer object at a fraction of the output's width and height and then stretched over the
+/ / output with glBlitFramebuffer(). The target is as large as the output and only the corner a frame is drawn in
+/ / is used (the viewport and the scissor box keep the clear and the drawing inside it), so changing the scale
+/ / never reallocates anything. The cost is smoothed over the last few frames, the scale only changes once it's
+/ / out of a band below the budget, and never by more than SCALE_STEP at a time, then it's left alone for a few
+/ / frames while the GPU timings of the new scale come back, so it settles rather than hunting up and down.
+/*/
+
+#define SCALE_SMOOTHING 0.2         // weight of the newest frame in the smoothed cost
+#define SCALE_HEADROOM  0.8         // fraction of the budget a frame must cost less than before the scale goes up
+#define SCALE_AIM       0.9         // fraction of the budget the scale is picked to bring the cost to
+#define SCALE_STEP      0.1f        // most the scale changes by at once
+#define SCALE_SETTLE    8           // frames the scale is left alone after it changed (the GPU timings lag a few frames)
+
+// local variables (the target is a framebuffer object, so it belongs to the render thread's RC)
+static __declspec(thread) OFFSCREEN    _Target      = {0};     // where the frames are drawn (nothing if scaling is off)
+static __declspec(thread) GLuint       _nOutput     = 0;       // framebuffer the frames are stretched into (zero for the window)
+static __declspec(thread) double       _dBudget     = 0.0;     // seconds a frame may take
+static __declspec(thread) double       _dCost       = 0.0;     // smoothed cost of the recent frames in seconds (zero before the first)
+static __declspec(thread) float        _fScale      = 1.0f;    // fraction of the output's width and height the frames are drawn at
+static __declspec(thread) unsigned int _nSettle     = 0;       // frames left before the scale may change again
+static __declspec(thread) unsigned int _nWidth      = 0;       // width of the output the current frame is stretched over
+static __declspec(thread) unsigned int _nHeight     = 0;       // height of the output the current frame is stretched over
+static __declspec(thread) unsigned int _nDrawWidth  = 0;       // width the current frame is drawn at
+static __declspec(thread) unsigned int _nDrawHeight = 0;       // height the current frame is drawn at
+static __declspec(thread) bool         _bScaling    = false;   // flag to indicate the frames are drawn through the target
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dBudget = seconds a frame may take, the resolution drops to keep the frames inside it
+/ /     nOutput = framebuffer the finished frames are stretched into, zero for the window
+/ /
+/ / PURPOSE:
+/ /     Turns dynamic resolution on for the render thread. Returns false if the budget is zero or the GL can't
+/ /     stretch one framebuffer into another, every frame is then drawn straight into the output at full size.
+/ /
+/ / NOTES:
+/ /     This needs to be called after there's a valid RC (Render Context). The target itself is only created by
+/ /     the first BeginScaledFrame(), once the size of the output is known.
+/*/
+
+bool
+InitScaling (double dBudget, GLuint nOutput)
+{
+    if(_bScaling) return true;
+    if((dBudget <= 0.0) || !HasCapability(CAP_FRAMEBUFFERS) || !HasCapability(CAP_FRAMEBUFFER_BLIT)) return false;
+
+    memset(&_Target, 0, sizeof(OFFSCREEN));
+    _nOutput = nOutput;
+    _dBudget = dBudget;
+    _dCost = 0.0;
+    _fScale = 1.0f;
+    _nSettle = 0;
+    _bScaling = true;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Deletes the target and turns dynamic resolution off, the output is bound again for whatever comes after.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, while the RC is still current.
+/*/
+
+void
+DestroyScaling (void)
+{
+    if(!_bScaling) return;
+
+    // destroying the target leaves the window bound, which may not be the output
+    DestroyOffscreen(&_Target);
+    glBindFramebuffer(GL_FRAMEBUFFER, _nOutput);
+
+    _fScale = 1.0f;
+    _bScaling = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nWidth = width of the output in pixels
+/ /     nHeight = height of the output in pixels
+/ /     pnWidth = receives the width the frame is to be drawn at
+/ /     pnHeight = receives the height the frame is to be drawn at
+/ /
+/ / PURPOSE:
+/ /     Gets the frame ready to be drawn at the current scale: the target is bound, and the viewport and the
+/ /     scissor box are set to the part of it the frame takes up. If the scaling is off this only hands back
+/ /     the output's size.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, before the frame is cleared. The projection
+/ /     doesn't change, as the frame keeps the output's aspect ratio.
+/*/
+
+void
+BeginScaledFrame (unsigned int nWidth, unsigned int nHeight, unsigned int *pnWidth, unsigned int *pnHeight)
+{
+    *pnWidth = nWidth;
+    *pnHeight = nHeight;
+    if(!_bScaling || (nWidth == 0) || (nHeight == 0)) return;
+
+    // the target follows the size of the output, and leaves itself bound when it's made
+    if((_Target.nWidth != nWidth) || (_Target.nHeight != nHeight))
+    {
+        DestroyOffscreen(&_Target);
+        if(!CreateOffscreen(&_Target, nWidth, nHeight))
+        {
+            // there's nothing to draw into, so every frame from here on goes straight to the output
+            glBindFramebuffer(GL_FRAMEBUFFER, _nOutput);
+            _fScale = 1.0f;
+            _bScaling = false;
+            return;
+        }
+    }
+    else
+        glBindFramebuffer(GL_FRAMEBUFFER, _Target.nFrameBuffer);
+
+    _nWidth = nWidth;
+    _nHeight = nHeight;
+    _nDrawWidth = (unsigned int)((nWidth * _fScale) + 0.5f);
+    _nDrawHeight = (unsigned int)((nHeight * _fScale) + 0.5f);
+    if(_nDrawWidth == 0) _nDrawWidth = 1;
+    if(_nDrawHeight == 0) _nDrawHeight = 1;
+
+    // glClear() ignores the viewport, only the scissor box keeps it from clearing the unused part of the target
+    glViewport(0, 0, _nDrawWidth, _nDrawHeight);
+    glScissor(0, 0, _nDrawWidth, _nDrawHeight);
+    SetEnabled(GL_SCISSOR_TEST, true);
+
+    *pnWidth = _nDrawWidth;
+    *pnHeight = _nDrawHeight;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Stretches the frame over the output and leaves the output bound, so it can be presented.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once the frame has been drawn.
+/*/
+
+void
+EndScaledFrame (void)
+{
+    if(!_bScaling || (_nWidth == 0) || (_nHeight == 0)) return;
+
+    // the scissor box would clip the blit as well, and the output is drawn into in full
+    SetEnabled(GL_SCISSOR_TEST, false);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _Target.nFrameBuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _nOutput);
+    glBlitFramebuffer(0, 0, _nDrawWidth, _nDrawHeight, 0, 0, _nWidth, _nHeight, GL_COLOR_BUFFER_BIT, (_fScale < 1.0f) ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, _nOutput);
+    glViewport(0, 0, _nWidth, _nHeight);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     dCost = seconds the frame took, the larger of the time the CPU and the GPU spent on it where both are known
+/ /
+/ / PURPOSE:
+/ /     Picks the scale of the frames that follow from the cost of the recent ones.
+/ /
+/ / NOTES:
+/ /     The cost is assumed to grow with the pixels filled, so the step towards SCALE_AIM of the budget goes by
+/ /     the square root of how far off the cost is (some of it never scales, which the SCALE_STEP cap makes up for).
+/*/
+
+void
+UpdateScaling (double dCost)
+{
+    float fScale = 0.0f;
+
+    if(!_bScaling || (dCost <= 0.0)) return;
+
+    _dCost = (_dCost > 0.0) ? (_dCost + ((dCost - _dCost) * SCALE_SMOOTHING)) : dCost;
+
+    if(_nSettle > 0)
+    {
+        _nSettle--;
+        return;
+    }
+
+    // only step once the cost is out of the band, a frame that is just inside it is left where it is
+    if((_dCost <= _dBudget) && (_dCost >= (_dBudget * SCALE_HEADROOM))) return;
+
+    fScale = _fScale * (float)sqrt((_dBudget * SCALE_AIM) / _dCost);
+    if(fScale > (_fScale + SCALE_STEP)) fScale = _fScale + SCALE_STEP;
+    if(fScale < (_fScale - SCALE_STEP)) fScale = _fScale - SCALE_STEP;
+    if(fScale > 1.0f) fScale = 1.0f;
+    if(fScale < CONFIG_MIN_SCALE) fScale = CONFIG_MIN_SCALE;
+
+    if(fScale != _fScale)
+    {
+        _fScale = fScale;
+        _nSettle = SCALE_SETTLE;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the fraction of the output's width and height the frames are drawn at (1.0 if scaling is off).
+/*/
+
+float
+GetScale (void)
+{
+    return _fScale;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
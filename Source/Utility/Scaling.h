@@ -0,0 +1,13 @@
+#if !defined (SCALING_H_23BF9797_8777_48AA_94C9_9C9D6374EAC0_)
+#define SCALING_H_23BF9797_8777_48AA_94C9_9C9D6374EAC0_
+
+#pragma once  // in case the compiler supports it
+
+bool  InitScaling      (double dBudget, GLuint nOutput);
+void  DestroyScaling   (void);
+void  BeginScaledFrame (unsigned int nWidth, unsigned int nHeight, unsigned int *pnWidth, unsigned int *pnHeight);
+void  EndScaledFrame   (void);
+void  UpdateScaling    (double dCost);
+float GetScale         (void);
+
+#endif  // SCALING_H
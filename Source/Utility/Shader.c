@@ -0,0 +1,499 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\General.h"        // general utility routines
+#include "Utility\Graphical.h"      // graphical utility routines
+#include "Utility\Shader.h"         // include for this file
+#include "Utility\State.h"          // render state routines
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////// SHADER PROGRAM ROUTINES ///////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the cache file starts with this header, a file with the wrong magic or version is ignored (and replaced)
+#define CACHE_MAGIC     0x43534C47      // "GLSC"
+#define CACHE_VERSION   1
+#define MAX_CACHED      64              // most program binaries the cache holds
+
+typedef struct
+{
+    DWORD dwMagic;                  // always CACHE_MAGIC
+    DWORD dwVersion;                // always CACHE_VERSION
+    DWORD dwCount;                  // number of entries that follow
+
+}  CACHEHEADER;
+
+// one linked program in the cache, on disk the binary follows right after the first three fields
+typedef struct
+{
+    ULONGLONG nKey;                 // hash of the driver strings, the sources and the attribute slots
+    DWORD     dwFormat;             // driver specific format of the binary
+    DWORD     dwLength;             // size of the binary in bytes
+    BYTE     *pBinary;              // the binary itself
+
+}  CACHEENTRY, *PCACHEENTRY;
+
+// the fixed-function pipeline as __initRender() sets it up: smooth shading and a single positional light
+// (GL_LIGHT0) lighting the diffuse color, which comes from the vertex color through GL_COLOR_MATERIAL
+static const char *_szLightingVertex =
+    "#version 120\n"
+    "varying vec4 Color;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 vEye = gl_ModelViewMatrix * gl_Vertex;\n"
+    "    vec3 vNormal = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "    vec3 vLight = normalize(gl_LightSource[0].position.xyz - (vEye.xyz * gl_LightSource[0].position.w));\n"
+    "    Color = gl_FrontLightModelProduct.sceneColor + (gl_LightSource[0].diffuse * gl_Color * max(dot(vNormal, vLight), 0.0));\n"
+    "    Color.a = gl_Color.a;\n"
+    "    gl_Position = gl_ProjectionMatrix * vEye;\n"
+    "}\n";
+
+static const char *_szLightingFragment =
+    "#version 120\n"
+    "varying vec4 Color;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = Color;\n"
+    "}\n";
+
+// local function prototypes
+static GLuint      __compileShader (GLenum eType, const char *szSource);
+static ULONGLONG   __hash          (ULONGLONG nHash, const void *pData, size_t nSize);
+static void        __readCache     (void);
+static void        __storeBinary   (GLuint nProgram, ULONGLONG nKey);
+static void        __writeCache    (void);
+
+// local variables (programs belong to the RC they were linked in, so every render thread keeps its own)
+static __declspec(thread) bool        _bReady     = false;     // true if programs can be built at all
+static __declspec(thread) bool        _bBinaries  = false;     // true if linked programs can be saved and loaded as binaries
+static __declspec(thread) bool        _bDirty     = false;     // true if the cache has changed since it was read
+static __declspec(thread) ULONGLONG   _nDriver    = 0;         // hash of the driver strings, every key starts from it
+static __declspec(thread) GLuint      _nLighting  = 0;         // name of the program that stands in for the fixed-function lighting
+static __declspec(thread) CACHEENTRY  _aCache[MAX_CACHED];     // program binaries read from the cache file or linked this run
+static __declspec(thread) unsigned int _nCached   = 0;         // number of entries in use
+static __declspec(thread) TCHAR       _szCache[MAX_PATH];      // file the cache is read from and written to (empty if none)
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szCacheFile = file to keep linked program binaries in between runs (NULL or empty for none)
+/ /
+/ / PURPOSE:
+/ /     Reads the program binary cache and builds the program that stands in for the fixed-function lighting.
+/ /     Returns true if programs can be built, which requires GL 2.0 shaders.
+/ /
+/ / NOTES:
+/ /     The cache needs GL 4.1 or ARB_get_program_binary, and a driver that offers at least one binary format.
+/ /     Every key includes the vendor, renderer and version strings, so a new driver or GPU simply misses.
+/ /     This must be called in the context of the render thread, once, after the RC is made current.
+/*/
+
+bool
+InitShaders (LPCTSTR szCacheFile)
+{
+    static const GLenum eStrings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    GLint nFormats = 0;
+    int i = 0;
+
+    if(_bReady) return true;
+
+    // only attempt this if the extensions are supported (shaders came in with 2.0)
+    if(!HasCapability(CAP_SHADERS)) return false;
+
+    _bReady = true;
+
+    // the binary cache is optional, without it every program is compiled every run
+    if((szCacheFile != NULL) && (szCacheFile[0] != _T('\0')) && HasCapability(CAP_PROGRAM_BINARIES))
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats);
+
+        if(nFormats > 0)
+        {
+            // a binary is only good for the driver that made it, so the driver is part of every key
+            _nDriver = 14695981039346656037ULL;
+            for(i = 0; i < (int)(sizeof(eStrings) / sizeof(eStrings[0])); i++)
+            {
+                const char *szString = (const char *)glGetString(eStrings[i]);
+                if(szString != NULL) _nDriver = __hash(_nDriver, szString, strlen(szString) + 1);
+            }
+
+            _tcscpy_s(_szCache, STRING_SIZE(_szCache), szCacheFile);
+            _bBinaries = true;
+            __readCache();
+        }
+    }
+
+    _nLighting = LoadProgram(_szLightingVertex, _szLightingFragment, NULL, 0);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Writes the program binary cache back if programs were linked this run, and releases it along with
+/ /     the lighting program.
+/ /
+/ / NOTES:
+/ /     Programs returned by LoadProgram() must be freed by whoever loaded them before this is called.
+/ /     This must be called in the context of the render thread, before the RC is destroyed.
+/*/
+
+void
+DestroyShaders (void)
+{
+    unsigned int i = 0;
+
+    if(!_bReady) return;
+
+    UseProgram(0);
+    FreeProgram(_nLighting);
+    _nLighting = 0;
+
+    if(_bDirty) __writeCache();
+
+    for(i = 0; i < _nCached; i++) free(_aCache[i].pBinary);
+    memset(_aCache, 0, sizeof(_aCache));
+    _nCached = 0;
+
+    _szCache[0] = _T('\0');
+    _bReady = _bBinaries = _bDirty = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns true if InitShaders() succeeded, so programs can be built.
+/*/
+
+bool
+IsShadingReady (void)
+{
+    return _bReady;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     szVertex = GLSL source code of the vertex shader
+/ /     szFragment = GLSL source code of the fragment shader
+/ /     pSlots = array of attributes to bind to fixed slots before linking (may be NULL)
+/ /     nSlots = number of elements in the array
+/ /
+/ / PURPOSE:
+/ /     Returns the name of a linked program made of the two shaders, or zero if it can't be built. If the
+/ /     cache holds a binary of the same program for this driver it's loaded as is, which skips compiling
+/ /     and linking, otherwise the program is built from source and its binary is added to the cache.
+/ /
+/ / NOTES:
+/ /     A driver may refuse a binary it made itself (after an update, say), the program is rebuilt then.
+/ /     This must be called in the context of the render thread.
+/*/
+
+GLuint
+LoadProgram (const char *szVertex, const char *szFragment, const ATTRIBSLOT *pSlots, unsigned int nSlots)
+{
+    ULONGLONG nKey = _nDriver;
+    GLuint nProgram = 0, nVertex = 0, nFragment = 0;
+    GLint nStatus = GL_FALSE;
+    unsigned int i = 0;
+
+    if(!_bReady || (szVertex == NULL) || (szFragment == NULL)) return 0;
+
+    if(_bBinaries)
+    {
+        nKey = __hash(nKey, szVertex, strlen(szVertex) + 1);
+        nKey = __hash(nKey, szFragment, strlen(szFragment) + 1);
+
+        for(i = 0; (pSlots != NULL) && (i < nSlots); i++)
+        {
+            nKey = __hash(nKey, pSlots[i].szName, strlen(pSlots[i].szName) + 1);
+            nKey = __hash(nKey, &pSlots[i].nSlot, sizeof(pSlots[i].nSlot));
+        }
+
+        for(i = 0; i < _nCached; i++)
+        {
+            if(_aCache[i].nKey != nKey) continue;
+
+            nProgram = glCreateProgram();
+            glProgramBinary(nProgram, _aCache[i].dwFormat, _aCache[i].pBinary, _aCache[i].dwLength);
+            glGetProgramiv(nProgram, GL_LINK_STATUS, &nStatus);
+
+            if(nStatus == GL_TRUE) return nProgram;
+
+            // the driver wants nothing to do with it, so drop it and build the program the long way
+            glDeleteProgram(nProgram);
+            nProgram = 0;
+
+            free(_aCache[i].pBinary);
+            _aCache[i] = _aCache[--_nCached];
+            _bDirty = true;
+            break;
+        }
+    }
+
+    nVertex = __compileShader(GL_VERTEX_SHADER, szVertex);
+    nFragment = __compileShader(GL_FRAGMENT_SHADER, szFragment);
+
+    if((nVertex != 0) && (nFragment != 0))
+    {
+        nProgram = glCreateProgram();
+        glAttachShader(nProgram, nVertex);
+        glAttachShader(nProgram, nFragment);
+
+        for(i = 0; (pSlots != NULL) && (i < nSlots); i++)
+            glBindAttribLocation(nProgram, pSlots[i].nSlot, pSlots[i].szName);
+
+        // ask the driver to keep the binary around, some only do if asked before linking
+        if(_bBinaries) glProgramParameteri(nProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(nProgram);
+
+        glGetProgramiv(nProgram, GL_LINK_STATUS, &nStatus);
+        if(nStatus != GL_TRUE)
+        {
+            glDeleteProgram(nProgram);
+            nProgram = 0;
+        }
+        else if(_bBinaries)
+            __storeBinary(nProgram, nKey);
+    }
+
+    // the program keeps what it needs, so the shaders can go now
+    if(nVertex != 0) glDeleteShader(nVertex);
+    if(nFragment != 0) glDeleteShader(nFragment);
+
+    return nProgram;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nProgram = name of a program returned by LoadProgram() (zero is ignored)
+/ /
+/ / PURPOSE:
+/ /     Deletes a program.
+/*/
+
+void
+FreeProgram (GLuint nProgram)
+{
+    if(_bReady && (nProgram != 0)) glDeleteProgram(nProgram);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the name of the program that lights geometry the same way the fixed-function setup of
+/ /     __initRender() does, or zero if there isn't one. The diffuse color comes from the vertex color.
+/*/
+
+GLuint
+GetLightingProgram (void)
+{
+    return _nLighting;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nProgram = name of the program to draw with, zero goes back to the fixed-function pipeline
+/ /
+/ / PURPOSE:
+/ /     Makes a program current, this does nothing if programs aren't available or it's current already.
+/*/
+
+void
+UseProgram (GLuint nProgram)
+{
+    if(_bReady) SetProgram(nProgram);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eType = type of the shader to create (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)
+/ /     szSource = GLSL source code of the shader
+/ /
+/ / PURPOSE:
+/ /     Creates and compiles a shader, returns its name or zero if the compile failed.
+/*/
+
+static GLuint
+__compileShader (GLenum eType, const char *szSource)
+{
+    GLuint nShader = glCreateShader(eType);
+    GLint nStatus = GL_FALSE;
+
+    glShaderSource(nShader, 1, &szSource, NULL);
+    glCompileShader(nShader);
+    glGetShaderiv(nShader, GL_COMPILE_STATUS, &nStatus);
+
+    if(nStatus != GL_TRUE)
+    {
+        glDeleteShader(nShader);
+        nShader = 0;
+    }
+
+    return nShader;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nHash = hash so far (start with the FNV offset basis)
+/ /     pData = bytes to add to the hash
+/ /     nSize = number of bytes
+/ /
+/ / PURPOSE:
+/ /     Returns the 64 bit FNV-1a hash of the bytes, continued from nHash.
+/*/
+
+static ULONGLONG
+__hash (ULONGLONG nHash, const void *pData, size_t nSize)
+{
+    const BYTE *pBytes = (const BYTE *)pData;
+    size_t i = 0;
+
+    for(i = 0; i < nSize; i++)
+    {
+        nHash ^= pBytes[i];
+        nHash *= 1099511628211ULL;
+    }
+
+    return nHash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Reads the program binaries in the cache file into memory. A missing, foreign or damaged file leaves
+/ /     the cache with whatever could be read, it gets rewritten on the way out if anything is linked.
+/*/
+
+static void
+__readCache (void)
+{
+    CACHEHEADER Header = {0};
+    FILE *pFile = NULL;
+
+    if(_tfopen_s(&pFile, _szCache, _T("rb")) != 0) return;
+
+    if((fread(&Header, sizeof(Header), 1, pFile) == 1) && (Header.dwMagic == CACHE_MAGIC) && (Header.dwVersion == CACHE_VERSION))
+    {
+        while((_nCached < MAX_CACHED) && (_nCached < Header.dwCount))
+        {
+            PCACHEENTRY pEntry = &_aCache[_nCached];
+
+            if((fread(&pEntry->nKey, sizeof(pEntry->nKey), 1, pFile) != 1) ||
+               (fread(&pEntry->dwFormat, sizeof(pEntry->dwFormat), 1, pFile) != 1) ||
+               (fread(&pEntry->dwLength, sizeof(pEntry->dwLength), 1, pFile) != 1) ||
+               (pEntry->dwLength == 0) || ((pEntry->pBinary = (BYTE *)malloc(pEntry->dwLength)) == NULL))
+                break;
+
+            if(fread(pEntry->pBinary, pEntry->dwLength, 1, pFile) != 1)
+            {
+                free(pEntry->pBinary);
+                break;
+            }
+
+            _nCached++;
+        }
+    }
+
+    // anything cut short means the file needs to be written again
+    if(_nCached != Header.dwCount) _bDirty = true;
+    fclose(pFile);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nProgram = name of a freshly linked program
+/ /     nKey = key the program is cached under
+/ /
+/ / PURPOSE:
+/ /     Adds the binary of a program to the cache, it's written to the file by DestroyShaders().
+/*/
+
+static void
+__storeBinary (GLuint nProgram, ULONGLONG nKey)
+{
+    PCACHEENTRY pEntry = NULL;
+    GLint nLength = 0;
+    GLenum eFormat = 0;
+
+    if(_nCached >= MAX_CACHED) return;
+
+    glGetProgramiv(nProgram, GL_PROGRAM_BINARY_LENGTH, &nLength);
+    if(nLength <= 0) return;
+
+    pEntry = &_aCache[_nCached];
+    if((pEntry->pBinary = (BYTE *)malloc(nLength)) == NULL) return;
+
+    glGetProgramBinary(nProgram, nLength, &nLength, &eFormat, pEntry->pBinary);
+
+    pEntry->nKey = nKey;
+    pEntry->dwFormat = eFormat;
+    pEntry->dwLength = nLength;
+
+    _nCached++;
+    _bDirty = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Writes every program binary in the cache to the cache file, replacing what was there.
+/*/
+
+static void
+__writeCache (void)
+{
+    CACHEHEADER Header = {CACHE_MAGIC, CACHE_VERSION, 0};
+    FILE *pFile = NULL;
+    unsigned int i = 0;
+
+    if(_tfopen_s(&pFile, _szCache, _T("wb")) != 0) return;
+
+    Header.dwCount = _nCached;
+    fwrite(&Header, sizeof(Header), 1, pFile);
+
+    for(i = 0; i < _nCached; i++)
+    {
+        fwrite(&_aCache[i].nKey, sizeof(_aCache[i].nKey), 1, pFile);
+        fwrite(&_aCache[i].dwFormat, sizeof(_aCache[i].dwFormat), 1, pFile);
+        fwrite(&_aCache[i].dwLength, sizeof(_aCache[i].dwLength), 1, pFile);
+        fwrite(_aCache[i].pBinary, _aCache[i].dwLength, 1, pFile);
+    }
+
+    fclose(pFile);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,23 @@
+#if !defined (SHADER_H_7F2A9C4E_1B63_4D85_A0F7_E3C58B2D9164_)
+#define SHADER_H_7F2A9C4E_1B63_4D85_A0F7_E3C58B2D9164_
+
+#pragma once  // in case the compiler supports it
+
+// generic attribute slot an attribute of a program is bound to before it's linked
+typedef struct
+{
+    const char *szName;             // name of the attribute in the vertex shader
+    GLuint      nSlot;              // slot the attribute is fed from
+
+}  ATTRIBSLOT;
+
+bool   InitShaders        (LPCTSTR szCacheFile);
+void   DestroyShaders     (void);
+bool   IsShadingReady     (void);
+
+GLuint LoadProgram        (const char *szVertex, const char *szFragment, const ATTRIBSLOT *pSlots, unsigned int nSlots);
+void   FreeProgram        (GLuint nProgram);
+GLuint GetLightingProgram (void);
+void   UseProgram         (GLuint nProgram);
+
+#endif  // SHADER_H
@@ -0,0 +1,575 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\State.h"          // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// RENDER STATE ROUTINES ////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / Every state change goes through here, and a shadow copy of the state is kept next to the GL's own, so a call
+/ / that wouldn't change anything never reaches the driver. Each part of the shadow is either known or unknown: a
+/ / new RC starts out with the known defaults the GL specifies, InvalidateState() forgets everything (for when
+/ / something has changed the state behind our back), and an unknown part always lets the next call through.
+/ / Some state is changed by the GL as a side effect: a draw with a color array leaves the current color undefined,
+/ / and GL_COLOR_MATERIAL has the current color overwrite a material, so those are only trusted while the array or
+/ / GL_COLOR_MATERIAL is known to be off.
+/*/
+
+#define UNKNOWN_NAME    ((GLuint)-1)    // a name or enum the GL never uses, so no call is ever dropped against it
+
+// the capabilities, client arrays and buffer targets that are shadowed, anything else is passed straight through
+static const GLenum _eCaps[]    = {GL_BLEND, GL_COLOR_MATERIAL, GL_CULL_FACE, GL_DEPTH_TEST, GL_LIGHTING, GL_LIGHT0, GL_NORMALIZE, GL_TEXTURE_2D};
+static const GLenum _eArrays[]  = {GL_VERTEX_ARRAY, GL_NORMAL_ARRAY, GL_COLOR_ARRAY, GL_TEXTURE_COORD_ARRAY};
+static const GLenum _eTargets[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_PIXEL_UNPACK_BUFFER};
+
+#define STATE_CAPS      (sizeof(_eCaps) / sizeof(_eCaps[0]))
+#define STATE_ARRAYS    (sizeof(_eArrays) / sizeof(_eArrays[0]))
+#define STATE_TARGETS   (sizeof(_eTargets) / sizeof(_eTargets[0]))
+
+// the material colors that are shadowed, for the front and the back faces
+#define MATERIAL_AMBIENT    0
+#define MATERIAL_DIFFUSE    1
+#define MATERIAL_SPECULAR   2
+#define MATERIAL_EMISSION   3
+#define MATERIAL_COLORS     4
+
+// what the GL's state is believed to be
+typedef struct
+{
+    tribool abEnabled[STATE_CAPS];              // capabilities (maybe if unknown)
+    tribool abArrays[STATE_ARRAYS];             // client arrays (maybe if unknown)
+    GLuint  anBuffers[STATE_TARGETS];           // buffer bound to each target
+    GLuint  nProgram;                           // current program
+    GLuint  nTexture;                           // 2D texture bound to the active unit
+    GLenum  eBlendSource;                       // blend factors
+    GLenum  eBlendDest;
+    GLenum  eDepthFunc;                         // depth comparison
+    tribool bDepthMask;                         // depth writes (maybe if unknown)
+    bool    bColor;                             // flag to indicate the current color is known
+    GLubyte acColor[4];                         // current color
+    bool    abMaterial[2][MATERIAL_COLORS];     // flags to indicate a material color is known
+    GLfloat afMaterial[2][MATERIAL_COLORS][4];  // material colors
+
+}  SHADOWSTATE;
+
+// local function prototypes
+static int  __findEnum        (const GLenum *pEnums, unsigned int nEnums, GLenum eValue);
+static void __forgetMaterials (void);
+
+// local variables (the shadow is of the RC current on the calling thread, so every render thread has its own)
+static __declspec(thread) SHADOWSTATE _State;                      // the shadow of the GL's state
+static __declspec(thread) STATESTATS  _Counts = {0};               // calls of the frame being drawn
+static __declspec(thread) STATESTATS  _Frame  = {0};               // calls of the last frame that was finished
+static __declspec(thread) STATESTATS  _Total  = {0};               // calls of every frame finished since the RC was made current
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Sets the shadow to the state every new RC starts out with, and clears the counts.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, right after the RC is made current and before
+/ /     any state is changed.
+/*/
+
+void
+ResetState (void)
+{
+    static const GLfloat afDefaults[MATERIAL_COLORS][4] = {{0.2f, 0.2f, 0.2f, 1.0f}, {0.8f, 0.8f, 0.8f, 1.0f},
+                                                           {0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, 1.0f}};
+    unsigned int i = 0;
+
+    memset(&_State, 0, sizeof(_State));
+
+    // every shadowed capability and array starts out disabled, and nothing is bound
+    for(i = 0; i < STATE_CAPS; i++) _State.abEnabled[i] = no;
+    for(i = 0; i < STATE_ARRAYS; i++) _State.abArrays[i] = no;
+
+    _State.eBlendSource = GL_ONE;
+    _State.eBlendDest   = GL_ZERO;
+    _State.eDepthFunc   = GL_LESS;
+    _State.bDepthMask   = yes;
+
+    _State.bColor = true;
+    memset(_State.acColor, 255, sizeof(_State.acColor));
+
+    for(i = 0; i < MATERIAL_COLORS; i++)
+    {
+        _State.abMaterial[0][i] = _State.abMaterial[1][i] = true;
+        memcpy(_State.afMaterial[0][i], afDefaults[i], sizeof(afDefaults[i]));
+        memcpy(_State.afMaterial[1][i], afDefaults[i], sizeof(afDefaults[i]));
+    }
+
+    memset(&_Counts, 0, sizeof(_Counts));
+    memset(&_Frame, 0, sizeof(_Frame));
+    memset(&_Total, 0, sizeof(_Total));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Forgets the whole shadow, so the next call of each kind goes through whatever it is. This is for when
+/ /     the state has been changed without going through these routines (glPopAttrib() and the like).
+/*/
+
+void
+InvalidateState (void)
+{
+    unsigned int i = 0;
+
+    for(i = 0; i < STATE_CAPS; i++) _State.abEnabled[i] = maybe;
+    for(i = 0; i < STATE_ARRAYS; i++) _State.abArrays[i] = maybe;
+    for(i = 0; i < STATE_TARGETS; i++) _State.anBuffers[i] = UNKNOWN_NAME;
+
+    _State.nProgram = _State.nTexture = UNKNOWN_NAME;
+    _State.eBlendSource = _State.eBlendDest = _State.eDepthFunc = UNKNOWN_NAME;
+    _State.bDepthMask = maybe;
+    _State.bColor = false;
+
+    __forgetMaterials();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Closes the counts of the frame that was just drawn, GetStateStats() reports them from then on.
+/ /
+/ / NOTES:
+/ /     This is called by the render thread once per frame, after the frame has been presented.
+/*/
+
+void
+EndStateFrame (void)
+{
+    _Frame = _Counts;
+    _Frame.nFrames = 1;
+
+    _Total.nIssued += _Counts.nIssued;
+    _Total.nSkipped += _Counts.nSkipped;
+    _Total.nFrames++;
+
+    memset(&_Counts, 0, sizeof(_Counts));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pFrame = pointer to the structure that receives the counts of the last frame (may be NULL)
+/ /     pTotal = pointer to the structure that receives the counts of every frame so far (may be NULL)
+/ /
+/ / PURPOSE:
+/ /     Reports how many state changes went to the GL and how many were dropped.
+/*/
+
+void
+GetStateStats (PSTATESTATS pFrame, PSTATESTATS pTotal)
+{
+    if(pFrame != NULL) *pFrame = _Frame;
+    if(pTotal != NULL) *pTotal = _Total;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Zeroes the counts without touching the shadow, so what is reported from then on starts from the next
+/ /     frame (the warm-up of a benchmark isn't counted this way).
+/*/
+
+void
+ResetStateStats (void)
+{
+    memset(&_Counts, 0, sizeof(_Counts));
+    memset(&_Frame, 0, sizeof(_Frame));
+    memset(&_Total, 0, sizeof(_Total));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eSource = how the incoming color is scaled
+/ /     eDest = how the color already in the framebuffer is scaled
+/ /
+/ / PURPOSE:
+/ /     Sets the blend factors, as glBlendFunc() does.
+/*/
+
+void
+SetBlendFunc (GLenum eSource, GLenum eDest)
+{
+    if((_State.eBlendSource == eSource) && (_State.eBlendDest == eDest))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glBlendFunc(eSource, eDest);
+    _State.eBlendSource = eSource;
+    _State.eBlendDest = eDest;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eTarget = buffer target, e.g. GL_ARRAY_BUFFER
+/ /     nBuffer = name of the buffer object to bind, zero unbinds
+/ /
+/ / PURPOSE:
+/ /     Binds a buffer object to a target, as glBindBuffer() does.
+/ /
+/ / NOTES:
+/ /     This requires buffer objects (CAP_VERTEX_BUFFERS).
+/*/
+
+void
+SetBuffer (GLenum eTarget, GLuint nBuffer)
+{
+    int i = __findEnum(_eTargets, STATE_TARGETS, eTarget);
+
+    if((i >= 0) && (_State.anBuffers[i] == nBuffer))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glBindBuffer(eTarget, nBuffer);
+    if(i >= 0) _State.anBuffers[i] = nBuffer;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eArray = client array, e.g. GL_VERTEX_ARRAY
+/ /     bEnable = flag to indicate if the array is enabled or disabled
+/ /
+/ / PURPOSE:
+/ /     Enables or disables a client array, as glEnableClientState() and glDisableClientState() do.
+/*/
+
+void
+SetClientArray (GLenum eArray, bool bEnable)
+{
+    int i = __findEnum(_eArrays, STATE_ARRAYS, eArray);
+
+    if((i >= 0) && (_State.abArrays[i] == (tribool)bEnable))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    if(bEnable) glEnableClientState(eArray);
+    else        glDisableClientState(eArray);
+
+    if(i >= 0) _State.abArrays[i] = (tribool)bEnable;
+    _Counts.nIssued++;
+
+    // a draw with the color array leaves the current color undefined, so it's only known while it's off
+    if(eArray == GL_COLOR_ARRAY) _State.bColor = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     r, g, b, a = components of the color
+/ /
+/ / PURPOSE:
+/ /     Sets the current color, as glColor4ub() does.
+/ /
+/ / NOTES:
+/ /     This must not be called between glBegin() and glEnd() as the color of a single vertex, that isn't state.
+/*/
+
+void
+SetColor (GLubyte r, GLubyte g, GLubyte b, GLubyte a)
+{
+    int i = __findEnum(_eArrays, STATE_ARRAYS, GL_COLOR_ARRAY);
+
+    if(_State.bColor && (_State.abArrays[i] == no) &&
+       (_State.acColor[0] == r) && (_State.acColor[1] == g) && (_State.acColor[2] == b) && (_State.acColor[3] == a))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glColor4ub(r, g, b, a);
+    _State.acColor[0] = r;
+    _State.acColor[1] = g;
+    _State.acColor[2] = b;
+    _State.acColor[3] = a;
+    _State.bColor = true;
+    _Counts.nIssued++;
+
+    // with GL_COLOR_MATERIAL on (or possibly on) the color just went into a material as well
+    if(_State.abEnabled[__findEnum(_eCaps, STATE_CAPS, GL_COLOR_MATERIAL)] != no) __forgetMaterials();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eFunc = comparison a fragment's depth must pass to be drawn
+/ /
+/ / PURPOSE:
+/ /     Sets the depth comparison, as glDepthFunc() does.
+/*/
+
+void
+SetDepthFunc (GLenum eFunc)
+{
+    if(_State.eDepthFunc == eFunc)
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glDepthFunc(eFunc);
+    _State.eDepthFunc = eFunc;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     bWrite = flag to indicate if the depth buffer is written to
+/ /
+/ / PURPOSE:
+/ /     Enables or disables depth writes, as glDepthMask() does.
+/*/
+
+void
+SetDepthMask (bool bWrite)
+{
+    if(_State.bDepthMask == (tribool)bWrite)
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glDepthMask((GLboolean)bWrite);
+    _State.bDepthMask = (tribool)bWrite;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eCap = capability, e.g. GL_DEPTH_TEST
+/ /     bEnable = flag to indicate if the capability is enabled or disabled
+/ /
+/ / PURPOSE:
+/ /     Enables or disables a capability, as glEnable() and glDisable() do.
+/*/
+
+void
+SetEnabled (GLenum eCap, bool bEnable)
+{
+    int i = __findEnum(_eCaps, STATE_CAPS, eCap);
+
+    if((i >= 0) && (_State.abEnabled[i] == (tribool)bEnable))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    if(bEnable) glEnable(eCap);
+    else        glDisable(eCap);
+
+    if(i >= 0) _State.abEnabled[i] = (tribool)bEnable;
+    _Counts.nIssued++;
+
+    // while GL_COLOR_MATERIAL was on the current color may have overwritten a material
+    if(eCap == GL_COLOR_MATERIAL) __forgetMaterials();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eFace = which faces the material is for, GL_FRONT, GL_BACK or GL_FRONT_AND_BACK
+/ /     eName = which part of the material is set, e.g. GL_DIFFUSE
+/ /     pValues = new value(s) of that part
+/ /
+/ / PURPOSE:
+/ /     Sets a part of the material, as glMaterialfv() does.
+/ /
+/ / NOTES:
+/ /     Only the four material colors are shadowed, and only while GL_COLOR_MATERIAL is known to be off.
+/*/
+
+void
+SetMaterial (GLenum eFace, GLenum eName, const GLfloat *pValues)
+{
+    unsigned int nFirstFace = 0, nLastFace = 0, nFirst = 0, nLast = 0, i = 0, j = 0;
+    bool bShadowed = (_State.abEnabled[__findEnum(_eCaps, STATE_CAPS, GL_COLOR_MATERIAL)] == no);
+    bool bSame = true;
+
+    switch(eFace)
+    {
+        case GL_FRONT:          nFirstFace = 0; nLastFace = 0; break;
+        case GL_BACK:           nFirstFace = 1; nLastFace = 1; break;
+        case GL_FRONT_AND_BACK: nFirstFace = 0; nLastFace = 1; break;
+        default:                bShadowed = false; break;
+    }
+
+    switch(eName)
+    {
+        case GL_AMBIENT:             nFirst = nLast = MATERIAL_AMBIENT; break;
+        case GL_DIFFUSE:             nFirst = nLast = MATERIAL_DIFFUSE; break;
+        case GL_SPECULAR:            nFirst = nLast = MATERIAL_SPECULAR; break;
+        case GL_EMISSION:            nFirst = nLast = MATERIAL_EMISSION; break;
+        case GL_AMBIENT_AND_DIFFUSE: nFirst = MATERIAL_AMBIENT; nLast = MATERIAL_DIFFUSE; break;
+        default:                     bShadowed = false; break;
+    }
+
+    if(bShadowed)
+    {
+        for(i = nFirstFace; i <= nLastFace; i++)
+        {
+            for(j = nFirst; j <= nLast; j++)
+            {
+                if(!_State.abMaterial[i][j] || (memcmp(_State.afMaterial[i][j], pValues, sizeof(_State.afMaterial[i][j])) != 0))
+                    bSame = false;
+            }
+        }
+
+        if(bSame)
+        {
+            _Counts.nSkipped++;
+            return;
+        }
+
+        for(i = nFirstFace; i <= nLastFace; i++)
+        {
+            for(j = nFirst; j <= nLast; j++)
+            {
+                memcpy(_State.afMaterial[i][j], pValues, sizeof(_State.afMaterial[i][j]));
+                _State.abMaterial[i][j] = true;
+            }
+        }
+    }
+
+    glMaterialfv(eFace, eName, pValues);
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nProgram = name of the program to draw with, zero goes back to the fixed-function pipeline
+/ /
+/ / PURPOSE:
+/ /     Makes a program current, as glUseProgram() does.
+/ /
+/ / NOTES:
+/ /     This requires shaders (CAP_SHADERS), it's normally reached through UseProgram().
+/*/
+
+void
+SetProgram (GLuint nProgram)
+{
+    if(_State.nProgram == nProgram)
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glUseProgram(nProgram);
+    _State.nProgram = nProgram;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     eTarget = texture target, e.g. GL_TEXTURE_2D
+/ /     nTexture = name of the texture to bind, zero unbinds
+/ /
+/ / PURPOSE:
+/ /     Binds a texture to the active texture unit, as glBindTexture() does. Only GL_TEXTURE_2D is shadowed.
+/*/
+
+void
+SetTexture (GLenum eTarget, GLuint nTexture)
+{
+    if((eTarget == GL_TEXTURE_2D) && (_State.nTexture == nTexture))
+    {
+        _Counts.nSkipped++;
+        return;
+    }
+
+    glBindTexture(eTarget, nTexture);
+    if(eTarget == GL_TEXTURE_2D) _State.nTexture = nTexture;
+    _Counts.nIssued++;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pEnums = list of enums to look in
+/ /     nEnums = number of enums in the list
+/ /     eValue = enum to look for
+/ /
+/ / PURPOSE:
+/ /     Returns where an enum is in a list, or -1 if it isn't there (the lists are a handful long).
+/*/
+
+static int
+__findEnum (const GLenum *pEnums, unsigned int nEnums, GLenum eValue)
+{
+    unsigned int i = 0;
+
+    for(i = 0; i < nEnums; i++)
+    {
+        if(pEnums[i] == eValue) return (int)i;
+    }
+
+    return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Marks every material color as unknown.
+/*/
+
+static void
+__forgetMaterials (void)
+{
+    memset(_State.abMaterial, 0, sizeof(_State.abMaterial));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,34 @@
+#if !defined (STATE_H_3E8A1F47_C0B2_4D69_97E5_6B2D0A8C14F3_)
+#define STATE_H_3E8A1F47_C0B2_4D69_97E5_6B2D0A8C14F3_
+
+#pragma once  // in case the compiler supports it
+
+// how many state changes were sent to the GL and how many were dropped for not changing anything
+typedef struct
+{
+    ULONGLONG nIssued;              // calls that reached the GL
+    ULONGLONG nSkipped;             // calls that were dropped
+    ULONGLONG nFrames;              // frames the counts cover
+
+}  STATESTATS, *PSTATESTATS;
+
+void ResetState      (void);
+void InvalidateState (void);
+void EndStateFrame   (void);
+void GetStateStats   (PSTATESTATS pFrame, PSTATESTATS pTotal);
+void ResetStateStats (void);
+
+// these stand in for the GL calls of the same name, an object that may be bound must be unbound through
+// them before it's deleted, as the GL can hand its name out again
+void SetBlendFunc    (GLenum eSource, GLenum eDest);
+void SetBuffer       (GLenum eTarget, GLuint nBuffer);
+void SetClientArray  (GLenum eArray, bool bEnable);
+void SetColor        (GLubyte r, GLubyte g, GLubyte b, GLubyte a);
+void SetDepthFunc    (GLenum eFunc);
+void SetDepthMask    (bool bWrite);
+void SetEnabled      (GLenum eCap, bool bEnable);
+void SetMaterial     (GLenum eFace, GLenum eName, const GLfloat *pValues);
+void SetProgram      (GLuint nProgram);
+void SetTexture      (GLenum eTarget, GLuint nTexture);
+
+#endif  // STATE_H
@@ -0,0 +1,354 @@
+#include "Main\Application.h"       // standard application include
+#include "Utility\Extensions.h"     // GL extension routines
+#include "Utility\State.h"          // render state routines
+#include "Utility\Stream.h"         // include for this file
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////// STREAMING BUFFER ROUTINES ////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / Vertex data that changes every frame is written into one big buffer object used as a ring. Every write gets
+/ / the next region of the ring, so it never lands on bytes a draw from an earlier frame may still be reading, and
+/ / every frame ends with a fence, so before the ring comes back around to a frame's regions it's known whether
+/ / the GL is done with them. Where ARB_buffer_storage is there the buffer is mapped once, persistently and
+/ / coherently, and the regions are written in place: no copies by the driver, and no waits other than those on
+/ / the fences, which only happen if the GL falls a whole ring behind. Otherwise the regions are written into
+/ / system memory and handed over with glBufferSubData(), and the store is orphaned every time the ring wraps, so
+/ / the driver gives us a fresh one rather than waiting for the old one to be read.
+/*/
+
+#define STREAM_ALIGN    64          // alignment of every region, so no two regions share a cache line
+#define MAX_FENCES      8           // most frames the ring keeps in flight
+#define FENCE_TIMEOUT   1000000     // nanoseconds waited on a fence at a time (one millisecond)
+
+// the regions a frame wrote and the fence that tells when the GL is done reading them
+typedef struct
+{
+    GLsync pSync;                   // fence inserted once the frame's draws were sent
+    size_t nBytes;                  // bytes of the ring the frame took, including any skipped at the end to wrap
+
+}  STREAMFENCE;
+
+// local function prototypes
+static bool __retireFence (bool bWait);
+
+// local variables (a ring per render thread, as the buffer object belongs to that thread's RC)
+static __declspec(thread) GLuint       _nBuffer     = 0;       // name of the buffer object used as the ring (zero if there is none)
+static __declspec(thread) size_t       _nSize       = 0;       // bytes in the ring
+static __declspec(thread) size_t       _nHead       = 0;       // where the next region starts
+static __declspec(thread) size_t       _nPending    = 0;       // bytes behind the head the GL may still be reading (persistent only)
+static __declspec(thread) size_t       _nFrameBytes = 0;       // bytes handed out since the last fence
+static __declspec(thread) size_t       _nMapped     = 0;       // where the region last handed out by MapStream() starts
+static __declspec(thread) BYTE        *_pMapping    = NULL;    // the whole ring, mapped for good (NULL if it isn't)
+static __declspec(thread) BYTE        *_pStaging    = NULL;    // system memory regions are written into when the ring isn't mapped
+static __declspec(thread) size_t       _nStaging    = 0;       // bytes in the staging memory
+static __declspec(thread) STREAMFENCE  _Fences[MAX_FENCES];    // frames in flight, oldest first starting at _nFirstFence
+static __declspec(thread) unsigned int _nFirstFence = 0;       // oldest frame in flight
+static __declspec(thread) unsigned int _nFences     = 0;       // number of frames in flight
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nSize = bytes in the ring, enough for a few frames of whatever is streamed each frame
+/ /
+/ / PURPOSE:
+/ /     Creates the buffer object the ring lives in and maps it for good if the GL can keep it mapped while it
+/ /     draws from it. Returns false if there are no buffer objects, MapStream() returns NULL then.
+/ /
+/ / NOTES:
+/ /     A persistent mapping needs both ARB_buffer_storage and ARB_sync, without either of them the ring falls
+/ /     back to glBufferSubData() and orphaning, which IsStreamPersistent() tells apart.
+/ /     This must be called in the context of the render thread, after InitExtensions() has been.
+/*/
+
+bool
+InitStream (size_t nSize)
+{
+    const GLbitfield nFlags = GL_MAP_WRITE_BIT|GL_MAP_PERSISTENT_BIT|GL_MAP_COHERENT_BIT;
+
+    if(_nBuffer != 0) return true;
+    if(!HasCapability(CAP_VERTEX_BUFFERS) || (nSize == 0)) return false;
+
+    _nSize = (nSize + (STREAM_ALIGN - 1)) & ~(size_t)(STREAM_ALIGN - 1);
+    _nHead = _nPending = _nFrameBytes = _nMapped = 0;
+    _nFirstFence = _nFences = 0;
+
+    glGenBuffers(1, &_nBuffer);
+    SetBuffer(GL_ARRAY_BUFFER, _nBuffer);
+
+    if(HasCapability(CAP_BUFFER_STORAGE) && HasCapability(CAP_SYNC))
+    {
+        glBufferStorage(GL_ARRAY_BUFFER, _nSize, NULL, nFlags);
+        _pMapping = (BYTE *)glMapBufferRange(GL_ARRAY_BUFFER, 0, _nSize, nFlags);
+
+        // the store can't be respecified once glBufferStorage() made it, so the fallback needs a buffer of its own
+        if(_pMapping == NULL)
+        {
+            SetBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &_nBuffer);
+            glGenBuffers(1, &_nBuffer);
+            SetBuffer(GL_ARRAY_BUFFER, _nBuffer);
+        }
+    }
+
+    if(_pMapping == NULL) glBufferData(GL_ARRAY_BUFFER, _nSize, NULL, GL_STREAM_DRAW);
+    SetBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Waits for the GL to finish with the ring, then unmaps and deletes it.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, before the RC is destroyed.
+/*/
+
+void
+DestroyStream (void)
+{
+    if(_nBuffer == 0) return;
+
+    while(_nFences > 0) __retireFence(true);
+
+    if(_pMapping != NULL)
+    {
+        SetBuffer(GL_ARRAY_BUFFER, _nBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        _pMapping = NULL;
+    }
+
+    SetBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &_nBuffer);
+    free(_pStaging);
+
+    _nBuffer = 0;
+    _pStaging = NULL;
+    _nSize = _nStaging = 0;
+    _nHead = _nPending = _nFrameBytes = _nMapped = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nSize = bytes to write
+/ /     pOffset = receives where the region starts in the buffer object, to pass to gl*Pointer() once it's bound
+/ /
+/ / PURPOSE:
+/ /     Hands out the next region of the ring and returns where to write it, which must be followed by a call to
+/ /     UnmapStream() before anything is drawn from it. Returns NULL if there is no ring or the region won't fit,
+/ /     the data has to go another way then.
+/ /
+/ / NOTES:
+/ /     Writes go straight into memory the GL reads (usually write combined), so they should be done in order
+/ /     and the region never read back. If the GL is still reading the frames the region needs, this waits for
+/ /     them, which only happens if the ring is too small for the frames in flight.
+/ /     This must be called in the context of the render thread.
+/*/
+
+void *
+MapStream (size_t nSize, GLintptr *pOffset)
+{
+    size_t nSkip = 0;
+    bool bWrap = false;
+
+    if((_nBuffer == 0) || (nSize == 0) || (pOffset == NULL)) return NULL;
+
+    nSize = (nSize + (STREAM_ALIGN - 1)) & ~(size_t)(STREAM_ALIGN - 1);
+    if(nSize > _nSize) return NULL;
+
+    // a region never straddles the end of the ring, whatever is left there is skipped (which may be nothing,
+    // if the last region ended right at the end)
+    bWrap = ((_nHead + nSize) > _nSize);
+    if(bWrap) nSkip = _nSize - _nHead;
+
+    if(_pMapping != NULL)
+    {
+        // wait out the oldest frames until the region is clear of everything the GL may still read
+        while(((_nPending + nSkip + nSize) > _nSize) && (_nFences > 0)) __retireFence(true);
+
+        // the frame being built has filled the ring by itself, there is nothing to wait for
+        if((_nPending + nSkip + nSize) > _nSize) return NULL;
+
+        _nPending += nSkip + nSize;
+    }
+    else
+    {
+        if(nSize > _nStaging)
+        {
+            BYTE *pStaging = (BYTE *)realloc(_pStaging, nSize);
+
+            if(pStaging == NULL) return NULL;
+            _pStaging = pStaging;
+            _nStaging = nSize;
+        }
+
+        // the draws of this frame and those before it are left with the old store
+        if(bWrap)
+        {
+            SetBuffer(GL_ARRAY_BUFFER, _nBuffer);
+            glBufferData(GL_ARRAY_BUFFER, _nSize, NULL, GL_STREAM_DRAW);
+        }
+    }
+
+    if(bWrap) _nHead = 0;
+
+    _nFrameBytes += nSkip + nSize;
+    _nMapped = _nHead;
+    _nHead += nSize;
+
+    *pOffset = (GLintptr)_nMapped;
+    return (_pMapping != NULL) ? (_pMapping + _nMapped) : _pStaging;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nSize = bytes that were written, at most as many as MapStream() was asked for
+/ /
+/ / PURPOSE:
+/ /     Makes the region last handed out by MapStream() visible to the GL.
+/ /
+/ / NOTES:
+/ /     The persistent mapping is coherent, so there is nothing to do, otherwise this is the upload. Either way
+/ /     it leaves GL_ARRAY_BUFFER as it was.
+/ /     This must be called in the context of the render thread.
+/*/
+
+void
+UnmapStream (size_t nSize)
+{
+    if((_nBuffer == 0) || (_pMapping != NULL) || (nSize == 0)) return;
+
+    SetBuffer(GL_ARRAY_BUFFER, _nBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)_nMapped, (GLsizeiptr)nSize, _pStaging);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Fences the regions handed out since the last call, so the ring can tell when they may be written again,
+/ /     and lets go of the frames the GL has already finished with.
+/ /
+/ / NOTES:
+/ /     This must be called in the context of the render thread, once a frame, after its draws were sent.
+/*/
+
+void
+EndStreamFrame (void)
+{
+    STREAMFENCE *pFence = NULL;
+
+    if(_pMapping == NULL) return;
+
+    // nothing blocks here, a frame that isn't done yet is left for MapStream() to wait on if it comes to that
+    while((_nFences > 0) && __retireFence(false));
+
+    if(_nFrameBytes == 0) return;
+    if(_nFences == MAX_FENCES) __retireFence(true);
+
+    pFence = &_Fences[(_nFirstFence + _nFences) % MAX_FENCES];
+    pFence->pSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pFence->nBytes = _nFrameBytes;
+    _nFrameBytes = 0;
+
+    if(pFence->pSync != NULL) _nFences++;
+    else
+    {
+        // without a fence there is no telling when the GL is done, so wait for it to be done with everything
+        glFinish();
+        _nPending -= pFence->nBytes;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the name of the buffer object the ring lives in (zero if there is none), it has to be bound to
+/ /     GL_ARRAY_BUFFER to draw from the offsets MapStream() hands out.
+/*/
+
+GLuint
+GetStreamBuffer (void)
+{
+    return _nBuffer;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns true if the ring is mapped persistently, false if it's written with glBufferSubData() (or if there
+/ /     is no ring at all).
+/*/
+
+bool
+IsStreamPersistent (void)
+{
+    return (_pMapping != NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     bWait = true to wait for the GL to finish with the oldest frame, false to only check whether it has
+/ /
+/ / PURPOSE:
+/ /     Gives the regions of the oldest frame in flight back to the ring once the GL is done with them. Returns
+/ /     false if the GL is still reading them (only when not waiting).
+/ /
+/ / NOTES:
+/ /     A failed wait means the GL won't be reading anything anymore (the context is lost, say), so the frame is
+/ /     let go then too.
+/*/
+
+static bool
+__retireFence (bool bWait)
+{
+    STREAMFENCE *pFence = &_Fences[_nFirstFence];
+    GLenum eResult = GL_TIMEOUT_EXPIRED;
+
+    if(_nFences == 0) return false;
+
+    if(!bWait) eResult = glClientWaitSync(pFence->pSync, 0, 0);
+    else
+    {
+        // the flush makes sure the fence itself has been sent, or the wait could last forever
+        while((eResult = glClientWaitSync(pFence->pSync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT)) == GL_TIMEOUT_EXPIRED);
+    }
+
+    if(eResult == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(pFence->pSync);
+    _nPending -= pFence->nBytes;
+    _nFirstFence = (_nFirstFence + 1) % MAX_FENCES;
+    _nFences--;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
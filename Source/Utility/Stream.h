@@ -0,0 +1,14 @@
+#if !defined (STREAM_H_8A3F61C2_0D5B_4E97_A1C4_6B29E7D3F05A_)
+#define STREAM_H_8A3F61C2_0D5B_4E97_A1C4_6B29E7D3F05A_
+
+#pragma once  // in case the compiler supports it
+
+bool   InitStream         (size_t nSize);
+void   DestroyStream      (void);
+void  *MapStream          (size_t nSize, GLintptr *pOffset);
+void   UnmapStream        (size_t nSize);
+void   EndStreamFrame     (void);
+GLuint GetStreamBuffer    (void);
+bool   IsStreamPersistent (void);
+
+#endif  // STREAM_H
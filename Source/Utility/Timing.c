@@ -0,0 +1,304 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\Timing.h"     // include for this file
+#include <mmsystem.h>           // multimedia timer resolution
+
+// the time stamp counter can only be read on x86 and x64, anything else uses the performance counter
+#if defined(_M_IX86) || defined(_M_X64)
+    #define CLOCK_TSC_READABLE
+    #include <intrin.h>         // __rdtsc(), __cpuid()
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////// TIMING ROUTINES ///////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / The clock counts nanoseconds from the first time it's read, as a 64-bit integer that never wraps (it would take
+/ / over 500 years) and never loses precision however long the machine has been up. Where the CPU's time stamp counter
+/ / is invariant (it ticks at the same rate in every power state, and is kept in step across the cores) it's read
+/ / directly, which costs a few nanoseconds rather than a call into the OS; its rate isn't reported anywhere, so the
+/ / first read measures it against the performance counter for CLOCK_CALIBRATION seconds. Otherwise the performance
+/ / counter is used, its frequency is fixed at boot so it's only asked for once. Everything is set up once, by
+/ / whichever thread gets there first, and never changes after that, so any thread may read the clock at any time.
+/*/
+
+// how long the time stamp counter is measured against the performance counter, the longer the more precisely
+// its rate is known, this is good for a few parts per million (much less than a microsecond a frame)
+#define CLOCK_CALIBRATION   0.025
+
+// high resolution waitable timers (Windows 10 1803 and up), this is not in older Windows SDK headers
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// how the clock turns a reading of its source into nanoseconds
+typedef struct
+{
+    CLOCKSOURCE nSource;            // what the clock reads
+    ULONGLONG   nBase;              // reading of the source the clock counts from
+    ULONGLONG   nFrequency;         // performance counter ticks per second
+    double      dScale;             // nanoseconds per time stamp counter tick
+
+}  CLOCK;
+
+// local function prototypes
+static void __setClock (void);
+
+// local variables
+static CLOCK _Clock = {CLOCK_QPC, 0, 0, 0.0};   // set up by the first read, read only after that
+static volatile LONG _nClockSet = 0;            // 0 until the clock is set up, 1 while it is, 2 after
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the number of nanoseconds since the clock was first read. It never goes backwards, and
+/ /     readings taken on different threads can be compared with each other.
+/ /
+/ / NOTES:
+/ /     This is safe to call from any thread, the first call takes CLOCK_CALIBRATION seconds if the time
+/ /     stamp counter is used (every other thread that reads the clock meanwhile waits for it).
+/*/
+
+ULONGLONG
+GetClockTime (void)
+{
+    LARGE_INTEGER liCount = {0};
+    ULONGLONG nTicks = 0;
+
+    if(_nClockSet != 2) __setClock();
+
+    #ifdef CLOCK_TSC_READABLE
+        if(_Clock.nSource == CLOCK_TSC)
+        {
+            // another core's counter may be a tick or two behind the one that set the clock up
+            nTicks = __rdtsc();
+            return (nTicks > _Clock.nBase) ? (ULONGLONG)((double)(nTicks - _Clock.nBase) * _Clock.dScale) : 0;
+        }
+    #endif
+
+    QueryPerformanceCounter(&liCount);
+    nTicks = (ULONGLONG)liCount.QuadPart - _Clock.nBase;
+
+    // the whole seconds and the rest are scaled apart, so this can't overflow however long the clock runs
+    return ((nTicks / _Clock.nFrequency) * 1000000000) + (((nTicks % _Clock.nFrequency) * 1000000000) / _Clock.nFrequency);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the time since the clock was first read, in seconds. Typically used for timing animations,
+/ /     the clock starts at zero so a double keeps it to well under a nanosecond for the first few days.
+/ /
+/ / NOTES:
+/ /     This is safe to call from any thread.
+/*/
+
+double
+GetClockSeconds (void)
+{
+    return (double)GetClockTime() / 1000000000.0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns what the clock reads the time from, e.g. so a benchmark can report it.
+/*/
+
+CLOCKSOURCE
+GetClockSource (void)
+{
+    if(_nClockSet != 2) __setClock();
+    return _Clock.nSource;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pLimiter = pointer to the structure that receives the limiter
+/ /     nFPS = number of frames per second to limit to (zero means no limit)
+/ /
+/ / PURPOSE:
+/ /     Sets up a frame limiter for WaitFrameLimiter(). Returns false if no timer could be created, the
+/ /     limiter then still works but spins for the whole wait.
+/ /
+/ / NOTES:
+/ /     A high resolution timer is used if the system has one. Otherwise a standard one is used and the
+/ /     system timer resolution is raised to a millisecond while the limiter exists, since by default a
+/ /     standard timer can wake up as much as 15.6 ms late.
+/*/
+
+bool
+CreateFrameLimiter (PLIMITER pLimiter, unsigned int nFPS)
+{
+    if(pLimiter == NULL) return false;
+
+    memset(pLimiter, 0, sizeof(LIMITER));
+    if(nFPS == 0) return true;
+
+    pLimiter->dPeriod = 1.0 / nFPS;
+    pLimiter->hTimer = CreateWaitableTimerEx(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    if(pLimiter->hTimer != NULL)
+    {
+        // a high resolution timer wakes up within half a millisecond or so
+        pLimiter->dSpin = 0.001;
+    }
+    else
+    {
+        pLimiter->hTimer = CreateWaitableTimer(NULL, TRUE, NULL);
+        pLimiter->bPeriod = (timeBeginPeriod(1) == TIMERR_NOERROR);
+        pLimiter->dSpin = 0.002;
+    }
+
+    return (pLimiter->hTimer != NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pLimiter = limiter to release
+/ /
+/ / PURPOSE:
+/ /     Releases the timer of a limiter and restores the system timer resolution, if it was raised.
+/*/
+
+void
+DestroyFrameLimiter (PLIMITER pLimiter)
+{
+    if(pLimiter == NULL) return;
+
+    if(pLimiter->hTimer != NULL) CloseHandle(pLimiter->hTimer);
+    if(pLimiter->bPeriod) timeEndPeriod(1);
+
+    memset(pLimiter, 0, sizeof(LIMITER));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pLimiter = limiter to wait on
+/ /
+/ / PURPOSE:
+/ /     Waits until the next frame is due. This sleeps on the timer until shortly before the deadline and
+/ /     spins only for what's left, so the deadline is met precisely without keeping a core busy.
+/ /
+/ / NOTES:
+/ /     The deadlines are a fixed period apart, rather than a period after the wait ended, so the frame rate
+/ /     doesn't drift. If the loop has fallen more than a frame behind the schedule starts over, rather than
+/ /     rushing through frames to catch up. This should be called once per frame, after it was presented.
+/*/
+
+void
+WaitFrameLimiter (PLIMITER pLimiter)
+{
+    double dNow = 0.0, dLeft = 0.0;
+    LARGE_INTEGER liDue = {0};
+
+    if((pLimiter == NULL) || (pLimiter->dPeriod <= 0.0)) return;
+
+    dNow = GetClockSeconds();
+    if((pLimiter->dNext <= 0.0) || (dNow > (pLimiter->dNext + pLimiter->dPeriod))) pLimiter->dNext = dNow;
+
+    // sleep through most of the wait, a negative due time is relative and in 100 nanosecond units
+    dLeft = pLimiter->dNext - dNow;
+    if((dLeft > pLimiter->dSpin) && (pLimiter->hTimer != NULL))
+    {
+        liDue.QuadPart = -(LONGLONG)((dLeft - pLimiter->dSpin) * 10000000.0);
+        if(SetWaitableTimer(pLimiter->hTimer, &liDue, 0, NULL, NULL, FALSE)) WaitForSingleObject(pLimiter->hTimer, INFINITE);
+    }
+
+    // then spin for the rest, letting the other hardware thread of the core have it in the meantime
+    while(GetClockSeconds() < pLimiter->dNext) YieldProcessor();
+
+    pLimiter->dNext += pLimiter->dPeriod;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Picks the source of the clock and works out how to turn its readings into nanoseconds. The first thread
+/ /     to get here does it, any other waits until it's done.
+/ /
+/ / NOTES:
+/ /     The time stamp counter is only trusted if the CPU says it's invariant (CPUID 0x80000007, EDX bit 8).
+/ /     Both counters are read at the start and the end of the calibration, in the same order, so the time it
+/ /     takes to read them cancels out.
+/*/
+
+static void
+__setClock (void)
+{
+    if(InterlockedCompareExchange(&_nClockSet, 1, 0) == 0)
+    {
+        LARGE_INTEGER liFrequency = {0}, liStart = {0};
+
+        // this never fails on XP or later
+        QueryPerformanceFrequency(&liFrequency);
+        QueryPerformanceCounter(&liStart);
+
+        _Clock.nSource = CLOCK_QPC;
+        _Clock.nBase = (ULONGLONG)liStart.QuadPart;
+        _Clock.nFrequency = (liFrequency.QuadPart > 0) ? (ULONGLONG)liFrequency.QuadPart : 1;
+
+        #ifdef CLOCK_TSC_READABLE
+        {
+            LARGE_INTEGER liNow = {0};
+            int anInfo[4] = {0};
+            ULONGLONG nStart = __rdtsc(), nEnd = 0;
+
+            __cpuid(anInfo, 0x80000000);
+            if((unsigned int)anInfo[0] >= 0x80000007) __cpuid(anInfo, 0x80000007);
+            else anInfo[3] = 0;
+
+            if(anInfo[3] & (1 << 8))
+            {
+                do
+                {
+                    YieldProcessor();
+                    QueryPerformanceCounter(&liNow);
+                    nEnd = __rdtsc();
+
+                } while((liNow.QuadPart - liStart.QuadPart) < (LONGLONG)(liFrequency.QuadPart * CLOCK_CALIBRATION));
+
+                if(nEnd > nStart)
+                {
+                    _Clock.dScale = (((double)(liNow.QuadPart - liStart.QuadPart) * 1000000000.0) / (double)liFrequency.QuadPart) / (double)(nEnd - nStart);
+                    _Clock.nBase = nStart;
+                    _Clock.nSource = CLOCK_TSC;
+                }
+            }
+        }
+        #endif
+
+        InterlockedExchange(&_nClockSet, 2);
+    }
+    else
+    {
+        // someone else is setting it up, it won't take long
+        while(_nClockSet != 2) YieldProcessor();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,34 @@
+#if !defined (TIMING_H_C4D81E26_7A93_4F0B_B35E_9E2A6F10D4B8_)
+#define TIMING_H_C4D81E26_7A93_4F0B_B35E_9E2A6F10D4B8_
+
+#pragma once  // in case the compiler supports it
+
+// what GetClockTime() reads the time from, the names are used when reporting it
+typedef enum {CLOCK_QPC = 0, CLOCK_TSC} CLOCKSOURCE;
+#define CLOCK_NAMES {_T("qpc"), _T("tsc")}
+
+// time the code between the two and add it to a frame timing channel (see Profile.h), e.g. BEGIN_TIMED_SCOPE
+// EndRaster(); END_TIMED_SCOPE(PROFILE_RASTER), the pair makes a block of its own so it needs no variables
+#define BEGIN_TIMED_SCOPE           { ULONGLONG nScopeStart_ = GetClockTime();
+#define END_TIMED_SCOPE(nChannel)   RecordFrameTime((nChannel), (double)(GetClockTime() - nScopeStart_) / 1000000000.0); }
+
+// paces a loop to a fixed number of iterations per second without burning a core while it waits
+typedef struct
+{
+    HANDLE hTimer;                  // waitable timer used to sleep through most of the wait
+    double dPeriod;                 // seconds between the start of two frames (zero means no limit)
+    double dSpin;                   // seconds before the deadline the timer hands over to spinning
+    double dNext;                   // time the next frame is due to start (in GetClockSeconds() seconds)
+    bool   bPeriod;                 // flag to indicate the system timer resolution was raised and must be restored
+
+}  LIMITER, *PLIMITER;
+
+ULONGLONG   GetClockTime        (void);
+double      GetClockSeconds     (void);
+CLOCKSOURCE GetClockSource      (void);
+
+bool        CreateFrameLimiter  (PLIMITER pLimiter, unsigned int nFPS);
+void        DestroyFrameLimiter (PLIMITER pLimiter);
+void        WaitFrameLimiter    (PLIMITER pLimiter);
+
+#endif  // TIMING_H
@@ -0,0 +1,640 @@
+#include "Main\Application.h"   // standard application include
+#include "Utility\VecMath.h"    // include for this file
+#include <math.h>               // sqrt(), sin(), cos(), etc.
+
+#ifdef MATH_SIMD
+    #include <intrin.h>         // __cpuid()
+    #include <immintrin.h>      // SSE and AVX intrinsics
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////// VECTOR MATH ROUTINES //////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define DEG_TO_RAD  0.017453292519943295
+
+// local function prototypes
+static MATHPATH __mathPath        (void);
+static void     __multiplyScalar  (float *pOut, const float *pA, const float *pB);
+static void     __transformScalar (float *pOut, const float *pM, const float *pV);
+
+// local variables
+static MATHPATH _nPath = MATH_PATHS;    // kernels the batch routines use (MATH_PATHS until the CPU has been checked)
+static MATHPATH _nBest = MATH_PATHS;    // fastest kernels the CPU supports
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pA, pB = vectors to work with
+/ /
+/ / PURPOSE:
+/ /     Basic three component vector arithmetic, every routine returns its result by value.
+/*/
+
+VEC3
+AddVector3 (const VEC3 *pA, const VEC3 *pB)
+{
+    VEC3 Out = {pA->x + pB->x, pA->y + pB->y, pA->z + pB->z};
+    return Out;
+}
+
+VEC3
+CrossVector3 (const VEC3 *pA, const VEC3 *pB)
+{
+    VEC3 Out = {(pA->y * pB->z) - (pA->z * pB->y), (pA->z * pB->x) - (pA->x * pB->z), (pA->x * pB->y) - (pA->y * pB->x)};
+    return Out;
+}
+
+float
+DotVector3 (const VEC3 *pA, const VEC3 *pB)
+{
+    return (pA->x * pB->x) + (pA->y * pB->y) + (pA->z * pB->z);
+}
+
+VEC3
+NormalizeVector3 (const VEC3 *pV)
+{
+    VEC3 Out = *pV;
+    float fLength = (float)sqrt(DotVector3(pV, pV));
+
+    // a zero length vector has no direction, so it's returned as is
+    if(fLength > 0.0f)
+    {
+        Out.x /= fLength;
+        Out.y /= fLength;
+        Out.z /= fLength;
+    }
+
+    return Out;
+}
+
+VEC3
+SubtractVector3 (const VEC3 *pA, const VEC3 *pB)
+{
+    VEC3 Out = {pA->x - pB->x, pA->y - pB->y, pA->z - pB->z};
+    return Out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pA, pB = quaternions to combine, the result applies pB first and then pA
+/ /
+/ / PURPOSE:
+/ /     Returns the product of two quaternions.
+/*/
+
+QUAT
+MultiplyQuat (const QUAT *pA, const QUAT *pB)
+{
+    QUAT Out;
+
+    Out.x = (pA->w * pB->x) + (pA->x * pB->w) + (pA->y * pB->z) - (pA->z * pB->y);
+    Out.y = (pA->w * pB->y) - (pA->x * pB->z) + (pA->y * pB->w) + (pA->z * pB->x);
+    Out.z = (pA->w * pB->z) + (pA->x * pB->y) - (pA->y * pB->x) + (pA->z * pB->w);
+    Out.w = (pA->w * pB->w) - (pA->x * pB->x) - (pA->y * pB->y) - (pA->z * pB->z);
+
+    return Out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = quaternion to receive the rotation
+/ /     fAngle = angle to rotate by in degrees
+/ /     x, y, z = axis to rotate around (it doesn't need to be normalized)
+/ /
+/ / PURPOSE:
+/ /     Sets a quaternion to the same rotation glRotatef() would make.
+/*/
+
+void
+SetQuatRotation (PQUAT pOut, float fAngle, float x, float y, float z)
+{
+    VEC3 Axis = {x, y, z};
+    double dHalf = (fAngle * DEG_TO_RAD) / 2.0;
+    float fSin = (float)sin(dHalf);
+
+    Axis = NormalizeVector3(&Axis);
+
+    pOut->x = Axis.x * fSin;
+    pOut->y = Axis.y * fSin;
+    pOut->z = Axis.z * fSin;
+    pOut->w = (float)cos(dHalf);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pA, pB = rotations to blend between
+/ /     fT = how far to go from pA (0.0) to pB (1.0)
+/ /
+/ / PURPOSE:
+/ /     Returns the spherical linear interpolation of two rotations, which turns at a constant speed
+/ /     and always takes the short way around.
+/*/
+
+QUAT
+SlerpQuat (const QUAT *pA, const QUAT *pB, float fT)
+{
+    QUAT Out, B = *pB;
+    float fDot = (pA->x * B.x) + (pA->y * B.y) + (pA->z * B.z) + (pA->w * B.w);
+    float fA = 1.0f - fT, fB = fT;
+
+    // q and -q are the same rotation, pick the one closer to pA so we don't go the long way around
+    if(fDot < 0.0f)
+    {
+        B.x = -B.x; B.y = -B.y; B.z = -B.z; B.w = -B.w;
+        fDot = -fDot;
+    }
+
+    // if they are nearly the same, the sine below gets too small to divide by, but a straight line is fine
+    if(fDot < 0.9995f)
+    {
+        double dTheta = acos(fDot), dSin = sin(dTheta);
+
+        fA = (float)(sin((1.0 - fT) * dTheta) / dSin);
+        fB = (float)(sin(fT * dTheta) / dSin);
+    }
+
+    Out.x = (fA * pA->x) + (fB * B.x);
+    Out.y = (fA * pA->y) + (fB * B.y);
+    Out.z = (fA * pA->z) + (fB * B.z);
+    Out.w = (fA * pA->w) + (fB * B.w);
+
+    // the straight line doesn't stay on the unit sphere, so put it back
+    if(fDot >= 0.9995f)
+    {
+        float fLength = (float)sqrt((Out.x * Out.x) + (Out.y * Out.y) + (Out.z * Out.z) + (Out.w * Out.w));
+        Out.x /= fLength; Out.y /= fLength; Out.z /= fLength; Out.w /= fLength;
+    }
+
+    return Out;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the transform
+/ /     pPosition = where the object is placed
+/ /     pRotation = how the object is turned (must be normalized)
+/ /     fScale = uniform scale of the object
+/ /
+/ / PURPOSE:
+/ /     Builds the object to world transform glTranslatef(), a rotation and glScalef() would make, in that order.
+/*/
+
+void
+ComposeMatrix (PMAT4 pOut, const VEC3 *pPosition, const QUAT *pRotation, float fScale)
+{
+    float *m = pOut->m;
+    float x = pRotation->x, y = pRotation->y, z = pRotation->z, w = pRotation->w;
+
+    // column major, the rotation and scale fill the upper 3x3 and the translation the last column
+    m[0]  = (1.0f - (2.0f * ((y * y) + (z * z)))) * fScale;
+    m[1]  = (2.0f * ((x * y) + (w * z))) * fScale;
+    m[2]  = (2.0f * ((x * z) - (w * y))) * fScale;
+    m[3]  = 0.0f;
+
+    m[4]  = (2.0f * ((x * y) - (w * z))) * fScale;
+    m[5]  = (1.0f - (2.0f * ((x * x) + (z * z)))) * fScale;
+    m[6]  = (2.0f * ((y * z) + (w * x))) * fScale;
+    m[7]  = 0.0f;
+
+    m[8]  = (2.0f * ((x * z) + (w * y))) * fScale;
+    m[9]  = (2.0f * ((y * z) - (w * x))) * fScale;
+    m[10] = (1.0f - (2.0f * ((x * x) + (y * y)))) * fScale;
+    m[11] = 0.0f;
+
+    m[12] = pPosition->x;
+    m[13] = pPosition->y;
+    m[14] = pPosition->z;
+    m[15] = 1.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the product (it may be the same as either of the others)
+/ /     pA, pB = matrices to multiply, the result applies pB first and then pA (like glMultMatrixf() does)
+/ /
+/ / PURPOSE:
+/ /     Multiplies two matrices.
+/*/
+
+void
+MultiplyMatrix (PMAT4 pOut, const MAT4 *pA, const MAT4 *pB)
+{
+    MultiplyMatrices(pOut, pA, pB, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to set
+/ /
+/ / PURPOSE:
+/ /     Sets a matrix to identity, like glLoadIdentity() does.
+/*/
+
+void
+SetIdentity (PMAT4 pOut)
+{
+    memset(pOut, 0, sizeof(MAT4));
+    pOut->m[0] = pOut->m[5] = pOut->m[10] = pOut->m[15] = 1.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the view transform
+/ /     pEye = where the eye is
+/ /     pCenter = point the eye looks at
+/ /     pUp = which way is up (it must not be parallel to the line of sight)
+/ /
+/ / PURPOSE:
+/ /     Builds the same view transform gluLookAt() would.
+/*/
+
+void
+SetLookAt (PMAT4 pOut, const VEC3 *pEye, const VEC3 *pCenter, const VEC3 *pUp)
+{
+    VEC3 Forward, Side, Up;
+    float *m = pOut->m;
+
+    Forward = SubtractVector3(pCenter, pEye);
+    Forward = NormalizeVector3(&Forward);
+    Side = CrossVector3(&Forward, pUp);
+    Side = NormalizeVector3(&Side);
+    Up = CrossVector3(&Side, &Forward);
+
+    m[0] = Side.x;  m[4] = Side.y;  m[8]  = Side.z;  m[12] = -DotVector3(&Side, pEye);
+    m[1] = Up.x;    m[5] = Up.y;    m[9]  = Up.z;    m[13] = -DotVector3(&Up, pEye);
+    m[2] = -Forward.x; m[6] = -Forward.y; m[10] = -Forward.z; m[14] = DotVector3(&Forward, pEye);
+    m[3] = 0.0f;    m[7] = 0.0f;    m[11] = 0.0f;    m[15] = 1.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the projection
+/ /     fFovY = vertical field of view in degrees
+/ /     fAspect = width of the viewport divided by its height
+/ /     fNear, fFar = distance to the near and far clipping planes (both must be positive)
+/ /
+/ / PURPOSE:
+/ /     Builds the same projection gluPerspective() would.
+/*/
+
+void
+SetPerspective (PMAT4 pOut, float fFovY, float fAspect, float fNear, float fFar)
+{
+    float f = (float)(1.0 / tan((fFovY * DEG_TO_RAD) / 2.0));
+
+    memset(pOut, 0, sizeof(MAT4));
+
+    pOut->m[0]  = f / fAspect;
+    pOut->m[5]  = f;
+    pOut->m[10] = (fFar + fNear) / (fNear - fFar);
+    pOut->m[11] = -1.0f;
+    pOut->m[14] = (2.0f * fFar * fNear) / (fNear - fFar);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the rotation
+/ /     fAngle = angle to rotate by in degrees
+/ /     x, y, z = axis to rotate around (it doesn't need to be normalized)
+/ /
+/ / PURPOSE:
+/ /     Builds the same rotation glRotatef() would.
+/*/
+
+void
+SetRotation (PMAT4 pOut, float fAngle, float x, float y, float z)
+{
+    VEC3 Axis = {x, y, z};
+    float c = (float)cos(fAngle * DEG_TO_RAD), s = (float)sin(fAngle * DEG_TO_RAD), t = 1.0f - c;
+    float *m = pOut->m;
+
+    Axis = NormalizeVector3(&Axis);
+    x = Axis.x; y = Axis.y; z = Axis.z;
+
+    m[0] = (x * x * t) + c;        m[4] = (x * y * t) - (z * s);  m[8]  = (x * z * t) + (y * s);  m[12] = 0.0f;
+    m[1] = (y * x * t) + (z * s);  m[5] = (y * y * t) + c;        m[9]  = (y * z * t) - (x * s);  m[13] = 0.0f;
+    m[2] = (x * z * t) - (y * s);  m[6] = (y * z * t) + (x * s);  m[10] = (z * z * t) + c;        m[14] = 0.0f;
+    m[3] = 0.0f;                   m[7] = 0.0f;                   m[11] = 0.0f;                   m[15] = 1.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = matrix to receive the translation
+/ /     x, y, z = distance to move along each axis
+/ /
+/ / PURPOSE:
+/ /     Builds the same translation glTranslatef() would.
+/*/
+
+void
+SetTranslation (PMAT4 pOut, float x, float y, float z)
+{
+    SetIdentity(pOut);
+
+    pOut->m[12] = x;
+    pOut->m[13] = y;
+    pOut->m[14] = z;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = array to receive the products (it may be the same array as pLocal)
+/ /     pParent = matrix every local matrix is multiplied by, from the left
+/ /     pLocal = array of matrices to multiply
+/ /     nCount = number of matrices in the arrays
+/ /
+/ / PURPOSE:
+/ /     Computes pOut[i] = pParent * pLocal[i] for a whole array, e.g. to take a batch of object transforms
+/ /     to world or view space. The parent is kept in registers for the whole batch, and the AVX kernel does
+/ /     two columns per instruction.
+/*/
+
+void
+MultiplyMatrices (PMAT4 pOut, const MAT4 *pParent, const MAT4 *pLocal, unsigned int nCount)
+{
+    unsigned int i = 0;
+    const float *pA = pParent->m;
+
+    #ifdef MATH_SIMD
+
+        if(__mathPath() == MATH_AVX)
+        {
+            // each 128 bit half holds the same column of the parent, so one instruction works on two columns
+            __m256 a0 = _mm256_broadcast_ps((const __m128 *)(pA + 0)), a1 = _mm256_broadcast_ps((const __m128 *)(pA + 4));
+            __m256 a2 = _mm256_broadcast_ps((const __m128 *)(pA + 8)), a3 = _mm256_broadcast_ps((const __m128 *)(pA + 12));
+
+            for(i = 0; i < nCount; i++)
+            {
+                const float *pB = pLocal[i].m;
+                float *pC = pOut[i].m;
+                __m256 b01 = _mm256_loadu_ps(pB), b23 = _mm256_loadu_ps(pB + 8), r01, r23;
+
+                r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+                r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+                r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+                r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+                r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+                r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+                r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+                r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xFF)));
+
+                _mm256_storeu_ps(pC, r01);
+                _mm256_storeu_ps(pC + 8, r23);
+            }
+
+            // avoid the penalty of mixing AVX with SSE code compiled without the VEX encoding
+            _mm256_zeroupper();
+            return;
+        }
+
+        if(__mathPath() == MATH_SSE)
+        {
+            __m128 a0 = _mm_loadu_ps(pA), a1 = _mm_loadu_ps(pA + 4), a2 = _mm_loadu_ps(pA + 8), a3 = _mm_loadu_ps(pA + 12);
+            unsigned int c = 0;
+
+            for(i = 0; i < nCount; i++)
+            {
+                const float *pB = pLocal[i].m;
+                float *pC = pOut[i].m;
+
+                // every column of the product is the parent's columns weighted by the local column
+                for(c = 0; c < 16; c += 4)
+                {
+                    __m128 b = _mm_loadu_ps(pB + c), r;
+
+                    r = _mm_mul_ps(a0, _mm_shuffle_ps(b, b, 0x00));
+                    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(b, b, 0x55)));
+                    r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(b, b, 0xAA)));
+                    r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(b, b, 0xFF)));
+
+                    _mm_storeu_ps(pC + c, r);
+                }
+            }
+
+            return;
+        }
+
+    #endif
+
+    for(i = 0; i < nCount; i++) __multiplyScalar(pOut[i].m, pA, pLocal[i].m);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = array to receive the transformed vectors (it may be the same array as pIn)
+/ /     pMatrix = matrix to transform by
+/ /     pIn = array of vectors to transform
+/ /     nCount = number of vectors in the arrays
+/ /
+/ / PURPOSE:
+/ /     Computes pOut[i] = pMatrix * pIn[i] for a whole array. The AVX kernel does two vectors at a time.
+/*/
+
+void
+TransformVectors (PVEC4 pOut, const MAT4 *pMatrix, const VEC4 *pIn, unsigned int nCount)
+{
+    unsigned int i = 0;
+    const float *pM = pMatrix->m;
+
+    #ifdef MATH_SIMD
+
+        if(__mathPath() == MATH_AVX)
+        {
+            __m256 m0 = _mm256_broadcast_ps((const __m128 *)(pM + 0)), m1 = _mm256_broadcast_ps((const __m128 *)(pM + 4));
+            __m256 m2 = _mm256_broadcast_ps((const __m128 *)(pM + 8)), m3 = _mm256_broadcast_ps((const __m128 *)(pM + 12));
+
+            for(i = 0; (i + 1) < nCount; i += 2)
+            {
+                __m256 v = _mm256_loadu_ps(&pIn[i].x), r;
+
+                r = _mm256_mul_ps(m0, _mm256_permute_ps(v, 0x00));
+                r = _mm256_add_ps(r, _mm256_mul_ps(m1, _mm256_permute_ps(v, 0x55)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(m2, _mm256_permute_ps(v, 0xAA)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(m3, _mm256_permute_ps(v, 0xFF)));
+
+                _mm256_storeu_ps(&pOut[i].x, r);
+            }
+
+            _mm256_zeroupper();
+
+            // an odd one out is left for the SSE kernel below
+        }
+
+        if(__mathPath() >= MATH_SSE)
+        {
+            __m128 m0 = _mm_loadu_ps(pM), m1 = _mm_loadu_ps(pM + 4), m2 = _mm_loadu_ps(pM + 8), m3 = _mm_loadu_ps(pM + 12);
+
+            for(; i < nCount; i++)
+            {
+                __m128 v = _mm_loadu_ps(&pIn[i].x), r;
+
+                r = _mm_mul_ps(m0, _mm_shuffle_ps(v, v, 0x00));
+                r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_shuffle_ps(v, v, 0x55)));
+                r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_shuffle_ps(v, v, 0xAA)));
+                r = _mm_add_ps(r, _mm_mul_ps(m3, _mm_shuffle_ps(v, v, 0xFF)));
+
+                _mm_storeu_ps(&pOut[i].x, r);
+            }
+
+            return;
+        }
+
+    #endif
+
+    for(; i < nCount; i++) __transformScalar(&pOut[i].x, pM, &pIn[i].x);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns which kernels the batch routines are using.
+/*/
+
+MATHPATH
+GetMathPath (void)
+{
+    return __mathPath();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     nPath = kernels the batch routines should use
+/ /
+/ / PURPOSE:
+/ /     Switches the batch routines to other kernels, e.g. to compare them. Returns false if the CPU
+/ /     doesn't support the ones asked for, in which case nothing changes.
+/*/
+
+bool
+SetMathPath (MATHPATH nPath)
+{
+    __mathPath();
+
+    if(nPath > _nBest) return false;
+
+    _nPath = nPath;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     none
+/ /
+/ / PURPOSE:
+/ /     Returns the kernels to use, the first time through it asks the CPU what it supports and picks the
+/ /     fastest. AVX also needs the OS to save the upper halves of the registers, so that is checked too.
+/*/
+
+static MATHPATH
+__mathPath (void)
+{
+    if(_nPath == MATH_PATHS)
+    {
+        _nBest = MATH_SCALAR;
+
+        #ifdef MATH_SIMD
+        {
+            int anInfo[4] = {0};
+
+            __cpuid(anInfo, 1);
+
+            if(anInfo[3] & (1 << 25)) _nBest = MATH_SSE;
+            if((anInfo[2] & (1 << 27)) && (anInfo[2] & (1 << 28)) && ((_xgetbv(0) & 0x06) == 0x06)) _nBest = MATH_AVX;
+        }
+        #endif
+
+        _nPath = _nBest;
+    }
+
+    return _nPath;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = receives the 16 floats of the product (it may be the same as either of the others)
+/ /     pA, pB = the 16 floats of the matrices to multiply
+/ /
+/ / PURPOSE:
+/ /     Plain C matrix product, used when there is no SIMD to be had (and as the reference to compare to).
+/*/
+
+static void
+__multiplyScalar (float *pOut, const float *pA, const float *pB)
+{
+    float afTemp[16];
+    int r = 0, c = 0;
+
+    for(c = 0; c < 4; c++)
+    {
+        for(r = 0; r < 4; r++)
+        {
+            afTemp[(c * 4) + r] = (pA[r] * pB[c * 4]) + (pA[4 + r] * pB[(c * 4) + 1]) +
+                                  (pA[8 + r] * pB[(c * 4) + 2]) + (pA[12 + r] * pB[(c * 4) + 3]);
+        }
+    }
+
+    memcpy(pOut, afTemp, sizeof(afTemp));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*/
+/ / PARAMETERS:
+/ /     pOut = receives the 4 floats of the transformed vector (it may be the same as pV)
+/ /     pM = the 16 floats of the matrix
+/ /     pV = the 4 floats of the vector
+/ /
+/ / PURPOSE:
+/ /     Plain C matrix times vector, used when there is no SIMD to be had.
+/*/
+
+static void
+__transformScalar (float *pOut, const float *pM, const float *pV)
+{
+    float x = pV[0], y = pV[1], z = pV[2], w = pV[3];
+
+    pOut[0] = (pM[0] * x) + (pM[4] * y) + (pM[8]  * z) + (pM[12] * w);
+    pOut[1] = (pM[1] * x) + (pM[5] * y) + (pM[9]  * z) + (pM[13] * w);
+    pOut[2] = (pM[2] * x) + (pM[6] * y) + (pM[10] * z) + (pM[14] * w);
+    pOut[3] = (pM[3] * x) + (pM[7] * y) + (pM[11] * z) + (pM[15] * w);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+#if !defined (VECMATH_H_91B3E5A7_2C48_4D6F_A0E9_58F1D27C3B64_)
+#define VECMATH_H_91B3E5A7_2C48_4D6F_A0E9_58F1D27C3B64_
+
+#pragma once  // in case the compiler supports it
+
+// the SIMD kernels are only built for x86 and x64, anything else uses the scalar ones
+#if defined(_M_IX86) || defined(_M_X64)
+    #define MATH_SIMD
+#endif
+
+// vectors and quaternions, none of these need to be aligned
+typedef struct {float x, y, z;} VEC3, *PVEC3;
+typedef struct {float x, y, z, w;} VEC4, *PVEC4;
+typedef struct {float x, y, z, w;} QUAT, *PQUAT;
+
+// 4x4 matrix, column major (same layout as glLoadMatrixf) so it can be handed to the GL as is
+typedef struct {float m[16];} MAT4, *PMAT4;
+
+// which kernels the batch routines use, the fastest the CPU supports is picked unless told otherwise
+typedef enum {MATH_SCALAR = 0, MATH_SSE, MATH_AVX, MATH_PATHS} MATHPATH;
+#define MATH_PATH_NAMES {_T("scalar"), _T("sse"), _T("avx")}
+
+// vector routines
+VEC3  AddVector3       (const VEC3 *pA, const VEC3 *pB);
+VEC3  CrossVector3     (const VEC3 *pA, const VEC3 *pB);
+float DotVector3       (const VEC3 *pA, const VEC3 *pB);
+VEC3  NormalizeVector3 (const VEC3 *pV);
+VEC3  SubtractVector3  (const VEC3 *pA, const VEC3 *pB);
+
+// quaternion routines
+QUAT  MultiplyQuat     (const QUAT *pA, const QUAT *pB);
+void  SetQuatRotation  (PQUAT pOut, float fAngle, float x, float y, float z);
+QUAT  SlerpQuat        (const QUAT *pA, const QUAT *pB, float fT);
+
+// matrix routines, these are drop-in replacements for the fixed-function matrix calls (angles are in degrees)
+void  ComposeMatrix    (PMAT4 pOut, const VEC3 *pPosition, const QUAT *pRotation, float fScale);
+void  MultiplyMatrix   (PMAT4 pOut, const MAT4 *pA, const MAT4 *pB);
+void  SetIdentity      (PMAT4 pOut);
+void  SetLookAt        (PMAT4 pOut, const VEC3 *pEye, const VEC3 *pCenter, const VEC3 *pUp);
+void  SetPerspective   (PMAT4 pOut, float fFovY, float fAspect, float fNear, float fFar);
+void  SetRotation      (PMAT4 pOut, float fAngle, float x, float y, float z);
+void  SetTranslation   (PMAT4 pOut, float x, float y, float z);
+
+// batch routines, these work through whole arrays with the SIMD kernels
+void  MultiplyMatrices (PMAT4 pOut, const MAT4 *pParent, const MAT4 *pLocal, unsigned int nCount);
+void  TransformVectors (PVEC4 pOut, const MAT4 *pMatrix, const VEC4 *pIn, unsigned int nCount);
+
+MATHPATH GetMathPath   (void);
+bool     SetMathPath   (MATHPATH nPath);
+
+#endif  // VECMATH_H